@@ -12,6 +12,7 @@
 #include <stddef.h>
 
 #include <ext/alloc_traits.h>
+#include <fstream>
 #include <memory>
 #include <tuple>
 #include <utility>
@@ -26,8 +27,10 @@
 #endif
 
 #include "algorithms/global_mincut/dynamic/dynamic_mincut.h"
+#include "algorithms/global_mincut/dynamic/dynamic_mincut_witness.h"
 #include "common/configuration.h"
 #include "common/definitions.h"
+#include "data_structure/compact_cactus.h"
 #include "data_structure/graph_access.h"
 #include "data_structure/mutable_graph.h"
 #include "io/graph_io.h"
@@ -45,7 +48,11 @@ int main(int argn, char** argv) {
     size_t timeout = 3600;
     bool run_static = false;
     bool disable_batching = false;
+    bool witness_only = false;
+    std::string cactus_cache = "";
     cmdl.add_bool('b', "disablebatching", disable_batching, "disable batching");
+    cmdl.add_string('c', "cactus_cache", cactus_cache,
+                    "binary cactus file, loaded if it exists, written otherwise");
     cmdl.add_string('i', "initial_graph", initial_graph, "path to graph file");
     cmdl.add_string('d', "dynamic_edges", dynamic_edges, "path to edge list");
     cmdl.add_bool('m', "most_balaned", cfg->find_most_balanced_cut,
@@ -58,6 +65,8 @@ int main(int argn, char** argv) {
     cmdl.add_bool('s', "static", run_static, "run static algorithm");
     cmdl.add_size_t('t', "timeout", timeout, "timeout in seconds");
     cmdl.add_flag('v', "verbose", cfg->verbose, "more verbose logs");
+    cmdl.add_bool('w', "witness_only", witness_only,
+                  "only maintain minimum cut value and one witness cut");
 
     if (!cmdl.process(argn, argv))
         return -1;
@@ -168,9 +177,62 @@ int main(int argn, char** argv) {
             LOG1 << "at end, cut " << current_cut;
             cutchange++;
         }
+    } else if (witness_only) {
+        dynamic_mincut_witness dynmc;
+        EdgeWeight previous_cut = dynmc.initialize(G);
+        EdgeWeight current_cut = 0;
+        EdgeID previous_timestamp = std::get<3>(tempEdges[0]);
+        // insertions are only revalidated when the cut is queried at the
+        // end of a batch (or before a deletion, which revalidates itself)
+        bool queryCut = false;
+        for (auto [s, t, w, timestamp] : tempEdges) {
+            if (run_timer.elapsed() > timeout) {
+                timedOut = true;
+                break;
+            }
+            if ((timestamp != previous_timestamp || disable_batching)
+                && queryCut) {
+                queryCut = false;
+                current_cut = dynmc.getCurrentCut();
+                if (current_cut != previous_cut) {
+                    previous_cut = current_cut;
+                    cutchange++;
+                }
+            }
+            previous_timestamp = timestamp;
+            ctr++;
+            if (s == t) continue;
+            if (w > 0) {
+                inserts++;
+                dynmc.addEdge(s, t, w);
+                queryCut = true;
+            } else {
+                deletes++;
+                queryCut = false;
+                current_cut = dynmc.removeEdge(s, t);
+                if (current_cut != previous_cut) {
+                    previous_cut = current_cut;
+                    cutchange++;
+                }
+            }
+        }
+        if (queryCut && dynmc.getCurrentCut() != previous_cut) {
+            cutchange++;
+        }
+        staticruns = dynmc.getCallsOfStaticAlgorithm();
+        LOG1 << "c " << dynmc.getCurrentCut();
     } else {
         dynamic_mincut dynmc;
-        EdgeWeight previous_cut = dynmc.initialize(G);
+        EdgeWeight previous_cut;
+        if (cactus_cache != "" && std::ifstream(cactus_cache).good()) {
+            previous_cut = dynmc.initialize(
+                G, compact_cactus::readBinary(cactus_cache));
+        } else {
+            previous_cut = dynmc.initialize(G);
+            if (cactus_cache != "") {
+                dynmc.getCompactCactus()->writeBinary(cactus_cache);
+            }
+        }
         EdgeWeight current_cut = 0;
         for (auto [s, t, w, timestamp] : tempEdges) {
             if (run_timer.elapsed() > timeout) {
@@ -0,0 +1,383 @@
+/******************************************************************************
+ * dynamic_replay.cpp
+ *
+ * Source of VieCut
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <stddef.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef PARALLEL
+#include "parallel/algorithm/exact_parallel_minimum_cut.h"
+#else
+#include "algorithms/global_mincut/noi_minimum_cut.h"
+#endif
+
+#include "algorithms/global_mincut/dynamic/dynamic_mincut.h"
+#include "algorithms/global_mincut/dynamic/dynamic_mincut_witness.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "io/graph_io.h"
+#include "tlx/cmdline_parser.hpp"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+using namespace VieCut;
+
+typedef std::vector<std::tuple<NodeID, NodeID, int64_t, uint64_t> >
+    temporal_edges;
+
+struct latency_stats {
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    double total = 0.0;
+    size_t count = 0;
+
+    explicit latency_stats(std::vector<double> latencies) {
+        count = latencies.size();
+        if (count == 0)
+            return;
+        std::sort(latencies.begin(), latencies.end());
+        p50 = latencies[(count - 1) / 2];
+        p99 = latencies[((count - 1) * 99) / 100];
+        max = latencies.back();
+        for (double l : latencies) {
+            total += l;
+        }
+    }
+};
+
+struct replay_result {
+    std::vector<double> dynamic_latencies;
+    std::vector<double> static_latencies;
+    size_t static_calls_dynamic = 0;
+    size_t batches = 0;
+    size_t inserts = 0;
+    size_t deletes = 0;
+    size_t cutchange = 0;
+    size_t mismatches = 0;
+    size_t max_cactus = 0;
+    size_t final_cactus = 0;
+    EdgeWeight initial_cut = 0;
+    EdgeWeight final_cut = 0;
+    double initialize_time = 0.0;
+    bool timedOut = false;
+};
+
+static mutableGraphPtr createGraph(const std::string& initial_graph,
+                                   NodeID numV) {
+    if (initial_graph == "") {
+        mutableGraphPtr G = std::make_shared<mutable_graph>();
+        G->start_construction(numV);
+        G->finish_construction();
+        return G;
+    } else {
+        return graph_io::readGraphWeighted<mutable_graph>(initial_graph);
+    }
+}
+
+static void removeEdge(mutableGraphPtr G, NodeID s, NodeID t) {
+    for (EdgeID e : G->edges_of(s)) {
+        if (G->getEdgeTarget(s, e) == t) {
+            G->deleteEdge(s, e);
+            return;
+        }
+    }
+}
+
+static size_t peakRSS() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // ru_maxrss is given in kilobytes on linux
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+// replays a temporal edge list with the dynamic minimum cut algorithm and
+// the static baseline side by side. a batch consists of all consecutive
+// edges with the same timestamp (or a single edge if batching is
+// disabled). after each batch, the minimum cut is queried and compared to
+// the static baseline
+template <class DynamicAlgorithm>
+replay_result replay(const temporal_edges& edges, mutableGraphPtr G,
+                     mutableGraphPtr G_static, bool run_static,
+                     bool disable_batching, size_t timeout) {
+    replay_result r;
+    DynamicAlgorithm dynmc;
+#ifdef PARALLEL
+    exact_parallel_minimum_cut<mutableGraphPtr> static_alg;
+#else
+    noi_minimum_cut<mutableGraphPtr> static_alg;
+#endif
+    constexpr bool has_cactus =
+        std::is_same<DynamicAlgorithm, dynamic_mincut>::value;
+
+    timer run_timer;
+    timer t;
+    r.initial_cut = dynmc.initialize(G);
+    r.initialize_time = t.elapsed();
+    EdgeWeight previous_cut = r.initial_cut;
+    size_t batch_end = 0;
+
+    if (run_static) {
+        static_alg.perform_minimum_cut(G_static);
+    }
+
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (run_timer.elapsed() > timeout) {
+            r.timedOut = true;
+            break;
+        }
+        auto [s, tgt, w, timestamp] = edges[i];
+        bool batch_ends = disable_batching || i + 1 == edges.size()
+                          || std::get<3>(edges[i + 1]) != timestamp;
+
+        t.restart();
+        if (s != tgt) {
+            if (w > 0) {
+                r.inserts++;
+                dynmc.addEdge(s, tgt, w);
+            } else {
+                r.deletes++;
+                dynmc.removeEdge(s, tgt);
+            }
+        }
+
+        if (!batch_ends) {
+            r.dynamic_latencies.emplace_back(t.elapsed());
+            continue;
+        }
+
+        EdgeWeight current_cut = dynmc.getCurrentCut();
+        r.dynamic_latencies.emplace_back(t.elapsed());
+        r.batches++;
+        size_t batch_start = batch_end;
+        batch_end = i + 1;
+        if (current_cut != previous_cut) {
+            previous_cut = current_cut;
+            r.cutchange++;
+        }
+
+        if constexpr (has_cactus) {
+            r.max_cactus = std::max<size_t>(r.max_cactus,
+                                    dynmc.getCurrentCactus()->n());
+        }
+
+        if (run_static) {
+            for (size_t j = batch_start; j <= i; ++j) {
+                auto [ss, st, sw, stime] = edges[j];
+                if (ss == st) continue;
+                if (sw > 0) {
+                    G_static->new_edge_order(ss, st, sw);
+                } else {
+                    removeEdge(G_static, ss, st);
+                }
+            }
+            t.restart();
+            EdgeWeight static_cut = static_alg.perform_minimum_cut(G_static);
+            r.static_latencies.emplace_back(t.elapsed());
+            if (static_cut != current_cut) {
+                LOG1 << "Error: dynamic cut " << current_cut
+                     << " differs from static cut " << static_cut
+                     << " after edge " << i;
+                r.mismatches++;
+            }
+        }
+    }
+
+    r.final_cut = dynmc.getCurrentCut();
+    r.static_calls_dynamic = dynmc.getCallsOfStaticAlgorithm();
+    if constexpr (has_cactus) {
+        r.final_cactus = dynmc.getCurrentCactus()->n();
+        r.max_cactus = std::max<size_t>(r.max_cactus, r.final_cactus);
+    }
+    return r;
+}
+
+// string as json value, quotes and backslashes are escaped
+static std::string jsonString(const std::string& str) {
+    std::string value = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            value += '\\';
+        }
+        value += c;
+    }
+    return value + "\"";
+}
+
+static void writeJSON(std::ostream& out,
+                      const std::vector<std::pair<std::string,
+                                                  std::string> >& fields) {
+    out << "{";
+    for (size_t i = 0; i < fields.size(); ++i) {
+        out << (i > 0 ? ", " : "") << "\"" << fields[i].first << "\": "
+            << fields[i].second;
+    }
+    out << "}" << std::endl;
+}
+
+static void writeCSV(const std::string& filename,
+                     const std::vector<std::pair<std::string,
+                                                 std::string> >& fields) {
+    bool exists = std::ifstream(filename).good();
+    std::ofstream out(filename, std::ios::app);
+    if (!out) {
+        LOG1 << "Error: could not open " << filename << " for writing";
+        exit(1);
+    }
+    if (!exists) {
+        for (size_t i = 0; i < fields.size(); ++i) {
+            out << (i > 0 ? "," : "") << fields[i].first;
+        }
+        out << std::endl;
+    }
+    for (size_t i = 0; i < fields.size(); ++i) {
+        std::string value = fields[i].second;
+        if (value.size() >= 2 && value[0] == '"') {
+            // json string, written as quoted csv field (RFC 4180), i.e.
+            // without json escapes and with embedded quotes doubled
+            std::string str = "\"";
+            for (size_t c = 1; c + 1 < value.size(); ++c) {
+                if (value[c] == '\\') {
+                    ++c;
+                }
+                if (value[c] == '"') {
+                    str += '"';
+                }
+                str += value[c];
+            }
+            value = str + "\"";
+        }
+        out << (i > 0 ? "," : "") << value;
+    }
+    out << std::endl;
+}
+
+int main(int argn, char** argv) {
+    tlx::CmdlineParser cmdl;
+    auto cfg = configuration::getConfig();
+    std::string initial_graph = "";
+    std::string dynamic_edges = "";
+    std::string json_file = "";
+    std::string csv_file = "";
+    size_t timeout = 3600;
+    bool disable_batching = false;
+    bool no_static = false;
+    bool witness_only = false;
+    cmdl.add_bool('b', "disablebatching", disable_batching, "disable batching");
+    cmdl.add_string('c', "csv", csv_file, "append result row to csv file");
+    cmdl.add_string('d', "dynamic_edges", dynamic_edges, "path to edge list");
+    cmdl.add_string('i', "initial_graph", initial_graph, "path to graph file");
+    cmdl.add_string('j', "json", json_file, "write result as json to file");
+    cmdl.add_bool('n', "no_static", no_static, "do not run static baseline");
+#ifdef PARALLEL
+    size_t procs = 1;
+    cmdl.add_size_t('p', "proc", procs, "number of processes");
+#endif
+    cmdl.add_size_t('r', "seed", cfg->seed, "random seed");
+    cmdl.add_size_t('t', "timeout", timeout, "timeout in seconds");
+    cmdl.add_flag('v', "verbose", cfg->verbose, "more verbose logs");
+    cmdl.add_bool('w', "witness_only", witness_only,
+                  "only maintain minimum cut value and one witness cut");
+
+    if (!cmdl.process(argn, argv))
+        return -1;
+
+    if (dynamic_edges == "") {
+        LOG1 << "ERROR: No list of dynamic edges given! Use parameter -d!";
+        exit(1);
+    }
+
+    random_functions::setSeed(cfg->seed);
+    cfg->save_cut = true;
+#ifdef PARALLEL
+    omp_set_num_threads(procs);
+#endif
+
+    auto [numV, tempEdges] = graph_io::readTemporalGraph(dynamic_edges);
+    mutableGraphPtr G = createGraph(initial_graph, numV);
+    mutableGraphPtr G_static;
+    if (!no_static) {
+        G_static = createGraph(initial_graph, numV);
+    }
+    size_t initialNumEdges = G->m();
+
+    timer run_timer;
+    replay_result r;
+    if (witness_only) {
+        r = replay<dynamic_mincut_witness>(tempEdges, G, G_static, !no_static,
+                                           disable_batching, timeout);
+    } else {
+        r = replay<dynamic_mincut>(tempEdges, G, G_static, !no_static,
+                                   disable_batching, timeout);
+    }
+    double time = run_timer.elapsed();
+
+    latency_stats dyn(r.dynamic_latencies);
+    latency_stats stat(r.static_latencies);
+
+    std::string graph = initial_graph == "" ? dynamic_edges : initial_graph;
+    std::vector<std::pair<std::string, std::string> > fields = {
+        { "graph", jsonString(graph) },
+        { "mode", witness_only ? "\"witness\"" : "\"cactus\"" },
+        { "n", std::to_string(G->n()) },
+        { "initialm", std::to_string(initialNumEdges / 2) },
+        { "updates", std::to_string(r.dynamic_latencies.size()) },
+        { "insert", std::to_string(r.inserts) },
+        { "delete", std::to_string(r.deletes) },
+        { "batches", std::to_string(r.batches) },
+        { "timedOut", r.timedOut ? "true" : "false" },
+        { "time", std::to_string(time) },
+        { "initial_cut", std::to_string(r.initial_cut) },
+        { "final_cut", std::to_string(r.final_cut) },
+        { "cutchange", std::to_string(r.cutchange) },
+        { "initialize_time", std::to_string(r.initialize_time) },
+        { "dynamic_total", std::to_string(dyn.total) },
+        { "dynamic_p50_us", std::to_string(1e6 * dyn.p50) },
+        { "dynamic_p99_us", std::to_string(1e6 * dyn.p99) },
+        { "dynamic_max_us", std::to_string(1e6 * dyn.max) },
+        { "runs_static_alg", std::to_string(r.static_calls_dynamic) },
+        { "max_cactus", std::to_string(r.max_cactus) },
+        { "final_cactus", std::to_string(r.final_cactus) },
+        { "static_runs", std::to_string(stat.count) },
+        { "static_total", std::to_string(stat.total) },
+        { "static_p50_us", std::to_string(1e6 * stat.p50) },
+        { "static_p99_us", std::to_string(1e6 * stat.p99) },
+        { "static_max_us", std::to_string(1e6 * stat.max) },
+        { "mismatches", std::to_string(r.mismatches) },
+        { "peak_rss", std::to_string(peakRSS()) },
+        { "seed", std::to_string(cfg->seed) }
+    };
+
+    writeJSON(std::cout, fields);
+    if (json_file != "") {
+        std::ofstream out(json_file);
+        if (!out) {
+            LOG1 << "Error: could not open " << json_file << " for writing";
+            exit(1);
+        }
+        writeJSON(out, fields);
+    }
+    if (csv_file != "") {
+        writeCSV(csv_file, fields);
+    }
+
+    return r.mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+/******************************************************************************
+ * expander_decomposition.cpp
+ *
+ * Source of VieCut
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "algorithms/global_mincut/minimum_cut_helpers.h"
+#include "algorithms/global_mincut/viecut.h"
+#include "coarsening/contract_graph.h"
+#include "coarsening/expander_decomposition.h"
+#include "coarsening/label_propagation.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "io/graph_io.h"
+#include "tlx/cmdline_parser.hpp"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+using namespace VieCut;
+
+typedef mutableGraphPtr GraphPtr;
+
+int main(int argn, char** argv) {
+    tlx::CmdlineParser cmdl;
+    auto cfg = configuration::getConfig();
+    std::string output_path = "";
+    bool compare_mincut = false;
+
+    cmdl.add_param_string("graph", cfg->graph_filename, "path to graph file");
+    cmdl.add_double('p', "phi", cfg->expander_phi,
+                    "conductance parameter");
+    cmdl.add_size_t('r', "seed", cfg->seed, "random seed");
+    cmdl.add_string('o', "output", output_path,
+                    "write cluster id of every vertex to file");
+    cmdl.add_flag('m', "mincut", compare_mincut,
+                  "run viecut with and without expander coarsening");
+
+    if (!cmdl.process(argn, argv))
+        return -1;
+
+    random_functions::setSeed(cfg->seed);
+    GraphPtr G = graph_io::readGraphWeighted<mutable_graph>(
+        cfg->graph_filename);
+
+    timer t;
+    label_propagation<GraphPtr> lp;
+    NodeID lp_clusters =
+        expander_decomposition<GraphPtr>::countClusters(
+            lp.propagate_labels(G));
+    double lp_time = t.elapsedToZero();
+
+    expander_decomposition<GraphPtr> ed;
+    std::vector<NodeID> clusters = ed.decompose(G);
+    double ed_time = t.elapsedToZero();
+
+    auto [mapping, reverse_mapping] =
+        minimum_cut_helpers<GraphPtr>::remap_cluster(G, clusters);
+    GraphPtr H = contraction::contractGraph(G, mapping, reverse_mapping);
+
+    LOG1 << "RESULT graph=" << cfg->graph_filename
+         << " n=" << G->number_of_nodes()
+         << " m=" << G->number_of_edges()
+         << " phi=" << cfg->expander_phi
+         << " clusters=" << ed.numClusters()
+         << " trimmed=" << ed.numTrimmed()
+         << " dissolved=" << ed.numDissolved()
+         << " contracted_n=" << H->number_of_nodes()
+         << " contracted_m=" << H->number_of_edges()
+         << " lp_n=" << lp_clusters
+         << " time=" << ed_time
+         << " lp_time=" << lp_time;
+
+    if (output_path != "") {
+        graph_io io;
+        io.writeVector(clusters, output_path);
+    }
+
+    if (compare_mincut) {
+        for (bool expander : { false, true }) {
+            cfg->expander_coarsening = expander;
+            random_functions::setSeed(cfg->seed);
+            viecut<GraphPtr> vc;
+            t.restart();
+            EdgeWeight cut = vc.perform_minimum_cut(G);
+            LOG1 << "RESULT viecut expander_coarsening=" << expander
+                 << " cut=" << cut << " time=" << t.elapsed();
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/******************************************************************************
+ * gomory_hu.cpp
+ *
+ * Source of VieCut
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <omp.h>
+
+#include <string>
+#include <vector>
+
+#include "algorithms/flow/gomory_hu_tree.h"
+#include "algorithms/global_mincut/noi_minimum_cut.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "io/graph_io.h"
+#include "tlx/cmdline_parser.hpp"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+using namespace VieCut;
+
+int main(int argn, char** argv) {
+    tlx::CmdlineParser cmdl;
+    auto cfg = configuration::getConfig();
+    size_t procs = 1;
+    std::string output_path = "";
+    std::vector<std::string> queries;
+    bool validate = false;
+
+    cmdl.add_param_string("graph", cfg->graph_filename, "path to graph file");
+    cmdl.add_size_t('p', "proc", procs, "number of threads");
+    cmdl.add_string('o', "output", output_path,
+                    "write tree to file (METIS format)");
+    cmdl.add_stringlist('q', "query", queries,
+                        "print connectivity of vertex pair u,v");
+    cmdl.add_flag('c', "check", validate,
+                  "compare minimum cut to noi_minimum_cut");
+    cmdl.add_size_t('r', "seed", cfg->seed, "random seed");
+
+    if (!cmdl.process(argn, argv))
+        return -1;
+
+    random_functions::setSeed(cfg->seed);
+    omp_set_num_threads(procs);
+    cfg->threads = procs;
+
+    timer t;
+    mutableGraphPtr G = graph_io::readGraphWeighted<mutable_graph>(
+        cfg->graph_filename);
+    LOG1 << "io time: " << t.elapsedToZero();
+
+    gomory_hu_tree gh;
+    gh.build(G);
+    double time = t.elapsedToZero();
+
+    LOG1 << "RESULT graph=" << cfg->graph_filename
+         << " n=" << G->n() << " m=" << G->m()
+         << " threads=" << procs
+         << " flows=" << gh.getFlows()
+         << " recomputed=" << gh.getRecomputed()
+         << " mincut=" << gh.minimumCut()
+         << " time=" << time;
+
+    for (const std::string& query : queries) {
+        size_t comma = query.find(',');
+        NodeID u = 0;
+        NodeID v = 0;
+        try {
+            u = std::stoul(query.substr(0, comma));
+            v = std::stoul(query.substr(comma + 1));
+        } catch (...) {
+            LOG1 << "Query " << query << " is not of the form u,v";
+            exit(1);
+        }
+
+        if (comma == std::string::npos || u >= G->n() || v >= G->n()) {
+            LOG1 << "Query " << query << " is not a valid vertex pair";
+            exit(1);
+        }
+        LOG1 << "connectivity " << u << " " << v << ": "
+             << gh.connectivity(u, v);
+    }
+
+    if (output_path != "") {
+        graph_io::writeGraphWeighted(gh.getTree(), output_path);
+    }
+
+    if (validate) {
+        noi_minimum_cut<mutableGraphPtr> noi;
+        EdgeWeight cut = noi.perform_minimum_cut(G);
+        if (static_cast<FlowType>(cut) != gh.minimumCut()) {
+            LOG1 << "Error: noi_minimum_cut found cut " << cut
+                 << " but tree has minimum edge " << gh.minimumCut();
+            exit(1);
+        }
+        LOG1 << "minimum cut " << cut << " matches noi_minimum_cut";
+    }
+}
@@ -69,10 +69,19 @@ int main(int argn, char** argv) {
     cmdl.add_string('o', "output_path", cfg->output_path,
                     "print minimum cut to file");
     cmdl.add_flag('v', "verbose", cfg->verbose, "more verbose logs");
+    cmdl.add_flag('E', "expander_coarsening", cfg->expander_coarsening,
+                  "use expander decomposition if label propagation fails");
+    cmdl.add_double('P', "expander_phi", cfg->expander_phi,
+                    "conductance parameter of expander decomposition");
+    cmdl.add_double('T', "expander_threshold", cfg->expander_threshold,
+                    "use expander decomposition if label propagation "
+                    "leaves more than this fraction of vertices");
     cmdl.add_string('e', "edge_select", cfg->edge_selection, "NNI edge select");
     cmdl.add_size_t('r', "seed", cfg->seed, "random seed");
     cmdl.add_string('t', "cactus_filename", cfg->cactus_filename,
                     "name of GraphML file for the cactus graph");
+    cmdl.add_string('x', "cactus_binary_filename", cfg->cactus_binary_filename,
+                    "name of binary file for the compact cactus graph");
 
     if (!cmdl.process(argn, argv))
         return -1;
@@ -82,7 +91,7 @@ int main(int argn, char** argv) {
         cfg->find_most_balanced_cut = true;
     }
 
-    if (cfg->cactus_filename != "" ) {
+    if (cfg->cactus_filename != "" || cfg->cactus_binary_filename != "") {
         // need save_cut to properly maintain containedVertices, see https://github.com/VieCut/VieCut/issues/7
 	cfg->save_cut = true;
     }
@@ -46,20 +46,33 @@ int main(int argn, char** argv) {
     cmdl.add_size_t('c', "contraction_depth_around_terminals",
                     config->contractionDepthAroundTerminal,
                     "Contract vertices close to heaviest terminal [only -X]");
+    cmdl.add_string('C', "checkpoint_file", config->checkpoint_file,
+                    "Periodically checkpoint the search to this file");
     cmdl.add_flag('d', "disable_cpu_affinity", config->disable_cpu_affinity,
                   "Default CPU affinity (i.e. let the OS decide where to run)");
     cmdl.add_int('D', "distant_terminals", config->distant_terminals,
                  "Use terminals with high distance from each other");
     cmdl.add_string('e', "edge_selection", config->edge_selection,
                     "edge selection rule");
+    cmdl.add_string('F', "flow_algorithm", config->flow_algorithm,
+                    "flow algorithm (push_relabel, parallel_push_relabel, "
+                    "boykov_kolmogorov, auto)");
     cmdl.add_string('f', "partition_file", config->partition_file,
                     "Partition file");
+    cmdl.add_double('I', "checkpoint_interval", config->checkpoint_interval,
+                    "Seconds between checkpoints");
     cmdl.add_flag('i', "use_ilp", config->use_ilp, "Use ILP");
     cmdl.add_double('l', "removeTerminalsBeforeBranch",
                     config->removeTerminalsBeforeBranch,
                     "Remove low degree terminals before branch [only -X]");
+    cmdl.add_string('L', "local_search", config->local_search_algorithm,
+                    "local search (fm, parallel_fm, gain)");
     cmdl.add_int('k', "top_k", config->top_k,
                  "multiterminal cut between top k vertices (invalidates t)");
+    cmdl.add_size_t('M', "memory_budget", config->memory_budget,
+                    "Memory for open problems [MB], 0 = half of the RAM");
+    cmdl.add_size_t('m', "max_mapping_depth", config->maxMappingDepth,
+                    "compose deeper vertex mappings (0 = never)");
     cmdl.add_double('n', "preset_percentage", config->preset_percentage,
                     "percentag of vertices that are preset");
     cmdl.add_string('o', "first_branch_path", config->first_branch_path,
@@ -69,11 +82,16 @@ int main(int argn, char** argv) {
                     "Type of priority queue used");
     cmdl.add_int('r', "random_k", config->random_k,
                  "multiterminal cut between k random vertices");
+    cmdl.add_flag('R', "resume", config->resume,
+                  "Resume the search from checkpoint_file");
+    cmdl.add_string('S', "scratch_directory", config->scratch_directory,
+                    "Directory for problems beyond the memory budget");
     cmdl.add_size_t('s', "seed", config->seed, "random seed");
     cmdl.add_stringlist('t', "terminal", config->term_strings,
                         "add terminal vertex");
     cmdl.add_size_t('T', "maxtime", config->timeoutSeconds,
                     "Timeout after [s]");
+    cmdl.add_flag('v', "verbose", config->verbose, "more verbose logs");
     cmdl.add_flag('w', "write_solution", config->write_solution,
                   "Print best solution");
     cmdl.add_flag('X', "inexact", config->inexact, "Apply inexact heuristics");
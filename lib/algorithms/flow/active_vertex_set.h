@@ -0,0 +1,251 @@
+/******************************************************************************
+ * active_vertex_set.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "common/definitions.h"
+#include "data_structure/priority_queues/maxNodeHeap.h"
+
+namespace VieCut {
+    // Number of vertices with each distance label in push_relabel. A label
+    // that is about to lose its last vertex is a gap, all vertices above it
+    // can not reach a sink anymore.
+    class label_counts {
+     public:
+        int count(size_t label) const {
+            return m_count[label];
+        }
+
+        // whether a vertex with this label is the only one
+        bool isGap(size_t label) const {
+            return m_count[label] == 1;
+        }
+
+        void setCount(size_t label, int count) {
+            m_count[label] = count;
+        }
+
+        void addLabel(size_t label) {
+            m_count[label]++;
+        }
+
+        // can be called in parallel
+        void atomicAddLabel(size_t label) {
+            __sync_fetch_and_add(&m_count[label], 1);
+        }
+
+        void moveLabel(size_t from, size_t to) {
+            m_count[from]--;
+            m_count[to]++;
+        }
+
+        void clearCounts() {
+            std::fill(m_count.begin(), m_count.begin() + m_num_labels, 0);
+        }
+
+     protected:
+        // vectors might be larger from previous calls on larger graphs,
+        // only the first num_labels entries are used
+        void resetCounts(size_t num_labels) {
+            m_num_labels = num_labels;
+            if (m_count.size() < num_labels) {
+                m_count.resize(num_labels, 0);
+            }
+            clearCounts();
+        }
+
+        size_t m_num_labels = 0;
+        std::vector<int> m_count;
+    };
+
+    // Active vertices of push_relabel in an array of buckets, one singly
+    // linked list per key. Insertion pushes to the front of the list of the
+    // key, deleteMax pops from the highest non-empty bucket.
+    //
+    // Relabeled vertices often jump from a small label to a label above n,
+    // so a linear scan down to the next non-empty bucket can take O(n) time
+    // after such a vertex is extracted. Instead, non-empty buckets are
+    // marked in a bit vector with one summary bit per word, so the highest
+    // non-empty bucket is found in O(n / 4096) time in the worst case and
+    // in O(1) if it is close to the previous one.
+    //
+    // Keys are not updated when the label of a vertex changes while it is in
+    // the set (global relabeling, gap heuristic), it is extracted with its
+    // key at insertion. This is the same as with a heap that is not updated.
+    class highest_label_buckets : public label_counts {
+     public:
+        // clears the set for vertices [0, n) and keys [0, num_labels)
+        void reset(NodeID n, size_t num_labels) {
+            if (m_next.size() < n) {
+                m_next.resize(n);
+            }
+            if (m_head.size() < num_labels) {
+                m_head.resize(num_labels);
+            }
+            std::fill(m_next.begin(), m_next.begin() + n, NOT_CONTAINED);
+            std::fill(m_head.begin(), m_head.begin() + num_labels,
+                      END_OF_LIST);
+            size_t words = num_labels / 64 + 1;
+            size_t summary_words = words / 64 + 1;
+            if (m_nonempty.size() < words) {
+                m_nonempty.resize(words);
+                m_summary.resize(summary_words);
+            }
+            std::fill(m_nonempty.begin(), m_nonempty.begin() + words, 0);
+            std::fill(m_summary.begin(), m_summary.begin() + summary_words, 0);
+            m_max = 0;
+            m_size = 0;
+            resetCounts(num_labels);
+        }
+
+        // vertex is never inserted until the next reset, e.g. terminals
+        void block(NodeID v) {
+            m_next[v] = BLOCKED;
+        }
+
+        // whether v is in the set or blocked
+        bool contains(NodeID v) const {
+            return m_next[v] != NOT_CONTAINED;
+        }
+
+        void insert(NodeID v, size_t key) {
+            if (m_head[key] == END_OF_LIST) {
+                m_nonempty[key / 64] |= bit(key % 64);
+                m_summary[key / 4096] |= bit((key / 64) % 64);
+            }
+            m_next[v] = m_head[key];
+            m_head[key] = v;
+            m_max = std::max(m_max, key);
+            m_size++;
+        }
+
+        NodeID deleteMax() {
+            if (m_head[m_max] == END_OF_LIST) {
+                m_max = highestNonEmpty(m_max);
+            }
+            NodeID v = m_head[m_max];
+            m_head[m_max] = m_next[v];
+            m_next[v] = NOT_CONTAINED;
+            m_size--;
+            if (m_head[m_max] == END_OF_LIST) {
+                size_t word = m_max / 64;
+                m_nonempty[word] &= ~bit(m_max % 64);
+                if (m_nonempty[word] == 0) {
+                    m_summary[word / 64] &= ~bit(word % 64);
+                }
+            }
+            return v;
+        }
+
+        bool empty() const {
+            return m_size == 0;
+        }
+
+        NodeID size() const {
+            return m_size;
+        }
+
+     private:
+        static uint64_t bit(size_t i) {
+            return static_cast<uint64_t>(1) << i;
+        }
+
+        // highest set bit in word that is smaller than position i
+        static size_t highestBelow(uint64_t word, size_t i) {
+            word &= bit(i) - 1;
+            if (word == 0)
+                return 64;
+            return 63 - __builtin_clzll(word);
+        }
+
+        // highest non-empty bucket below key, there has to be one
+        size_t highestNonEmpty(size_t key) {
+            size_t word = key / 64;
+            size_t pos = highestBelow(m_nonempty[word], key % 64);
+            if (pos < 64)
+                return word * 64 + pos;
+
+            size_t summary_word = word / 64;
+            pos = highestBelow(m_summary[summary_word], word % 64);
+            while (pos == 64) {
+                summary_word--;
+                pos = m_summary[summary_word] == 0
+                      ? 64 : 63 - __builtin_clzll(m_summary[summary_word]);
+            }
+            word = summary_word * 64 + pos;
+            return word * 64 + 63 - __builtin_clzll(m_nonempty[word]);
+        }
+
+        static constexpr NodeID NOT_CONTAINED = UNDEFINED_NODE;
+        static constexpr NodeID BLOCKED = UNDEFINED_NODE - 1;
+        static constexpr NodeID END_OF_LIST = UNDEFINED_NODE - 2;
+
+        // next vertex in the bucket of v, or one of the markers above
+        std::vector<NodeID> m_next;
+        std::vector<NodeID> m_head;
+        // bit i is set if bucket i is not empty
+        std::vector<uint64_t> m_nonempty;
+        // bit i is set if word i of m_nonempty is not 0
+        std::vector<uint64_t> m_summary;
+        // upper bound of the highest non-empty key
+        size_t m_max = 0;
+        NodeID m_size = 0;
+    };
+
+    // Same interface as highest_label_buckets with the binary heap and flag
+    // vector that push_relabel used before, for comparison
+    class heap_active_set : public label_counts {
+     public:
+        void reset(NodeID n, size_t num_labels) {
+            if (m_contained.size() < n) {
+                m_contained.resize(n);
+            }
+            std::fill(m_contained.begin(), m_contained.begin() + n, false);
+            m_heap.reset();
+            resetCounts(num_labels);
+        }
+
+        void block(NodeID v) {
+            m_contained[v] = true;
+        }
+
+        bool contains(NodeID v) const {
+            return m_contained[v];
+        }
+
+        void insert(NodeID v, size_t key) {
+            m_contained[v] = true;
+            m_heap.insert(v, key);
+        }
+
+        NodeID deleteMax() {
+            NodeID v = m_heap.deleteMax();
+            m_contained[v] = false;
+            return v;
+        }
+
+        bool empty() {
+            return m_heap.empty();
+        }
+
+        NodeID size() {
+            return m_heap.size();
+        }
+
+     private:
+        std::vector<bool> m_contained;
+        maxNodeHeap m_heap;
+    };
+}
@@ -0,0 +1,319 @@
+/******************************************************************************
+ * bounded_flow.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "algorithms/flow/flow_statistics.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+
+namespace VieCut {
+    // Answers queries of the form "is the connectivity between a source and
+    // a set of sinks at least k?" by routing flow along augmenting paths
+    // until k units are routed or no augmenting path is left.
+    //
+    // Each path is found by a depth-first search in the residual graph,
+    // which stops as soon as a sink is reached. Flows are stored in the
+    // graph with the problem id of the query, which resets stale flows
+    // lazily, and vertex marks are timestamps. Thus, no array of size n or
+    // m is reset and the work of a query that reaches k only depends on the
+    // parts of the graph explored by its k (or less) augmenting paths. This
+    // is intended for checks where k is small, e.g. whether a deleted edge
+    // decreases the minimum cut in dynamic_mincut. For large flow values
+    // push_relabel is faster.
+    //
+    // If less than k units can be routed, the result is the maximum flow
+    // value, the flow stored in the graph is a maximum flow and the vertices
+    // reached by the last search are the source side of a minimum cut.
+    // A single object should be used for many queries, as it keeps its
+    // workspace between them.
+    class bounded_flow {
+     public:
+        static constexpr bool debug = false;
+
+        bounded_flow() : m_source(0),
+                         m_problem_id(0),
+                         m_search(0),
+                         m_query(0),
+                         m_augmentations(0),
+                         m_work(0) { }
+        ~bounded_flow() { }
+
+        // routes flow from source to sinks until k units are routed and
+        // returns k in that case. otherwise, returns the maximum flow value.
+        // k = 0 computes the maximum flow without bound. as flows with the
+        // same problem id are continued, every query needs a new problem id
+        FlowType flowUpTo(mutableGraphPtr G,
+                          NodeID source,
+                          const std::vector<NodeID>& sinks,
+                          FlowType k,
+                          size_t problem_id) {
+            timer t;
+            if (!init(G, source, sinks, problem_id)) {
+                return -1;
+            }
+
+            size_t work_before = m_work;
+            m_stats = flow_statistics();
+            m_stats.flows = 1;
+            m_stats.time_init = t.elapsed();
+            FlowType limit = k > 0 ? k : std::numeric_limits<FlowType>::max();
+            FlowType flow = 0;
+            while (flow < limit) {
+                FlowType augmented = augment(limit - flow);
+                if (augmented == 0)
+                    break;
+                flow += augmented;
+                m_stats.augmentations++;
+            }
+            m_stats.time_total = t.elapsed();
+            m_stats.time_discharge = m_stats.time_total - m_stats.time_init;
+
+            LOG0 << "RESULT-BF n=" << G->n() << " m=" << G->m()
+                 << " limit=" << k << " flow=" << flow
+                 << " work=" << m_work - work_before
+                 << " time=" << t.elapsed();
+            return flow;
+        }
+
+        // whether at least k units of flow can be routed from source to sinks
+        bool connectivityAtLeast(mutableGraphPtr G,
+                                 NodeID source,
+                                 const std::vector<NodeID>& sinks,
+                                 FlowType k) {
+            if (k <= 0)
+                return true;
+            return flowUpTo(G, source, sinks, k,
+                            random_functions::nextInt(0, UNDEFINED_NODE)) >= k;
+        }
+
+        // same interface as push_relabel<true, false>: flow from
+        // sources[curr_source] to all other sources. returns (limit, {}) if
+        // the flow is at least limit, limit = 0 computes the maximum flow
+        std::pair<FlowType, std::vector<NodeID> > solve_max_flow_min_cut(
+            mutableGraphPtr G,
+            std::vector<NodeID> sources,
+            NodeID curr_source,
+            bool compute_source_set,
+            FlowType limit = 0,
+            size_t problem_id = random_functions::nextInt(0, UNDEFINED_NODE)) {
+            if (curr_source >= sources.size()) {
+                LOG1 << "source index " << curr_source << " is too large";
+                return std::make_pair(-1, std::vector<NodeID>());
+            }
+
+            NodeID source = sources[curr_source];
+            sources.erase(sources.begin() + curr_source);
+            FlowType flow = flowUpTo(G, source, sources, limit, problem_id);
+
+            if (flow < 0 || (limit > 0 && flow >= limit)) {
+                return std::make_pair(flow, std::vector<NodeID>());
+            }
+
+            std::vector<NodeID> source_set;
+            if (compute_source_set) {
+                source_set = computeSourceSet();
+            }
+            return std::make_pair(flow, source_set);
+        }
+
+        // vertices reached by the last search. if the last query did not
+        // reach its bound, this is the smallest source side of a minimum cut
+        const std::vector<NodeID>& sourceSet() const {
+            return m_reached;
+        }
+
+        size_t getAugmentations() const {
+            return m_augmentations;
+        }
+
+        // counters and timings of the last query, without the time of
+        // computeSourceSet
+        const flow_statistics& getStatistics() const {
+            return m_stats;
+        }
+
+        // number of edges scanned over all queries
+        size_t getWork() const {
+            return m_work;
+        }
+
+     private:
+        bool init(mutableGraphPtr G,
+                  NodeID source,
+                  const std::vector<NodeID>& sinks,
+                  size_t problem_id) {
+            NodeID n = G->number_of_nodes();
+            for (NodeID s : sinks) {
+                if (s >= n || source >= n) {
+                    LOG1 << "source " << std::max(s, source)
+                         << " is too large (only " << n << " nodes)";
+                    return false;
+                }
+                if (s == source) {
+                    LOG1 << "source " << source << " is also a sink";
+                    return false;
+                }
+            }
+
+            // marks are timestamps, entries of a previous larger graph are
+            // never reset and new entries start at 0
+            if (m_visited.size() < G->n()) {
+                m_visited.resize(G->n(), 0);
+                m_is_sink.resize(G->n(), 0);
+                m_next_edge.resize(G->n());
+                m_parent_edge.resize(G->n());
+            }
+
+            m_G = G;
+            m_source = source;
+            m_sinks = sinks;
+            m_problem_id = problem_id;
+            m_query++;
+            for (NodeID s : sinks) {
+                m_is_sink[s] = m_query;
+            }
+            return true;
+        }
+
+        FlowType residual(NodeID v, EdgeID e) {
+            return static_cast<FlowType>(m_G->getEdgeWeight(v, e))
+                   - m_G->getEdgeFlow(v, e, m_problem_id);
+        }
+
+        void visit(NodeID v) {
+            m_visited[v] = m_search;
+            m_next_edge[v] = 0;
+            m_reached.emplace_back(v);
+            m_path.emplace_back(v);
+        }
+
+        // depth-first search for a path from the source to any sink in the
+        // residual graph. augments at most max_amount along the path and
+        // returns the augmented amount, 0 if there is no path
+        FlowType augment(FlowType max_amount) {
+            m_search++;
+            m_reached.clear();
+            m_path.clear();
+            visit(m_source);
+
+            bool found = false;
+            while (!m_path.empty() && !found) {
+                NodeID v = m_path.back();
+                EdgeID& e = m_next_edge[v];
+                bool advanced = false;
+                for ( ; e < m_G->get_first_invalid_edge(v); ++e) {
+                    m_work++;
+                    NodeID w = m_G->getEdgeTarget(v, e);
+                    if (m_visited[w] == m_search || residual(v, e) <= 0)
+                        continue;
+                    m_parent_edge[w] = e;
+                    visit(w);
+                    advanced = true;
+                    found = (m_is_sink[w] == m_query);
+                    break;
+                }
+
+                if (!advanced) {
+                    m_path.pop_back();
+                }
+            }
+
+            if (!found) {
+                // sinks are never visited, so all reached vertices are on
+                // the source side of the cut
+                return 0;
+            }
+
+            FlowType amount = max_amount;
+            for (size_t i = 1; i < m_path.size(); ++i) {
+                amount = std::min(amount, residual(
+                                      m_path[i - 1], m_parent_edge[m_path[i]]));
+            }
+
+            for (size_t i = 1; i < m_path.size(); ++i) {
+                NodeID v = m_path[i - 1];
+                NodeID w = m_path[i];
+                EdgeID e = m_parent_edge[w];
+                EdgeID rev_e = m_G->getReverseEdge(v, e);
+                m_G->addEdgeFlow(v, e, amount, m_problem_id);
+                m_G->addEdgeFlow(w, rev_e, -amount, m_problem_id);
+            }
+
+            m_augmentations++;
+            LOG << "augmented " << amount << " along path of length "
+                << m_path.size() - 1;
+            return amount;
+        }
+
+        // largest source side of a minimum cut, as in push_relabel: all
+        // vertices connected to the source that can not reach a sink in the
+        // residual graph. takes time linear in the graph size
+        std::vector<NodeID> computeSourceSet() {
+            m_search++;
+            std::vector<NodeID> Q = m_sinks;
+            for (NodeID t : m_sinks) {
+                m_visited[t] = m_search;
+            }
+
+            for (size_t i = 0; i < Q.size(); ++i) {
+                NodeID v = Q[i];
+                for (EdgeID e : m_G->edges_of(v)) {
+                    NodeID u = m_G->getEdgeTarget(v, e);
+                    if (m_visited[u] != m_search
+                        && residual(u, m_G->getReverseEdge(v, e)) > 0) {
+                        m_visited[u] = m_search;
+                        Q.emplace_back(u);
+                    }
+                }
+            }
+
+            std::vector<NodeID> source_set = { m_source };
+            m_visited[m_source] = m_search;
+            for (size_t i = 0; i < source_set.size(); ++i) {
+                NodeID v = source_set[i];
+                for (EdgeID e : m_G->edges_of(v)) {
+                    NodeID u = m_G->getEdgeTarget(v, e);
+                    if (m_visited[u] != m_search) {
+                        m_visited[u] = m_search;
+                        source_set.emplace_back(u);
+                    }
+                }
+            }
+            return source_set;
+        }
+
+        mutableGraphPtr m_G;
+        NodeID m_source;
+        std::vector<NodeID> m_sinks;
+        size_t m_problem_id;
+        size_t m_search;
+        size_t m_query;
+        size_t m_augmentations;
+        size_t m_work;
+        flow_statistics m_stats;
+
+        std::vector<size_t> m_visited;
+        std::vector<size_t> m_is_sink;
+        std::vector<EdgeID> m_next_edge;
+        std::vector<EdgeID> m_parent_edge;
+        std::vector<NodeID> m_reached;
+        std::vector<NodeID> m_path;
+    };
+}
@@ -0,0 +1,486 @@
+/******************************************************************************
+ * boykov_kolmogorov.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "algorithms/flow/flow_statistics.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+
+namespace VieCut {
+    // Augmenting path maximum flow by Boykov and Kolmogorov (TPAMI 2004).
+    // Can be used instead of push_relabel<limited, parallel_flows> with the
+    // same interface.
+    //
+    // Two search trees are grown, one from the source and one from all sinks.
+    // When they touch, flow is augmented along the path and vertices whose
+    // tree edge got saturated are adopted by a new parent in the same tree
+    // if possible. The trees are kept between augmentations, so each path
+    // is usually found with little work. This is fast on graphs where the
+    // flow value is small compared to the graph size, e.g. isolating flows
+    // of terminals with low degree.
+    //
+    // The residual graph is stored as an array in the order of the graph
+    // edges. Its arrays are allocated on the first call and reused for all
+    // following calls on a graph with the same number of vertices and edges.
+    // The edges and capacities are read from the graph in every call, so
+    // the graph may change in between. If parallel_flows is false, flows
+    // are written to the graph with the given problem id.
+    template <bool limited = false, bool parallel_flows = false>
+    class boykov_kolmogorov {
+     public:
+        static constexpr bool debug = false;
+
+        boykov_kolmogorov() : m_n(0),
+                              m_m(0),
+                              m_source(0),
+                              m_limit(0),
+                              m_graph_builds(0),
+                              m_augmentations(0),
+                              m_time(0) { }
+        ~boykov_kolmogorov() { }
+
+        std::vector<NodeID> callable_max_flow(mutableGraphPtr G,
+                                              std::vector<NodeID> sources,
+                                              NodeID curr_source,
+                                              bool compute_source_set) {
+            return solve_max_flow_min_cut(
+                G, sources, curr_source, compute_source_set).second;
+        }
+
+        std::pair<FlowType, std::vector<NodeID> > solve_max_flow_min_cut(
+            mutableGraphPtr G,
+            std::vector<NodeID> sources,
+            NodeID curr_source,
+            bool compute_source_set,
+            FlowType limit = 0,
+            size_t problem_id = random_functions::nextInt(0, UNDEFINED_NODE)) {
+            timer t;
+            for (NodeID s : sources) {
+                if (s >= G->number_of_nodes()) {
+                    LOG1 << "source " << s << " is too large (only "
+                         << G->number_of_nodes() << " nodes)";
+                    return std::make_pair(-1, std::vector<NodeID>());
+                }
+            }
+
+            if (G != m_G || G->n() != m_n || G->m() != m_m
+                || !resetResidualGraph()) {
+                buildResidualGraph(G);
+            }
+
+            m_source = sources[curr_source];
+            m_limit = limit;
+            initTrees(sources);
+            m_stats = flow_statistics();
+            m_stats.flows = 1;
+            m_stats.time_init = t.elapsed();
+            FlowType flow = run();
+            m_stats.augmentations = m_augmentations;
+            m_stats.time_discharge = t.elapsed() - m_stats.time_init;
+
+            std::vector<NodeID> source_set;
+            if (compute_source_set) {
+                source_set = computeSourceSet();
+            }
+            m_stats.time_total = t.elapsed();
+            m_stats.time_source_set = m_stats.time_total
+                                      - m_stats.time_init
+                                      - m_stats.time_discharge;
+
+            if constexpr (!parallel_flows) {
+                writeFlows(problem_id);
+            }
+
+            LOG0 << "RESULT-BK n=" << G->n() << " m=" << G->m()
+                 << " augmentations=" << m_augmentations
+                 << " flow=" << flow << " time=" << t.elapsed();
+
+            return std::make_pair(flow, source_set);
+        }
+
+        // number of times the residual graph was built from scratch
+        size_t getGraphBuilds() const {
+            return m_graph_builds;
+        }
+
+        size_t getAugmentations() const {
+            return m_augmentations;
+        }
+
+        // counters and timings of the last call. time_discharge is the time
+        // spent growing trees and augmenting
+        const flow_statistics& getStatistics() const {
+            return m_stats;
+        }
+
+     private:
+        static constexpr uint8_t FREE = 0;
+        static constexpr uint8_t SOURCE_TREE = 1;
+        static constexpr uint8_t SINK_TREE = 2;
+        // parent arc of tree roots and of vertices without a parent
+        static constexpr EdgeID TERMINAL = UNDEFINED_EDGE - 1;
+        static constexpr EdgeID ORPHAN = UNDEFINED_EDGE;
+        static constexpr NodeID INFINITE_DIST =
+            std::numeric_limits<NodeID>::max();
+
+        void buildResidualGraph(mutableGraphPtr G) {
+            m_graph_builds++;
+            m_G = G;
+            m_n = G->n();
+            m_m = G->m();
+            m_offset.resize(m_n + 1);
+            m_offset[0] = 0;
+            for (NodeID v = 0; v < m_n; ++v) {
+                m_offset[v + 1] = m_offset[v] + G->get_first_invalid_edge(v);
+            }
+
+            EdgeID arcs = m_offset[m_n];
+            m_head.resize(arcs);
+            m_rev.resize(arcs);
+            m_capacity.resize(arcs);
+            m_residual.resize(arcs);
+            for (NodeID v = 0; v < m_n; ++v) {
+                for (EdgeID e : G->edges_of(v)) {
+                    EdgeID a = m_offset[v] + e;
+                    NodeID w = G->getEdgeTarget(v, e);
+                    m_head[a] = w;
+                    m_rev[a] = m_offset[w] + G->getReverseEdge(v, e);
+                    m_capacity[a] = G->getEdgeWeight(v, e);
+                }
+            }
+
+            m_tree.resize(m_n);
+            m_parent.resize(m_n);
+            m_timestamp.resize(m_n);
+            m_dist.resize(m_n);
+            m_in_queue.resize(m_n);
+            std::copy(m_capacity.begin(), m_capacity.end(), m_residual.begin());
+        }
+
+        // reads the capacities of the graph again, as edge weights might
+        // have changed since the last call. returns false if the edges of
+        // the graph changed, then the residual graph has to be built again
+        bool resetResidualGraph() {
+            for (NodeID v = 0; v < m_n; ++v) {
+                if (m_offset[v + 1] - m_offset[v]
+                    != m_G->get_first_invalid_edge(v))
+                    return false;
+                for (EdgeID e : m_G->edges_of(v)) {
+                    EdgeID a = m_offset[v] + e;
+                    NodeID w = m_G->getEdgeTarget(v, e);
+                    if (m_head[a] != w
+                        || m_rev[a] != m_offset[w] + m_G->getReverseEdge(v, e))
+                        return false;
+                    m_capacity[a] = m_G->getEdgeWeight(v, e);
+                    m_residual[a] = m_capacity[a];
+                }
+            }
+            return true;
+        }
+
+        void initTrees(const std::vector<NodeID>& sources) {
+            std::fill(m_tree.begin(), m_tree.end(), FREE);
+            std::fill(m_parent.begin(), m_parent.end(), ORPHAN);
+            std::fill(m_timestamp.begin(), m_timestamp.end(), 0);
+            std::fill(m_dist.begin(), m_dist.end(), 0);
+            std::fill(m_in_queue.begin(), m_in_queue.end(), false);
+            m_active = std::queue<NodeID>();
+            m_orphans.clear();
+            m_time = 0;
+            m_augmentations = 0;
+
+            for (NodeID s : sources) {
+                m_tree[s] = (s == m_source) ? SOURCE_TREE : SINK_TREE;
+                m_parent[s] = TERMINAL;
+                activate(s);
+            }
+        }
+
+        void activate(NodeID v) {
+            if (!m_in_queue[v]) {
+                m_in_queue[v] = true;
+                m_active.push(v);
+            }
+        }
+
+        // residual capacity of arc a in direction of tree growth, i.e. away
+        // from the source in the source tree and towards the sinks in the
+        // sink tree
+        FlowType treeResidual(uint8_t tree, EdgeID a) const {
+            return (tree == SOURCE_TREE) ? m_residual[a]
+                                         : m_residual[m_rev[a]];
+        }
+
+        FlowType run() {
+            FlowType flow = 0;
+            while (!m_active.empty()) {
+                NodeID p = m_active.front();
+                if (m_tree[p] == FREE) {
+                    m_active.pop();
+                    m_in_queue[p] = false;
+                    continue;
+                }
+
+                EdgeID bridge = UNDEFINED_EDGE;
+                for (EdgeID a = m_offset[p]; a < m_offset[p + 1]; ++a) {
+                    if (treeResidual(m_tree[p], a) <= 0)
+                        continue;
+                    NodeID q = m_head[a];
+                    if (m_tree[q] == FREE) {
+                        m_tree[q] = m_tree[p];
+                        m_parent[q] = m_rev[a];
+                        m_timestamp[q] = m_timestamp[p];
+                        m_dist[q] = m_dist[p] + 1;
+                        activate(q);
+                    } else if (m_tree[q] != m_tree[p]) {
+                        bridge = a;
+                        break;
+                    }
+                }
+
+                if (bridge == UNDEFINED_EDGE) {
+                    m_active.pop();
+                    m_in_queue[p] = false;
+                    continue;
+                }
+
+                // p stays active, as it might have further neighbors in
+                // the other tree
+                m_time++;
+                flow += augment(p, bridge, flow);
+                adopt();
+
+                if constexpr (limited) {
+                    if (flow >= m_limit) {
+                        return flow;
+                    }
+                }
+            }
+            return flow;
+        }
+
+        FlowType augment(NodeID p, EdgeID bridge, FlowType flow) {
+            m_augmentations++;
+            EdgeID middle = (m_tree[p] == SOURCE_TREE) ? bridge : m_rev[bridge];
+            NodeID s_end = m_head[m_rev[middle]];
+            NodeID t_end = m_head[middle];
+
+            FlowType bottleneck = m_residual[middle];
+            for (NodeID v = s_end; m_parent[v] != TERMINAL;
+                 v = m_head[m_parent[v]]) {
+                bottleneck = std::min(bottleneck,
+                                      m_residual[m_rev[m_parent[v]]]);
+            }
+            for (NodeID v = t_end; m_parent[v] != TERMINAL;
+                 v = m_head[m_parent[v]]) {
+                bottleneck = std::min(bottleneck, m_residual[m_parent[v]]);
+            }
+
+            if constexpr (limited) {
+                bottleneck = std::min(bottleneck, m_limit - flow);
+            }
+
+            pushFlow(middle, bottleneck);
+            for (NodeID v = s_end; m_parent[v] != TERMINAL;) {
+                EdgeID pa = m_parent[v];
+                NodeID next = m_head[pa];
+                pushFlow(m_rev[pa], bottleneck);
+                if (m_residual[m_rev[pa]] == 0) {
+                    makeOrphan(v);
+                }
+                v = next;
+            }
+            for (NodeID v = t_end; m_parent[v] != TERMINAL;) {
+                EdgeID pa = m_parent[v];
+                NodeID next = m_head[pa];
+                pushFlow(pa, bottleneck);
+                if (m_residual[pa] == 0) {
+                    makeOrphan(v);
+                }
+                v = next;
+            }
+            return bottleneck;
+        }
+
+        void pushFlow(EdgeID a, FlowType amount) {
+            m_residual[a] -= amount;
+            m_residual[m_rev[a]] += amount;
+        }
+
+        void makeOrphan(NodeID v) {
+            m_parent[v] = ORPHAN;
+            m_orphans.emplace_back(v);
+        }
+
+        // distance of q to the root of its tree, or INFINITE_DIST if q is
+        // not connected to a root anymore. vertices that were checked since
+        // the last augmentation are marked with the current timestamp
+        NodeID originDistance(NodeID q) {
+            NodeID d = 0;
+            NodeID j = q;
+            while (true) {
+                if (m_timestamp[j] == m_time) {
+                    d += m_dist[j];
+                    break;
+                }
+                EdgeID pa = m_parent[j];
+                if (pa == TERMINAL) {
+                    m_timestamp[j] = m_time;
+                    m_dist[j] = 0;
+                    break;
+                }
+                if (pa == ORPHAN) {
+                    return INFINITE_DIST;
+                }
+                d++;
+                j = m_head[pa];
+            }
+
+            for (NodeID v = q; m_timestamp[v] != m_time;
+                 v = m_head[m_parent[v]]) {
+                m_timestamp[v] = m_time;
+                m_dist[v] = d--;
+            }
+            return m_dist[q];
+        }
+
+        void adopt() {
+            for (size_t i = 0; i < m_orphans.size(); ++i) {
+                NodeID v = m_orphans[i];
+                uint8_t tree = m_tree[v];
+                EdgeID best = ORPHAN;
+                NodeID best_dist = INFINITE_DIST;
+
+                for (EdgeID a = m_offset[v]; a < m_offset[v + 1]; ++a) {
+                    NodeID q = m_head[a];
+                    if (m_tree[q] != tree || treeResidual(tree, m_rev[a]) <= 0)
+                        continue;
+                    NodeID d = originDistance(q);
+                    if (d < best_dist) {
+                        best = a;
+                        best_dist = d;
+                    }
+                }
+
+                if (best != ORPHAN) {
+                    m_parent[v] = best;
+                    m_timestamp[v] = m_time;
+                    m_dist[v] = best_dist + 1;
+                    continue;
+                }
+
+                // no new parent, v leaves the tree. neighbors that could
+                // grow into v become active, children of v become orphans
+                for (EdgeID a = m_offset[v]; a < m_offset[v + 1]; ++a) {
+                    NodeID q = m_head[a];
+                    if (m_tree[q] != tree)
+                        continue;
+                    if (treeResidual(tree, m_rev[a]) > 0) {
+                        activate(q);
+                    }
+                    EdgeID pa = m_parent[q];
+                    if (pa != TERMINAL && pa != ORPHAN && m_head[pa] == v) {
+                        makeOrphan(q);
+                    }
+                }
+                m_tree[v] = FREE;
+            }
+            m_orphans.clear();
+        }
+
+        // maximum source side of a minimum cut: all vertices connected to the
+        // source that can not reach a sink in the residual graph
+        std::vector<NodeID> computeSourceSet() {
+            std::vector<bool> touched(m_n, false);
+            std::queue<NodeID> Q;
+            for (NodeID v = 0; v < m_n; ++v) {
+                if (m_parent[v] == TERMINAL && v != m_source) {
+                    touched[v] = true;
+                    Q.push(v);
+                }
+            }
+
+            while (!Q.empty()) {
+                NodeID v = Q.front();
+                Q.pop();
+                for (EdgeID a = m_offset[v]; a < m_offset[v + 1]; ++a) {
+                    NodeID w = m_head[a];
+                    if (!touched[w] && m_residual[m_rev[a]] > 0) {
+                        touched[w] = true;
+                        Q.push(w);
+                    }
+                }
+            }
+
+            std::vector<NodeID> source_set = { m_source };
+            touched[m_source] = true;
+            Q.push(m_source);
+            while (!Q.empty()) {
+                NodeID v = Q.front();
+                Q.pop();
+                for (EdgeID a = m_offset[v]; a < m_offset[v + 1]; ++a) {
+                    NodeID w = m_head[a];
+                    if (!touched[w]) {
+                        touched[w] = true;
+                        source_set.emplace_back(w);
+                        Q.push(w);
+                    }
+                }
+            }
+            return source_set;
+        }
+
+        void writeFlows(size_t problem_id) {
+            for (NodeID v = 0; v < m_n; ++v) {
+                for (EdgeID e : m_G->edges_of(v)) {
+                    EdgeID a = m_offset[v] + e;
+                    m_G->setEdgeFlow(v, e, m_capacity[a] - m_residual[a],
+                                     problem_id);
+                }
+            }
+        }
+
+        mutableGraphPtr m_G;
+        NodeID m_n;
+        EdgeID m_m;
+        NodeID m_source;
+        FlowType m_limit;
+        size_t m_graph_builds;
+        size_t m_augmentations;
+        NodeID m_time;
+        flow_statistics m_stats;
+
+        std::vector<EdgeID> m_offset;
+        std::vector<NodeID> m_head;
+        std::vector<EdgeID> m_rev;
+        std::vector<FlowType> m_capacity;
+        std::vector<FlowType> m_residual;
+
+        std::vector<uint8_t> m_tree;
+        std::vector<EdgeID> m_parent;
+        std::vector<NodeID> m_timestamp;
+        std::vector<NodeID> m_dist;
+        std::vector<bool> m_in_queue;
+        std::queue<NodeID> m_active;
+        std::vector<NodeID> m_orphans;
+    };
+}
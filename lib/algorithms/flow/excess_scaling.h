@@ -63,20 +63,15 @@ namespace VieCut {
             while (m_mu > 4) {
                 size_t discard = 0;
                 unit_flow uf;
-                uf.init(*m_fg, flowsrc, m_U, m_max_height, 2);
+                uf.init(m_fg, flowsrc, m_U, m_max_height, 2);
                 uf.run();
-                size_t ctr = 0;
+                // arcs are stored contiguously, so m_flows is indexed by arc
+                for (EdgeID a = 0; a < m_fg->number_of_edges(); ++a) {
+                    m_flows[a] += m_fg->arcFlow(a) * m_mu;
+                }
+                m_fg->resetFlows();
 
                 for (NodeID n : m_fg->nodes()) {
-                    for (EdgeID e : m_fg->edges_of(n)) {
-                        EdgeID rev = m_fg->getReverseEdge(n, e);
-                        NodeID tgt = m_fg->getEdgeTarget(n, e);
-
-                        m_flows[ctr++] += m_fg->getEdgeFlow(n, e) * m_mu;
-                        m_fg->setEdgeFlow(n, e, 0);
-                        m_fg->setEdgeFlow(tgt, rev, 0);
-                    }
-
                     if (uf.excess(n) > 0) {
                         discard += uf.excess(n);
                         m_delta_src[n] = m_delta_src[n] - uf.excess(n);
@@ -0,0 +1,79 @@
+/******************************************************************************
+ * flow_statistics.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+namespace VieCut {
+    // Counters and timings of maximum flow computations. The flow algorithms
+    // fill them for every call (see getStatistics()), callers that run many
+    // flows sum them up with add(). Counters that an algorithm does not have
+    // stay 0, e.g. there are no pushes in augmenting path algorithms.
+    struct flow_statistics {
+        size_t flows = 0;
+        size_t pushes = 0;
+        // pushes that moved a positive amount of flow
+        size_t actual_pushes = 0;
+        size_t relabels = 0;
+        size_t gaps = 0;
+        size_t global_updates = 0;
+        size_t augmentations = 0;
+        // maximum number of active vertices at any time, for sums this is
+        // the maximum over all flows
+        size_t peak_active = 0;
+
+        // initialization and initial global relabeling
+        double time_init = 0;
+        // global relabeling after initialization
+        double time_global_relabel = 0;
+        // pushes, relabels and gap heuristic
+        double time_discharge = 0;
+        double time_source_set = 0;
+        double time_total = 0;
+
+        void add(const flow_statistics& other) {
+            flows += other.flows;
+            pushes += other.pushes;
+            actual_pushes += other.actual_pushes;
+            relabels += other.relabels;
+            gaps += other.gaps;
+            global_updates += other.global_updates;
+            augmentations += other.augmentations;
+            peak_active = std::max(peak_active, other.peak_active);
+            time_init += other.time_init;
+            time_global_relabel += other.time_global_relabel;
+            time_discharge += other.time_discharge;
+            time_source_set += other.time_source_set;
+            time_total += other.time_total;
+        }
+
+        std::string toString() const {
+            std::stringstream ss;
+            ss << "flows=" << flows
+               << " pushes=" << pushes
+               << " actual_pushes=" << actual_pushes
+               << " relabels=" << relabels
+               << " gaps=" << gaps
+               << " global_updates=" << global_updates
+               << " augmentations=" << augmentations
+               << " peak_active=" << peak_active
+               << " time_init=" << time_init
+               << " time_global_relabel=" << time_global_relabel
+               << " time_discharge=" << time_discharge
+               << " time_source_set=" << time_source_set
+               << " time_total=" << time_total;
+            return ss.str();
+        }
+    };
+}
@@ -0,0 +1,202 @@
+/******************************************************************************
+ * gomory_hu_tree.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "algorithms/flow/push_relabel.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/timer.h"
+
+namespace VieCut {
+    // Gomory-Hu tree of an undirected weighted graph, i.e. a weighted tree
+    // on the same vertices in which the connectivity (minimum cut value)
+    // of any two vertices is the lightest edge on the path between them.
+    //
+    // Built with Gusfield's algorithm (SIAM J. Comput. 1990), which needs
+    // n - 1 maximum flows on the input graph and no contraction. Vertex s
+    // computes a minimum cut to its current tree parent p[s] and afterwards
+    // vertices on its side of the cut with the same parent are moved to s.
+    // The flow of s only depends on p[s], which is not changed by vertices
+    // larger than s. Thus, the flows of the next vertices are computed in
+    // parallel (one push_relabel object per thread) with the parents at the
+    // start of the batch. The results are applied in order and a vertex
+    // whose parent was changed by a previous vertex in the batch starts the
+    // next batch, so the result is the same tree as sequentially.
+    class gomory_hu_tree {
+     public:
+        static constexpr bool debug = false;
+
+        gomory_hu_tree() : m_flows(0), m_recomputed(0) { }
+        ~gomory_hu_tree() { }
+
+        void build(mutableGraphPtr G) {
+            timer t;
+            NodeID n = G->n();
+            m_parent.assign(n, 0);
+            m_weight.assign(n, 0);
+            m_in_side.assign(n, false);
+            m_flows = 0;
+            m_recomputed = 0;
+
+            size_t threads = omp_get_max_threads();
+            std::vector<push_relabel<false, true> > prs(threads);
+            NodeID next = 1;
+            while (next < n) {
+                NodeID batch = std::min(static_cast<NodeID>(threads),
+                                        n - next);
+                std::vector<NodeID> target(batch);
+                std::vector<FlowType> flow(batch);
+                std::vector<std::vector<NodeID> > side(batch);
+                for (NodeID i = 0; i < batch; ++i) {
+                    target[i] = m_parent[next + i];
+                }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+                for (NodeID i = 0; i < batch; ++i) {
+                    auto& pr = prs[omp_get_thread_num()];
+                    std::vector<NodeID> terminals = { next + i, target[i] };
+                    std::tie(flow[i], side[i]) = pr.solve_max_flow_min_cut(
+                        G, terminals, 0, true, 0, next + i);
+                }
+                m_flows += batch;
+
+                NodeID applied = 0;
+                while (applied < batch
+                       && m_parent[next + applied] == target[applied]) {
+                    update(next + applied, flow[applied], side[applied]);
+                    applied++;
+                }
+                m_recomputed += batch - applied;
+                next += applied;
+            }
+
+            computeDepths();
+            LOG0 << "RESULT-GH n=" << n << " m=" << G->m()
+                 << " flows=" << m_flows << " recomputed=" << m_recomputed
+                 << " threads=" << threads << " time=" << t.elapsed();
+        }
+
+        // parent of v in the tree, the root 0 is its own parent
+        NodeID getParent(NodeID v) const {
+            return m_parent[v];
+        }
+
+        // weight of the tree edge from v to its parent, i.e. the
+        // connectivity of v and its parent
+        FlowType getParentWeight(NodeID v) const {
+            return m_weight[v];
+        }
+
+        // connectivity of u and v, UNDEFINED_FLOW if u == v
+        FlowType connectivity(NodeID u, NodeID v) const {
+            FlowType conn = UNDEFINED_FLOW;
+            while (u != v) {
+                if (m_depth[u] < m_depth[v]) {
+                    std::swap(u, v);
+                }
+                conn = std::min(conn, m_weight[u]);
+                u = m_parent[u];
+            }
+            return conn;
+        }
+
+        // value of a global minimum cut, the lightest edge of the tree
+        FlowType minimumCut() const {
+            FlowType cut = UNDEFINED_FLOW;
+            for (NodeID v = 1; v < m_parent.size(); ++v) {
+                cut = std::min(cut, m_weight[v]);
+            }
+            return cut;
+        }
+
+        // the tree as a graph with an edge from every vertex to its parent
+        mutableGraphPtr getTree() const {
+            mutableGraphPtr T = std::make_shared<mutable_graph>();
+            T->start_construction(m_parent.size());
+            for (NodeID v = 1; v < m_parent.size(); ++v) {
+                T->new_edge_order(v, m_parent[v], m_weight[v]);
+            }
+            T->finish_construction();
+            return T;
+        }
+
+        // number of maximum flows computed, including the ones that had to
+        // be recomputed as their target changed during the batch
+        size_t getFlows() const {
+            return m_flows;
+        }
+
+        size_t getRecomputed() const {
+            return m_recomputed;
+        }
+
+     private:
+        void update(NodeID s, FlowType flow, const std::vector<NodeID>& side) {
+            NodeID t = m_parent[s];
+            m_weight[s] = flow;
+            for (NodeID v : side) {
+                m_in_side[v] = true;
+                if (v != s && m_parent[v] == t) {
+                    m_parent[v] = s;
+                }
+            }
+
+            if (m_in_side[m_parent[t]]) {
+                m_parent[s] = m_parent[t];
+                m_parent[t] = s;
+                m_weight[s] = m_weight[t];
+                m_weight[t] = flow;
+            }
+
+            for (NodeID v : side) {
+                m_in_side[v] = false;
+            }
+            LOG << "vertex " << s << " parent " << m_parent[s]
+                << " flow " << flow;
+        }
+
+        void computeDepths() {
+            NodeID n = m_parent.size();
+            m_depth.assign(n, UNDEFINED_NODE);
+            if (n == 0)
+                return;
+            m_depth[0] = 0;
+            std::vector<NodeID> path;
+            for (NodeID v = 0; v < n; ++v) {
+                NodeID u = v;
+                while (m_depth[u] == UNDEFINED_NODE) {
+                    path.emplace_back(u);
+                    u = m_parent[u];
+                }
+                while (!path.empty()) {
+                    m_depth[path.back()] = m_depth[m_parent[path.back()]] + 1;
+                    path.pop_back();
+                }
+            }
+        }
+
+        std::vector<NodeID> m_parent;
+        std::vector<FlowType> m_weight;
+        std::vector<NodeID> m_depth;
+        std::vector<bool> m_in_side;
+        size_t m_flows;
+        size_t m_recomputed;
+    };
+}
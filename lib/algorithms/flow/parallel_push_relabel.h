@@ -0,0 +1,408 @@
+/******************************************************************************
+ * parallel_push_relabel.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "algorithms/flow/flow_statistics.h"
+#include "algorithms/flow/parallel_residual_bfs.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+
+namespace VieCut {
+    // Shared-memory parallel push-relabel, following the synchronous approach
+    // of Baumstark, Blelloch and Shun (ESA 2015). Can be used instead of
+    // push_relabel<limited, parallel_flows> with the same interface.
+    //
+    // The algorithm works in rounds. In each round, all active vertices are
+    // discharged in parallel using the distance labels at the start of the
+    // round. As a vertex only pushes to neighbors with a label one lower, no
+    // edge is used by two threads in the same round. Excess arriving at a
+    // vertex is buffered and only applied at the end of the round. Afterwards
+    // all active vertices that still have excess are relabeled in parallel
+    // (again using old labels of neighbors). Global relabeling is a parallel
+    // direction-optimizing BFS from the sinks.
+    //
+    // This computes a maximum preflow, i.e. the maximum flow value and a
+    // minimum cut. Excess of vertices that can not reach a sink anymore is
+    // not returned to the source.
+    //
+    // Flows are stored in an internal array, if parallel_flows is false they
+    // are written to the graph with the given problem id when finished.
+    template <bool limited = false, bool parallel_flows = false>
+    class parallel_push_relabel {
+     public:
+        static constexpr bool debug = false;
+
+        parallel_push_relabel() { }
+        ~parallel_push_relabel() { }
+
+        std::vector<NodeID> callable_max_flow(mutableGraphPtr G,
+                                              std::vector<NodeID> sources,
+                                              NodeID curr_source,
+                                              bool compute_source_set) {
+            return solve_max_flow_min_cut(
+                G, sources, curr_source, compute_source_set).second;
+        }
+
+        std::pair<FlowType, std::vector<NodeID> > solve_max_flow_min_cut(
+            mutableGraphPtr G,
+            std::vector<NodeID> sources,
+            NodeID curr_source,
+            bool compute_source_set,
+            FlowType limit = 0,
+            size_t problem_id = random_functions::nextInt(0, UNDEFINED_NODE)) {
+            timer t;
+            for (NodeID s : sources) {
+                if (s >= G->number_of_nodes()) {
+                    LOG1 << "source " << s << " is too large (only "
+                         << G->number_of_nodes() << " nodes)";
+                    return std::make_pair(-1, std::vector<NodeID>());
+                }
+            }
+
+            if constexpr (limited) {
+                if (sources.size() != 2) {
+                    LOG1 << "Limited push_relabel only implemented for single sink";
+                }
+            }
+
+            m_G = G;
+            m_sources = sources;
+            m_source = sources[curr_source];
+            m_limit = limit;
+            m_rounds = 0;
+            m_global_updates = 0;
+            m_stats = flow_statistics();
+            m_stats.flows = 1;
+
+            init();
+            globalRelabel();
+            m_stats.time_init = t.elapsed();
+            FlowType flow = run();
+            m_stats.time_discharge = t.elapsed() - m_stats.time_init
+                                     - m_stats.time_global_relabel;
+
+            std::vector<NodeID> source_set;
+            if (compute_source_set) {
+                source_set = computeSourceSet();
+            }
+            // a round relabels all active vertices at once, so rounds are
+            // counted as relabels
+            m_stats.relabels = m_rounds;
+            m_stats.global_updates = m_global_updates;
+            m_stats.time_total = t.elapsed();
+            m_stats.time_source_set = m_stats.time_total
+                                      - m_stats.time_init
+                                      - m_stats.time_global_relabel
+                                      - m_stats.time_discharge;
+
+            if constexpr (!parallel_flows) {
+                writeFlows(problem_id);
+            }
+
+            LOG0 << "RESULT-PPR n=" << G->n() << " m=" << G->m()
+                 << " rounds=" << m_rounds
+                 << " global_updates=" << m_global_updates
+                 << " flow=" << flow << " time=" << t.elapsed();
+
+            return std::make_pair(flow, source_set);
+        }
+
+        // counters and timings of the last call
+        const flow_statistics& getStatistics() const {
+            return m_stats;
+        }
+
+     private:
+        static constexpr double global_update_frequency = 0.5;
+
+        EdgeID edgeIndex(NodeID n, EdgeID e) const {
+            return m_offset[n] + e;
+        }
+
+        FlowType residual(NodeID n, EdgeID e) const {
+            return static_cast<FlowType>(m_G->getEdgeWeight(n, e))
+                   - m_flow[edgeIndex(n, e)];
+        }
+
+        void init() {
+            NodeID n = m_G->n();
+            m_offset.resize(n + 1);
+            m_offset[0] = 0;
+            for (NodeID v = 0; v < n; ++v) {
+                m_offset[v + 1] = m_offset[v] + m_G->get_first_invalid_edge(v);
+            }
+
+            m_flow.resize(m_offset[n]);
+            m_excess.resize(n);
+            m_added.resize(n);
+            m_distance.resize(n);
+            m_new_distance.resize(n);
+            m_in_next.resize(n);
+            m_is_terminal.assign(n, false);
+            for (NodeID s : m_sources) {
+                m_is_terminal[s] = true;
+            }
+
+    #pragma omp parallel for schedule(static)
+            for (NodeID v = 0; v < n; ++v) {
+                m_excess[v] = 0;
+                m_added[v] = 0;
+                m_distance[v] = 0;
+                m_new_distance[v] = 0;
+                m_in_next[v] = 0;
+                for (EdgeID e : m_G->edges_of(v)) {
+                    m_flow[edgeIndex(v, e)] = 0;
+                }
+            }
+
+            for (EdgeID e : m_G->edges_of(m_source)) {
+                FlowType capacity = m_G->getEdgeWeight(m_source, e);
+                NodeID tgt = m_G->getEdgeTarget(m_source, e);
+                EdgeID rev_e = m_G->getReverseEdge(m_source, e);
+                m_flow[edgeIndex(m_source, e)] += capacity;
+                m_flow[edgeIndex(tgt, rev_e)] -= capacity;
+                m_excess[tgt] += capacity;
+            }
+        }
+
+        // parallel bfs from the sinks in the reverse residual graph.
+        // vertices that can not reach a sink get label n. afterwards, the
+        // set of active vertices is rebuilt
+        void globalRelabel() {
+            m_global_updates++;
+            NodeID n = m_G->n();
+
+    #pragma omp parallel for schedule(static)
+            for (NodeID v = 0; v < n; ++v) {
+                m_distance[v] = n;
+            }
+
+            std::vector<NodeID> sinks;
+            for (NodeID s : m_sources) {
+                if (s != m_source) {
+                    sinks.emplace_back(s);
+                }
+            }
+
+            parallel_residual_bfs::run(
+                m_G, sinks, m_source, n, &m_distance,
+                [this](NodeID v, EdgeID e) { return residual(v, e); });
+
+            std::vector<std::vector<NodeID> > local(omp_get_max_threads());
+    #pragma omp parallel
+            {
+                auto& next = local[omp_get_thread_num()];
+    #pragma omp for schedule(static)
+                for (NodeID v = 0; v < n; ++v) {
+                    if (isActive(v)) {
+                        next.emplace_back(v);
+                    }
+                }
+            }
+            parallel_residual_bfs::gather(&local, &m_active);
+        }
+
+        bool isActive(NodeID v) const {
+            return !m_is_terminal[v] && m_excess[v] > 0
+                   && m_distance[v] < m_G->n();
+        }
+
+        FlowType sinkExcess() const {
+            FlowType flow = 0;
+            for (NodeID s : m_sources) {
+                if (s != m_source) {
+                    flow += m_excess[s];
+                }
+            }
+            return flow;
+        }
+
+        FlowType run() {
+            NodeID n = m_G->n();
+            size_t work_todo = 4 * n + m_G->m();
+            size_t work = 0;
+            std::vector<std::vector<NodeID> > local(omp_get_max_threads());
+
+            while (!m_active.empty()) {
+                m_rounds++;
+                m_stats.peak_active = std::max(m_stats.peak_active,
+                                               m_active.size());
+                size_t round_work = 0;
+                size_t round_pushes = 0;
+
+                // push along admissible edges. a vertex only writes the flow
+                // on its own edges and their reverse, these are not touched
+                // by any other vertex in this round
+    #pragma omp parallel reduction(+ : round_work, round_pushes)
+                {
+                    auto& next = local[omp_get_thread_num()];
+    #pragma omp for schedule(dynamic, 16)
+                    for (size_t i = 0; i < m_active.size(); ++i) {
+                        NodeID v = m_active[i];
+                        FlowType excess = m_excess[v];
+                        NodeID dist = m_distance[v];
+                        for (EdgeID e : m_G->edges_of(v)) {
+                            if (excess == 0)
+                                break;
+                            round_work++;
+                            NodeID w = m_G->getEdgeTarget(v, e);
+                            if (m_distance[w] + 1 != dist)
+                                continue;
+                            FlowType res = residual(v, e);
+                            if (res <= 0)
+                                continue;
+                            FlowType amount = std::min(res, excess);
+                            EdgeID rev_e = m_G->getReverseEdge(v, e);
+                            m_flow[edgeIndex(v, e)] += amount;
+                            m_flow[edgeIndex(w, rev_e)] -= amount;
+                            excess -= amount;
+                            round_pushes++;
+                            __sync_fetch_and_add(&m_added[w], amount);
+                            if (__sync_bool_compare_and_swap(
+                                    &m_in_next[w], 0, 1)) {
+                                next.emplace_back(w);
+                            }
+                        }
+                        m_excess[v] = excess;
+                    }
+
+                    // relabel vertices with remaining excess. reads labels
+                    // of neighbors from before the round
+    #pragma omp for schedule(dynamic, 16)
+                    for (size_t i = 0; i < m_active.size(); ++i) {
+                        NodeID v = m_active[i];
+                        if (m_excess[v] == 0)
+                            continue;
+                        NodeID new_dist = n;
+                        for (EdgeID e : m_G->edges_of(v)) {
+                            if (residual(v, e) > 0) {
+                                NodeID w = m_G->getEdgeTarget(v, e);
+                                new_dist = std::min(new_dist,
+                                                    m_distance[w] + 1);
+                            }
+                        }
+                        round_work += m_G->get_first_invalid_edge(v);
+                        m_new_distance[v] = new_dist;
+                        if (__sync_bool_compare_and_swap(&m_in_next[v], 0, 1)) {
+                            next.emplace_back(v);
+                        }
+                    }
+
+    #pragma omp for schedule(static)
+                    for (size_t i = 0; i < m_active.size(); ++i) {
+                        NodeID v = m_active[i];
+                        if (m_excess[v] > 0) {
+                            m_distance[v] = m_new_distance[v];
+                        }
+                    }
+                }
+                parallel_residual_bfs::gather(&local, &m_active);
+
+                // apply buffered excess
+    #pragma omp parallel for schedule(static)
+                for (size_t i = 0; i < m_active.size(); ++i) {
+                    NodeID v = m_active[i];
+                    m_excess[v] += m_added[v];
+                    m_added[v] = 0;
+                    m_in_next[v] = 0;
+                }
+
+                m_active.erase(std::remove_if(m_active.begin(), m_active.end(),
+                                              [this](NodeID v) {
+                                                  return !isActive(v);
+                                              }), m_active.end());
+
+                if constexpr (limited) {
+                    if (sinkExcess() >= m_limit) {
+                        return m_limit;
+                    }
+                }
+
+                m_stats.pushes += round_pushes;
+                m_stats.actual_pushes += round_pushes;
+                work += round_work;
+                if (work > global_update_frequency * work_todo) {
+                    timer t_relabel;
+                    globalRelabel();
+                    m_stats.time_global_relabel += t_relabel.elapsed();
+                    work = 0;
+                }
+            }
+
+            return sinkExcess();
+        }
+
+        // vertices that can not reach a sink in the residual graph. label n
+        // after global relabeling means that a vertex can not reach a sink
+        std::vector<NodeID> computeSourceSet() {
+            globalRelabel();
+            NodeID n = m_G->n();
+            std::vector<bool> found(n, false);
+            std::vector<NodeID> source_set = { m_source };
+            std::queue<NodeID> Q;
+            Q.push(m_source);
+            found[m_source] = true;
+            while (!Q.empty()) {
+                NodeID v = Q.front();
+                Q.pop();
+                for (EdgeID e : m_G->edges_of(v)) {
+                    NodeID w = m_G->getEdgeTarget(v, e);
+                    if (!found[w] && m_distance[w] == n && !m_is_terminal[w]) {
+                        found[w] = true;
+                        source_set.emplace_back(w);
+                        Q.push(w);
+                    }
+                }
+            }
+            return source_set;
+        }
+
+        void writeFlows(size_t problem_id) {
+    #pragma omp parallel for schedule(dynamic, 1024)
+            for (NodeID v = 0; v < m_G->n(); ++v) {
+                for (EdgeID e : m_G->edges_of(v)) {
+                    m_G->setEdgeFlow(v, e, m_flow[edgeIndex(v, e)], problem_id);
+                }
+            }
+        }
+
+        mutableGraphPtr m_G;
+        std::vector<NodeID> m_sources;
+        NodeID m_source;
+        FlowType m_limit;
+        size_t m_rounds;
+        size_t m_global_updates;
+        flow_statistics m_stats;
+
+        std::vector<EdgeID> m_offset;
+        std::vector<FlowType> m_flow;
+        std::vector<FlowType> m_excess;
+        std::vector<FlowType> m_added;
+        std::vector<NodeID> m_distance;
+        std::vector<NodeID> m_new_distance;
+        std::vector<uint8_t> m_in_next;
+        std::vector<bool> m_is_terminal;
+        std::vector<NodeID> m_active;
+    };
+}
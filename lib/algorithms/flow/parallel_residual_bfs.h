@@ -0,0 +1,159 @@
+/******************************************************************************
+ * parallel_residual_bfs.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+
+namespace VieCut {
+    // Parallel BFS from a set of sinks in the reverse residual graph, as used
+    // for global relabeling in push-relabel algorithms. Direction-optimizing
+    // (Beamer, Asanovic and Patterson, SC 2012): small frontiers are expanded
+    // top-down, i.e. every frontier vertex looks at its neighbors. If the
+    // frontier has many edges compared to the unexplored part of the graph,
+    // every unvisited vertex instead looks for a neighbor in the frontier
+    // (bottom-up), which needs no compare-and-swap. Distances that other
+    // threads might write are accessed with relaxed atomic loads and stores.
+    class parallel_residual_bfs {
+     public:
+        // switching thresholds from the paper
+        static constexpr size_t alpha = 14;
+        static constexpr size_t beta = 24;
+
+        // sets distance[v] to its BFS level for every vertex v that reaches
+        // a root in the residual graph without passing 'excluded'. all
+        // vertices but the roots need distance >= unreached before, the
+        // distances of vertices that are not reached are left unchanged.
+        // residual(v, e) has to return the residual capacity of edge e of v.
+        // returns the number of vertices in each BFS level.
+        template <class Residual>
+        static std::vector<NodeID> run(mutableGraphPtr G,
+                                       const std::vector<NodeID>& roots,
+                                       NodeID excluded,
+                                       NodeID unreached,
+                                       std::vector<NodeID>* distance,
+                                       Residual residual) {
+            std::vector<NodeID>& dist = *distance;
+            std::vector<NodeID> frontier;
+            std::vector<NodeID> level_sizes;
+            std::vector<std::vector<NodeID> > local(omp_get_max_threads());
+
+            EdgeID frontier_edges = 0;
+            for (NodeID r : roots) {
+                dist[r] = 0;
+                frontier.emplace_back(r);
+                frontier_edges += G->get_first_invalid_edge(r);
+            }
+            EdgeID unexplored_edges = G->m() - frontier_edges;
+            level_sizes.emplace_back(frontier.size());
+
+            auto unvisited = [&](NodeID v) {
+                return load(&dist[v]) >= unreached && v != excluded;
+            };
+
+            bool bottom_up = false;
+            NodeID level = 0;
+            while (!frontier.empty()) {
+                level++;
+                if (!bottom_up && frontier_edges > unexplored_edges / alpha) {
+                    bottom_up = true;
+                } else if (bottom_up && frontier.size() < G->n() / beta) {
+                    bottom_up = false;
+                }
+
+                EdgeID next_edges = 0;
+                if (bottom_up) {
+    #pragma omp parallel reduction(+ : next_edges)
+                    {
+                        auto& next = local[omp_get_thread_num()];
+    #pragma omp for schedule(dynamic, 1024)
+                        for (NodeID w = 0; w < G->n(); ++w) {
+                            if (!unvisited(w))
+                                continue;
+                            for (EdgeID e : G->edges_of(w)) {
+                                NodeID u = G->getEdgeTarget(w, e);
+                                if (load(&dist[u]) == level - 1
+                                    && u != excluded
+                                    && residual(w, e) > 0) {
+                                    store(&dist[w], level);
+                                    next.emplace_back(w);
+                                    next_edges += G->get_first_invalid_edge(w);
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                } else {
+    #pragma omp parallel reduction(+ : next_edges)
+                    {
+                        auto& next = local[omp_get_thread_num()];
+    #pragma omp for schedule(dynamic, 64)
+                        for (size_t i = 0; i < frontier.size(); ++i) {
+                            NodeID u = frontier[i];
+                            for (EdgeID e : G->edges_of(u)) {
+                                NodeID w = G->getEdgeTarget(u, e);
+                                if (!unvisited(w))
+                                    continue;
+                                EdgeID rev_e = G->getReverseEdge(u, e);
+                                NodeID old = load(&dist[w]);
+                                if (residual(w, rev_e) > 0
+                                    && old >= unreached
+                                    && __sync_bool_compare_and_swap(
+                                        &dist[w], old, level)) {
+                                    next.emplace_back(w);
+                                    next_edges += G->get_first_invalid_edge(w);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                gather(&local, &frontier);
+                frontier_edges = next_edges;
+                unexplored_edges -= std::min(unexplored_edges, next_edges);
+                if (!frontier.empty()) {
+                    level_sizes.emplace_back(frontier.size());
+                }
+            }
+            return level_sizes;
+        }
+
+        static NodeID load(NodeID* v) {
+            return __atomic_load_n(v, __ATOMIC_RELAXED);
+        }
+
+        static void store(NodeID* v, NodeID value) {
+            __atomic_store_n(v, value, __ATOMIC_RELAXED);
+        }
+
+        // concatenate thread local vectors into out and clear them
+        static void gather(std::vector<std::vector<NodeID> >* local,
+                           std::vector<NodeID>* out) {
+            std::vector<size_t> start(local->size() + 1, 0);
+            for (size_t i = 0; i < local->size(); ++i) {
+                start[i + 1] = start[i] + (*local)[i].size();
+            }
+            out->resize(start.back());
+    #pragma omp parallel for schedule(static, 1)
+            for (size_t i = 0; i < local->size(); ++i) {
+                std::copy((*local)[i].begin(), (*local)[i].end(),
+                          out->begin() + start[i]);
+                (*local)[i].clear();
+            }
+        }
+    };
+}
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <omp.h>
+
 #include <algorithm>
 #include <iostream>
 #include <memory>
@@ -21,11 +23,13 @@
 #include <utility>
 #include <vector>
 
+#include "algorithms/flow/active_vertex_set.h"
+#include "algorithms/flow/flow_statistics.h"
+#include "algorithms/flow/parallel_residual_bfs.h"
 #include "algorithms/misc/graph_algorithms.h"
 #include "common/configuration.h"
 #include "common/definitions.h"
 #include "data_structure/mutable_graph.h"
-#include "data_structure/priority_queues/maxNodeHeap.h"
 #include "tools/random_functions.h"
 #include "tools/timer.h"
 
@@ -33,8 +37,12 @@ namespace VieCut {
     const int WORK_OP_RELABEL = 9;
     const double GLOBAL_UPDATE_FRQ = 0.51;
     const int WORK_NODE_TO_EDGES = 4;
+    // use parallel global relabeling on graphs with at least this many nodes
+    const NodeID PARALLEL_RELABEL_NODES = 100000;
 
-    template <bool limited = false, bool parallel_flows = false>
+    // active_set is highest_label_buckets or heap_active_set
+    template <bool limited = false, bool parallel_flows = false,
+              class active_set = highest_label_buckets>
     class push_relabel {
      public:
         push_relabel() : m_current_iteration(0) { }
@@ -48,24 +56,23 @@ namespace VieCut {
             if (m_excess.size() < G->n()) {
                 m_excess.resize(G->n(), 0);
                 m_distance.resize(G->n(), 0);
-                m_active.resize(G->n(), false);
-                m_count.resize(2 * G->n(), 0);
                 m_bfstouched.resize(G->n(), false);
             }
-            std::fill(m_excess.begin(), m_excess.end(), 0);
-            std::fill(m_distance.begin(), m_distance.end(), 0);
-            std::fill(m_active.begin(), m_active.end(), false);
-            std::fill(m_count.begin(), m_count.end(), 0);
-            std::fill(m_bfstouched.begin(), m_bfstouched.end(), false);
-            m_Q.reset();
-            m_count[0] = G->number_of_nodes() - 1;
-            m_count[G->number_of_nodes()] = 1;
+            // vectors might be larger from previous calls on larger graphs,
+            // only reset the entries that are used for this graph
+            std::fill(m_excess.begin(), m_excess.begin() + G->n(), 0);
+            std::fill(m_distance.begin(), m_distance.begin() + G->n(), 0);
+            std::fill(m_bfstouched.begin(), m_bfstouched.begin() + G->n(),
+                      false);
+            m_Q.reset(G->n(), numLabels());
+            m_Q.setCount(0, G->number_of_nodes() - 1);
+            m_Q.setCount(G->number_of_nodes(), 1);
 
             NodeID flow_source = sources[source];
             m_distance[flow_source] = G->number_of_nodes();
 
             for (NodeID n : sources) {
-                m_active[n] = true;
+                m_Q.block(n);
             }
 
             for (EdgeID e : G->edges_of(flow_source)) {
@@ -78,17 +85,29 @@ namespace VieCut {
         // to update distance labels
         template <bool initial = false>
         void global_relabeling(std::vector<NodeID> sources, NodeID source) {
+            // with parallel_flows, multiple flows already run in parallel.
+            // the limited initial relabeling only touches a small part
+            if constexpr (!parallel_flows && !(limited && initial)) {
+                if (m_G->n() >= PARALLEL_RELABEL_NODES
+                    && omp_get_max_threads() > 1 && !omp_in_parallel()) {
+                    parallel_global_relabeling<initial>(sources, source);
+                    return;
+                }
+            }
+
             std::queue<NodeID> Q;
             NodeID flow_source = sources[source];
 
-            std::fill(m_bfstouched.begin(), m_bfstouched.end(), false);
+            std::fill(m_bfstouched.begin(), m_bfstouched.begin() + m_G->n(),
+                      false);
             size_t depthPR = configuration::getConfig()->depthOfPartialRelabeling;
 
             if constexpr (limited && initial) {
                 size_t fillValue = depthPR + 1;
-                std::fill(m_distance.begin(), m_distance.end(), fillValue);
-                m_count[0] = 0;
-                m_count[fillValue] = m_G->n() - 1;
+                std::fill(m_distance.begin(), m_distance.begin() + m_G->n(),
+                          fillValue);
+                m_Q.setCount(0, 0);
+                m_Q.setCount(fillValue, m_G->n() - 1);
             } else {
                 for (NodeID n : m_G->nodes()) {
                     m_distance[n] = std::max(m_distance[n], m_G->number_of_nodes());
@@ -103,8 +122,7 @@ namespace VieCut {
 
                 Q.push(sink);
                 m_bfstouched[sink] = true;
-                m_count[m_distance[sink]]--;
-                m_count[0]++;
+                m_Q.moveLabel(m_distance[sink], 0);
                 m_distance[sink] = 0;
             }
 
@@ -126,9 +144,9 @@ namespace VieCut {
                     EdgeID rev_e = m_G->getReverseEdge(node, e);
                     if (initial || (m_G->getEdgeWeight(target, rev_e) -
                                     getEdgeFlow(target, rev_e)) > 0) {
-                        m_count[m_distance[target]]--;
+                        m_Q.moveLabel(m_distance[target],
+                                      m_distance[node] + 1);
                         m_distance[target] = m_distance[node] + 1;
-                        m_count[m_distance[target]]++;
                         if constexpr (!(limited && initial)) {
                             Q.push(target);
                         } else {
@@ -142,9 +160,58 @@ namespace VieCut {
             }
         }
 
+        // same as global_relabeling, but uses a parallel bfs and recomputes
+        // the label counts from the bfs levels
+        template <bool initial>
+        void parallel_global_relabeling(const std::vector<NodeID>& sources,
+                                        NodeID source) {
+            NodeID n = m_G->n();
+            NodeID flow_source = sources[source];
+
+    #pragma omp parallel for schedule(static)
+            for (NodeID v = 0; v < n; ++v) {
+                m_distance[v] = std::max(m_distance[v], n);
+            }
+            m_distance[flow_source] = n;
+
+            std::vector<NodeID> sinks;
+            for (NodeID sink : sources) {
+                if (sink != flow_source) {
+                    sinks.emplace_back(sink);
+                }
+            }
+
+            auto level_sizes = parallel_residual_bfs::run(
+                m_G, sinks, flow_source, n, &m_distance,
+                [this](NodeID v, EdgeID e) -> FlowType {
+                    if constexpr (initial) {
+                        return 1;
+                    } else {
+                        return m_G->getEdgeWeight(v, e) - getEdgeFlow(v, e);
+                    }
+                });
+
+            m_Q.clearCounts();
+            for (size_t l = 0; l < level_sizes.size(); ++l) {
+                m_Q.setCount(l, level_sizes[l]);
+            }
+
+            // almost all vertices that are not reached have label n
+            int at_n = 0;
+    #pragma omp parallel for schedule(static) reduction(+ : at_n)
+            for (NodeID v = 0; v < n; ++v) {
+                if (m_distance[v] == n) {
+                    at_n++;
+                } else if (m_distance[v] > n) {
+                    m_Q.atomicAddLabel(m_distance[v]);
+                }
+            }
+            m_Q.setCount(n, m_Q.count(n) + at_n);
+        }
+
         // push flow from source to target if possible
         void push(NodeID source, EdgeID e, NodeID sourceDistance) {
-            m_pushes++;
+            m_stats.pushes++;
             NodeID target = m_G->getEdgeTarget(source, e);
             if (sourceDistance <= m_distance[target]) [[likely]] return;
 
@@ -154,7 +221,7 @@ namespace VieCut {
 
             if (amount == 0) return;
 
-            m_actual_pushes++;
+            m_stats.actual_pushes++;
 
             EdgeID rev_e = m_G->getReverseEdge(source, e);
             addEdgeFlow(source, e, amount);
@@ -173,22 +240,25 @@ namespace VieCut {
             enqueue(target);
         }
 
-        // put a vertex in the FIFO queue of the global_mincut
+        // put a vertex in the queue of active vertices
         void enqueue(NodeID target) {
-            if (m_active[target]) return;
+            if (m_Q.contains(target)) return;
             if (m_excess[target] > 0) {
-                m_active[target] = true;
                 if constexpr (limited) {
-                    // min heap if limited as first flow faster
-                    // max heap if not for better asymptotic runtime
-                    m_Q.insert(target, (-1) * m_distance[target]);
+                    // lowest label first if limited as first flow faster
+                    // highest label if not for better asymptotic runtime
+                    m_Q.insert(target, numLabels() - 1 - m_distance[target]);
                 } else {
                     m_Q.insert(target, m_distance[target]);
                 }
-                // m_Q.push(target);
             }
         }
 
+        // labels are in [0, 2n]
+        size_t numLabels() {
+            return 2 * static_cast<size_t>(m_G->n()) + 1;
+        }
+
         // try to push as much excess as possible out of the node node
         void discharge(NodeID node) {
             NodeID nodeDistance = m_distance[node];
@@ -200,7 +270,7 @@ namespace VieCut {
             }
 
             if (m_excess[node] > 0) {
-                if (m_count[m_distance[node]] == 1
+                if (m_Q.isGap(m_distance[node])
                     && m_distance[node] < m_G->number_of_nodes()) {
                     // hence this layer will be empty after the relabel step
                     gap_heuristic(m_distance[node]);
@@ -212,12 +282,12 @@ namespace VieCut {
 
         // gap heuristic
         void gap_heuristic(NodeID level) {
-            m_gaps++;
+            m_stats.gaps++;
             for (NodeID node : m_G->nodes()) {
                 if (m_distance[node] < level) continue;
-                m_count[m_distance[node]]--;
-                m_distance[node] = std::max(m_distance[node], m_G->n());
-                m_count[m_distance[node]]++;
+                NodeID new_distance = std::max(m_distance[node], m_G->n());
+                m_Q.moveLabel(m_distance[node], new_distance);
+                m_distance[node] = new_distance;
                 enqueue(node);
             }
         }
@@ -226,9 +296,9 @@ namespace VieCut {
         // neighboring nodes
         void relabel(NodeID node) {
             m_work += WORK_OP_RELABEL;
-            m_num_relabels++;
+            m_stats.relabels++;
 
-            m_count[m_distance[node]]--;
+            NodeID old_distance = m_distance[node];
             m_distance[node] = 2 * m_G->number_of_nodes();
 
             for (EdgeID e : m_G->edges_of(node)) {
@@ -240,7 +310,7 @@ namespace VieCut {
                 m_work++;
             }
 
-            m_count[m_distance[node]]++;
+            m_Q.moveLabel(old_distance, m_distance[node]);
             enqueue(node);
         }
 
@@ -358,20 +428,19 @@ namespace VieCut {
                 // if we have parallel flows on the same graphs,
                 // we can't use edge flows on the graph.
                 // in sequential cases it's faster and flow values
-                // might still be useful outside of this algorithm
-                edge_flow.clear();
+                // might still be useful outside of this algorithm.
+                // the flow vectors of previous calls are reused
+                edge_flow.resize(G->n());
                 for (NodeID n : G->nodes()) {
-                    edge_flow.emplace_back(G->get_first_invalid_edge(n), 0);
+                    edge_flow[n].assign(G->get_first_invalid_edge(n), 0);
                 }
             }
 
             m_G = G;
             m_work = 0;
-            m_num_relabels = 0;
-            m_gaps = 0;
-            m_pushes = 0;
-            m_actual_pushes = 0;
-            m_global_updates = 1;
+            m_stats = flow_statistics();
+            m_stats.flows = 1;
+            m_stats.global_updates = 1;
             m_limit = limit;
             m_limitreached = false;
             m_problemid = problem_id;
@@ -389,21 +458,23 @@ namespace VieCut {
             global_relabeling<true>(sources, curr_source);
 
             double initialTime = t.elapsed();
+            m_stats.time_init = initialTime;
 
             int work_todo = WORK_NODE_TO_EDGES * G->number_of_nodes()
                             + G->number_of_edges();
 
             // main loop
+            timer t_relabel;
             while (!m_Q.empty()) {
-                // NodeID v = m_Q.front();
-                // m_Q.pop();
+                m_stats.peak_active = std::max(m_stats.peak_active,
+                                               static_cast<size_t>(m_Q.size()));
                 NodeID v = m_Q.deleteMax();
-                m_active[v] = false;
                 discharge(v);
 
                 if constexpr (limited) {
                     if (m_limitreached) {
                         double timeAll = t.elapsed();
+                        finishStatistics(initialTime, timeAll);
                         size_t depthPR =
                             configuration::getConfig()->depthOfPartialRelabeling;
                         LOG0 << "RESULT-PR n=" << G->n() << " m=" << G->m()
@@ -419,11 +490,14 @@ namespace VieCut {
                 }
 
                 if (m_work > GLOBAL_UPDATE_FRQ * work_todo) {
+                    t_relabel.restart();
                     global_relabeling(sources, curr_source);
+                    m_stats.time_global_relabel += t_relabel.elapsed();
                     m_work = 0;
-                    m_global_updates++;
+                    m_stats.global_updates++;
                 }
             }
+            double loopTime = t.elapsed();
 
             FlowType total_flow = 0;
             // return value of flow
@@ -439,11 +513,11 @@ namespace VieCut {
                 source_set = computeSourceSet(sources, curr_source);
             }
 
-            LOGC(extended_logs) << "updates " << m_global_updates
-                                << " relabel " << m_num_relabels
-                                << " pushes " << m_pushes;
-
             double timeAll = t.elapsed();
+            finishStatistics(initialTime, loopTime);
+            m_stats.time_source_set = timeAll - loopTime;
+            m_stats.time_total = timeAll;
+            LOGC(extended_logs) << m_stats.toString();
 
             size_t depthPR = configuration::getConfig()->depthOfPartialRelabeling;
             LOG0 << "RESULT-PR n=" << G->n() << " m=" << G->m()
@@ -457,19 +531,27 @@ namespace VieCut {
             return std::make_pair(total_flow, source_set);
         }
 
+        // counters and timings of the last call
+        const flow_statistics& getStatistics() const {
+            return m_stats;
+        }
+
+     private:
+        // sets the discharge time from the time of the main loop
+        void finishStatistics(double initialTime, double loopTime) {
+            m_stats.time_discharge =
+                loopTime - initialTime - m_stats.time_global_relabel;
+            m_stats.time_total = loopTime;
+        }
+
      private:
         std::vector<FlowType> m_excess;
         std::vector<NodeID> m_distance;
-        std::vector<bool> m_active;   // store which nodes are in the queue already
-        std::vector<int> m_count;
-        maxNodeHeap m_Q;
+        // active vertices and number of vertices per label
+        active_set m_Q;
         std::vector<bool> m_bfstouched;
         std::vector<std::vector<FlowType> > edge_flow;
-        int m_num_relabels;
-        int m_gaps;
-        int m_global_updates;
-        int m_pushes;
-        int m_actual_pushes;
+        flow_statistics m_stats;
         int m_work;
         int m_current_iteration;
         NodeID m_sink;
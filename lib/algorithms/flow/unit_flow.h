@@ -30,19 +30,35 @@ namespace VieCut {
         unit_flow() { }
         virtual ~unit_flow() { }
 
-        void init(flow_graph fg, const std::vector<EdgeWeight>& delta_src,
+        // vertex v can absorb up to the sum of its edge capacities
+        void init(flow_graph* fg, const std::vector<EdgeWeight>& delta_src,
                   EdgeWeight unit_cap, NodeID max_height, FlowType w) {
-            m_f.resize(fg.number_of_nodes());
-            m_fg = &fg;
+            std::vector<FlowType> sink(fg->number_of_nodes());
+            for (NodeID n = 0; n < fg->number_of_nodes(); ++n) {
+                sink[n] = fg->getCapacity(n);
+            }
+            init(fg, delta_src, sink, unit_cap, max_height, w);
+        }
+
+        // vertex v starts with delta_src[v] flow and can absorb up to
+        // sink[v]. a vertex can hold at most w * sink[v] flow
+        void init(flow_graph* fg, const std::vector<EdgeWeight>& delta_src,
+                  const std::vector<FlowType>& sink,
+                  EdgeWeight unit_cap, NodeID max_height, FlowType w) {
+            m_f.resize(fg->number_of_nodes());
+            m_fg = fg;
             m_delta_src = delta_src;
+            m_sink = sink;
             m_unit_cap = unit_cap;
             m_max_height = max_height;
             m_w = w;
-            m_current_edge.resize(fg.number_of_nodes(), 0);
-            m_height.resize(fg.number_of_nodes(), 0);
-            for (NodeID n = 0; n < fg.number_of_nodes(); ++n) {
+            m_current_edge.resize(fg->number_of_nodes(), 0);
+            m_height.assign(fg->number_of_nodes(), 0);
+            Q = decltype(Q)();
+            for (NodeID n = 0; n < fg->number_of_nodes(); ++n) {
+                m_current_edge[n] = fg->first_arc(n);
                 m_f[n] = delta_src[n];
-                if (delta_src[n] > (EdgeWeight)fg.getCapacity(n)) {
+                if (delta_src[n] > (EdgeWeight)m_sink[n]) {
                     LOG << "Inserting" << n;
                     Q.push(std::make_pair(0, n));
                 }
@@ -78,7 +94,7 @@ namespace VieCut {
         }
 
         FlowType excess(NodeID v) {
-            return std::max(m_f[v] - m_fg->getCapacity(v), (FlowType)0);
+            return std::max(m_f[v] - m_sink[v], (FlowType)0);
         }
 
         FlowType flow(NodeID v) {
@@ -97,39 +113,38 @@ namespace VieCut {
             }
         };
 
-        bool applicable(NodeID v, EdgeID e) {
-            NodeID tgt = m_fg->getEdgeTarget(v, e);
+        // a is an arc of v in m_fg
+        bool admissible(NodeID v, EdgeID a) {
+            NodeID tgt = m_fg->arcTarget(a);
             return (excess(v) > 0)
                    && (m_height[v] == m_height[tgt] + 1)
-                   && (m_fg->getEdgeCapacity(v, e) > m_fg->getEdgeFlow(v, e))
-                   && (m_f[tgt] < m_w * m_fg->getCapacity(tgt));
+                   && (m_fg->arcCapacity(a) > m_fg->arcFlow(a));
+        }
+
+        bool full(NodeID v) {
+            return m_f[v] >= m_w * m_sink[v];
         }
 
-        void push(NodeID v, EdgeID e) {
+        void push(NodeID v, EdgeID a) {
             ++pushCtr;
-            NodeID tgt = m_fg->getEdgeTarget(v, e);
+            NodeID tgt = m_fg->arcTarget(a);
             LOG << "pushing from " << v << " to " << tgt;
-            FlowType flow = m_fg->getEdgeFlow(v, e);
-            assert(m_f[tgt] < m_w * m_fg->getCapacity(tgt));
+            FlowType flow = m_fg->arcFlow(a);
+            assert(!full(tgt));
             EdgeWeight supply = std::min(excess(v), std::min(
-                                             m_fg->getEdgeCapacity(v, e) - flow,
-                                             (m_w * m_fg->getCapacity(tgt))
+                                             m_fg->arcCapacity(a) - flow,
+                                             (m_w * m_sink[tgt])
                                              - m_f[tgt]));
 
-            EdgeID rev = m_fg->getReverseEdge(v, e);
-            m_fg->setEdgeFlow(v, e, flow + supply);
-            m_fg->setEdgeFlow(tgt, rev, m_fg->getEdgeFlow(tgt, rev) - supply);
+            EdgeID rev = m_fg->reverseArc(a);
+            m_fg->setArcFlow(a, flow + supply);
+            m_fg->setArcFlow(rev, m_fg->arcFlow(rev) - supply);
             m_f[v] -= supply;
             bool active_before = active(tgt);
             m_f[tgt] += supply;
 
             if (!active(v)) {
-                if (!Q.empty()) {
-                    m_v = Q.top().second;
-                    Q.pop();
-                } else {
-                    done = true;
-                }
+                nextVertex();
             }
 
             if (!active_before && active(tgt)) {
@@ -152,41 +167,53 @@ namespace VieCut {
             LOG << "Relabel " << v;
             assert(active(v));
 
-            for (EdgeID e : m_fg->edges_of(v)) {
-                assert(m_fg->getEdgeFlow(v, e) == m_fg->getEdgeCapacity(v, e) ||
-                       m_height[v] <= m_height[m_fg->getEdgeTarget(v, e)] ||
-                       m_fg->getEdgeCapacity(v, e) == 0);
-                LOG0 << e;
+            for (EdgeID a : m_fg->arcs_of(v)) {
+                assert(m_fg->arcFlow(a) == m_fg->arcCapacity(a) ||
+                       m_height[v] <= m_height[m_fg->arcTarget(a)] ||
+                       m_fg->arcCapacity(a) == 0 ||
+                       full(m_fg->arcTarget(a)));
+                LOG0 << a;
             }
             ++m_height[v];
             if (m_height[v] < m_max_height) {
                 Q.push(std::make_pair(m_height[v], v));
             }
 
-            if (!Q.empty()) {
-                m_v = Q.top().second;
-                Q.pop();
-            } else {
-                done = true;
-            }
+            nextVertex();
         }
 
         void pushRelabel(NodeID v) {
             LOG << "PushRelabel " << v;
-            EdgeID e = m_current_edge[v];
-            if (m_fg->get_first_invalid_edge(v)) {
-                if (applicable(v, e)) {
-                    push(v, e);
+            EdgeID a = m_current_edge[v];
+            if (m_fg->first_arc(v) < m_fg->first_invalid_arc(v)) {
+                bool adm = admissible(v, a);
+                if (adm && !full(m_fg->arcTarget(a))) {
+                    push(v, a);
+                } else if (adm && active(m_fg->arcTarget(a))) {
+                    // the target has a lower label and is active, it has
+                    // to be discharged before v can push to it or relabel
+                    Q.push(std::make_pair(m_height[v], v));
+                    nextVertex();
                 } else {
-                    if (m_height[v] && e + 1 < m_fg->get_first_invalid_edge(v)) {
+                    if (m_height[v] && a + 1 < m_fg->first_invalid_arc(v)) {
                         ++m_current_edge[v];
                     } else {
                         relabel(v);
-                        m_current_edge[v] = 0;
+                        m_current_edge[v] = m_fg->first_arc(v);
                     }
                 }
             } else {
+                // v has no edges and keeps its excess
+                nextVertex();
+            }
+        }
+
+        void nextVertex() {
+            if (!Q.empty()) {
+                m_v = Q.top().second;
                 Q.pop();
+            } else {
+                done = true;
             }
         }
 
@@ -197,6 +224,7 @@ namespace VieCut {
         std::vector<EdgeID> m_current_edge;
         std::vector<NodeID> m_height;
         std::vector<FlowType> m_f;
+        std::vector<FlowType> m_sink;
         flow_graph* m_fg;
         std::vector<EdgeWeight> m_delta_src;
         EdgeWeight m_unit_cap;
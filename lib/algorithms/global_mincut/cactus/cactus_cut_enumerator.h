@@ -0,0 +1,413 @@
+/******************************************************************************
+ * cactus_cut_enumerator.h
+ *
+ * Source of VieCut
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "common/definitions.h"
+#include "data_structure/compact_cactus.h"
+#include "data_structure/mutable_graph.h"
+
+namespace VieCut {
+    // Enumerates all minimum cuts represented by a cactus without
+    // materializing them.
+    //
+    // We root the cactus and lay out the vertices of the original graph in
+    // preorder, where the children of a cactus node are its tree children,
+    // followed by the other nodes of each cycle it is the top of, in cycle
+    // order. Then the side of every minimum cut which does not contain the
+    // root is a contiguous range in this order:
+    //  - tree edge to child c: the subtree of c,
+    //  - cycle edges i and j of a cycle with top c_0: the subtrees of
+    //    c_{i+1}, ..., c_j, which are laid out consecutively.
+    // Each cut is therefore given by two positions, and stepping to the next
+    // cut is O(1). Cuts with an empty side (from empty cactus nodes) are
+    // skipped.
+    class cactus_cut_enumerator {
+     public:
+        static constexpr bool debug = false;
+
+        struct cut {
+            NodeID begin;
+            NodeID end;
+        };
+
+        class cut_iterator {
+         public:
+            cut_iterator(const cactus_cut_enumerator* e, size_t structure,
+                         NodeID i, NodeID j)
+                : m_e(e), m_structure(structure), m_i(i), m_j(j) {
+                skipInvalid();
+            }
+
+            cut operator * () const {
+                return m_e->cutAt(m_structure, m_i, m_j);
+            }
+
+            cut_iterator& operator ++ () {  // NOLINT
+                advance();
+                skipInvalid();
+                return *this;
+            }
+
+            bool operator != (const cut_iterator& o) const {
+                return m_structure != o.m_structure
+                       || m_i != o.m_i || m_j != o.m_j;
+            }
+
+            bool operator == (const cut_iterator& o) const {
+                return !(*this != o);
+            }
+
+         private:
+            // structures are all tree edges and then all cycles. in a cycle
+            // with k boundaries, (i, j) iterates over 0 <= i < j < k
+            void advance() {
+                if (m_structure < m_e->numTreeEdges()) {
+                    ++m_structure;
+                    return;
+                }
+                size_t c = m_structure - m_e->numTreeEdges();
+                NodeID k = m_e->cycleBoundaries(c);
+                if (++m_j == k) {
+                    if (++m_i == k - 1) {
+                        ++m_structure;
+                        m_i = 0;
+                    }
+                    m_j = m_i + 1;
+                }
+            }
+
+            void skipInvalid() {
+                while (m_structure < m_e->numStructures()
+                       && !m_e->isProperCut(
+                           m_e->cutAt(m_structure, m_i, m_j))) {
+                    advance();
+                }
+                if (m_structure >= m_e->numStructures()) {
+                    m_structure = m_e->numStructures();
+                    m_i = 0;
+                    m_j = 0;
+                }
+            }
+
+            const cactus_cut_enumerator* m_e;
+            size_t m_structure;
+            NodeID m_i;
+            NodeID m_j;
+        };
+
+        explicit cactus_cut_enumerator(compactCactusPtr cactus)
+            : m_cactus(cactus) {
+            buildLayout();
+        }
+
+        cactus_cut_enumerator(mutableGraphPtr cactus, EdgeWeight mincut)
+            : cactus_cut_enumerator(
+                  compact_cactus::fromMutableGraph(cactus, mincut)) { }
+
+        cut_iterator begin() const {
+            return cut_iterator(this, 0, 0, 0);
+        }
+
+        cut_iterator end() const {
+            return cut_iterator(this, numStructures(), 0, 0);
+        }
+
+        // number of cut representations in the cactus, including the ones
+        // with an empty side which are skipped by the iterator
+        size_t numCutRepresentations() const {
+            return numTreeEdges() + m_cycle_cut_prefix.back();
+        }
+
+        // decodes the index-th cut representation in O(log #cycles + k),
+        // used to split the enumeration between threads
+        cut getCut(size_t index) const {
+            auto [structure, i, j] = decode(index);
+            return cutAt(structure, i, j);
+        }
+
+        template <typename F>
+        void forEachCut(F f) const {
+            for (const cut& c : *this) {
+                f(c);
+            }
+        }
+
+        // calls f(cut, thread_id) for every minimum cut. the cut representations
+        // are split into contiguous chunks, each thread seeks to the start of
+        // its chunk once and then steps through it in O(1) per cut
+        template <typename F>
+        void parallelForEachCut(F f) const {
+            size_t total = numCutRepresentations();
+    #pragma omp parallel
+            {
+                size_t num_threads = omp_get_num_threads();
+                size_t id = omp_get_thread_num();
+                size_t chunk = (total + num_threads - 1) / num_threads;
+                size_t begin = std::min(total, id * chunk);
+                size_t end = std::min(total, begin + chunk);
+
+                if (begin < end) {
+                    auto [structure, i, j] = decode(begin);
+                    cut_iterator it(this, structure, i, j);
+                    auto [s_end, i_end, j_end] = decode(end);
+                    cut_iterator stop(this, s_end, i_end, j_end);
+                    for ( ; it != stop && it != this->end(); ++it) {
+                        f(*it, id);
+                    }
+                }
+            }
+        }
+
+        // side of the cut which does not contain the root of the cactus
+        compact_cactus::vertex_range vertices(const cut& c) const {
+            return compact_cactus::vertex_range(m_order.data() + c.begin,
+                                                m_order.data() + c.end);
+        }
+
+        // O(1) membership test, i.e. a bitset view on the cut
+        bool contains(const cut& c, NodeID v) const {
+            return m_position[v] >= c.begin && m_position[v] < c.end;
+        }
+
+        bool isProperCut(const cut& c) const {
+            return c.begin < c.end && c.end - c.begin < m_order.size();
+        }
+
+        // original vertices in layout order and the position of each vertex
+        const std::vector<NodeID>& getOrder() const {
+            return m_order;
+        }
+
+        NodeID getPosition(NodeID v) const {
+            return m_position[v];
+        }
+
+        compactCactusPtr getCactus() const {
+            return m_cactus;
+        }
+
+        size_t numTreeEdges() const {
+            return m_tree_begin.size();
+        }
+
+        size_t numCycles() const {
+            return m_cycle_start.size() - 1;
+        }
+
+        size_t numStructures() const {
+            return numTreeEdges() + numCycles();
+        }
+
+        // positions b_0 < ... < b_{k-1} of a cycle with k nodes, the cut of
+        // cycle edges i and j is [b_i, b_j)
+        NodeID cycleBoundaries(size_t c) const {
+            return m_cycle_start[c + 1] - m_cycle_start[c];
+        }
+
+        NodeID cycleBoundary(size_t c, NodeID i) const {
+            return m_cycle_bounds[m_cycle_start[c] + i];
+        }
+
+        cut cutAt(size_t structure, NodeID i, NodeID j) const {
+            if (structure < numTreeEdges()) {
+                return cut { m_tree_begin[structure], m_tree_end[structure] };
+            }
+            size_t c = structure - numTreeEdges();
+            return cut { cycleBoundary(c, i), cycleBoundary(c, j) };
+        }
+
+     private:
+        std::tuple<size_t, NodeID, NodeID> decode(size_t index) const {
+            if (index < numTreeEdges()) {
+                return std::make_tuple(index, 0, 0);
+            }
+            index -= numTreeEdges();
+            if (index >= m_cycle_cut_prefix.back()) {
+                return std::make_tuple(numStructures(), 0, 0);
+            }
+            size_t c = std::upper_bound(m_cycle_cut_prefix.begin(),
+                                        m_cycle_cut_prefix.end(), index)
+                       - m_cycle_cut_prefix.begin() - 1;
+            index -= m_cycle_cut_prefix[c];
+            NodeID k = cycleBoundaries(c);
+            NodeID i = 0;
+            while (index >= k - 1 - i) {
+                index -= k - 1 - i;
+                ++i;
+            }
+            return std::make_tuple(numTreeEdges() + c, i, i + 1 + index);
+        }
+
+        void buildLayout() {
+            const compact_cactus& C = *m_cactus;
+            NodeID n = C.n();
+
+            // incident structures of each cactus node as CSR.
+            // structure s < #tree edges is a tree edge, otherwise a cycle
+            std::vector<EdgeID> inc_start(n + 1, 0);
+            for (size_t e = 0; e < C.numTreeEdges(); ++e) {
+                auto [s, t] = C.getTreeEdge(e);
+                ++inc_start[s + 1];
+                ++inc_start[t + 1];
+            }
+            for (size_t c = 0; c < C.numCycles(); ++c) {
+                for (NodeID v : C.getCycle(c)) {
+                    ++inc_start[v + 1];
+                }
+            }
+            for (NodeID v = 0; v < n; ++v) {
+                inc_start[v + 1] += inc_start[v];
+            }
+            std::vector<size_t> incident(inc_start.back());
+            std::vector<EdgeID> next(inc_start.begin(), inc_start.end() - 1);
+            for (size_t e = 0; e < C.numTreeEdges(); ++e) {
+                auto [s, t] = C.getTreeEdge(e);
+                incident[next[s]++] = e;
+                incident[next[t]++] = e;
+            }
+            for (size_t c = 0; c < C.numCycles(); ++c) {
+                for (NodeID v : C.getCycle(c)) {
+                    incident[next[v]++] = C.numTreeEdges() + c;
+                }
+            }
+
+            // root every connected component, find children of every node
+            // (tree children and non-top nodes of cycles, in cycle order)
+            std::vector<bool> structure_done(
+                C.numTreeEdges() + C.numCycles(), false);
+            std::vector<NodeID> parent(n, UNDEFINED_NODE);
+            std::vector<std::vector<NodeID> > children(n);
+            std::vector<NodeID> roots;
+            std::vector<NodeID> bfs_order;
+            std::vector<std::pair<size_t, NodeID> > cycle_tops;
+            bfs_order.reserve(n);
+
+            for (NodeID r = 0; r < n; ++r) {
+                if (parent[r] != UNDEFINED_NODE)
+                    continue;
+                parent[r] = r;
+                roots.emplace_back(r);
+                size_t head = bfs_order.size();
+                bfs_order.emplace_back(r);
+                while (head < bfs_order.size()) {
+                    NodeID v = bfs_order[head++];
+                    for (EdgeID i = inc_start[v]; i < inc_start[v + 1]; ++i) {
+                        size_t s = incident[i];
+                        if (structure_done[s])
+                            continue;
+                        structure_done[s] = true;
+                        if (s < C.numTreeEdges()) {
+                            auto [src, tgt] = C.getTreeEdge(s);
+                            NodeID child = (src == v) ? tgt : src;
+                            parent[child] = v;
+                            children[v].emplace_back(child);
+                            bfs_order.emplace_back(child);
+                        } else {
+                            size_t c = s - C.numTreeEdges();
+                            auto cyc = C.getCycle(c);
+                            size_t k = cyc.size();
+                            size_t top = std::find(cyc.begin(), cyc.end(), v)
+                                         - cyc.begin();
+                            cycle_tops.emplace_back(c, v);
+                            for (size_t l = 1; l < k; ++l) {
+                                NodeID child = cyc.begin()[(top + l) % k];
+                                parent[child] = v;
+                                children[v].emplace_back(child);
+                                bfs_order.emplace_back(child);
+                            }
+                        }
+                    }
+                }
+            }
+
+            // subtree sizes bottom-up, then positions top-down
+            std::vector<NodeID> subtree(n, 0);
+            for (size_t i = bfs_order.size(); i-- > 0; ) {
+                NodeID v = bfs_order[i];
+                subtree[v] += C.numContainedVertices(v);
+                if (parent[v] != v) {
+                    subtree[parent[v]] += subtree[v];
+                }
+            }
+
+            std::vector<NodeID> start(n, 0);
+            NodeID offset = 0;
+            for (NodeID r : roots) {
+                start[r] = offset;
+                offset += subtree[r];
+            }
+            for (NodeID v : bfs_order) {
+                NodeID child_start = start[v] + C.numContainedVertices(v);
+                for (NodeID c : children[v]) {
+                    start[c] = child_start;
+                    child_start += subtree[c];
+                }
+            }
+
+            m_order.resize(C.numVertices());
+            m_position.resize(C.numVertices());
+            for (NodeID v = 0; v < n; ++v) {
+                NodeID pos = start[v];
+                for (NodeID x : C.containedVertices(v)) {
+                    m_order[pos] = x;
+                    m_position[x] = pos;
+                    ++pos;
+                }
+            }
+
+            for (size_t e = 0; e < C.numTreeEdges(); ++e) {
+                auto [s, t] = C.getTreeEdge(e);
+                NodeID child = (parent[t] == s) ? t : s;
+                m_tree_begin.emplace_back(start[child]);
+                m_tree_end.emplace_back(start[child] + subtree[child]);
+            }
+
+            m_cycle_start.assign(1, 0);
+            m_cycle_cut_prefix.assign(1, 0);
+            std::sort(cycle_tops.begin(), cycle_tops.end());
+            for (auto [c, top] : cycle_tops) {
+                auto cyc = C.getCycle(c);
+                size_t k = cyc.size();
+                size_t t = std::find(cyc.begin(), cyc.end(), top) - cyc.begin();
+                NodeID last = cyc.begin()[(t + k - 1) % k];
+                for (size_t l = 1; l < k; ++l) {
+                    m_cycle_bounds.emplace_back(start[cyc.begin()[(t + l) % k]]);
+                }
+                m_cycle_bounds.emplace_back(start[last] + subtree[last]);
+                m_cycle_start.emplace_back(m_cycle_bounds.size());
+                m_cycle_cut_prefix.emplace_back(
+                    m_cycle_cut_prefix.back() + k * (k - 1) / 2);
+            }
+
+            LOG << "cactus_cut_enumerator: " << numTreeEdges()
+                << " tree edges, " << numCycles() << " cycles, "
+                << numCutRepresentations() << " cuts";
+        }
+
+        compactCactusPtr m_cactus;
+        std::vector<NodeID> m_order;
+        std::vector<NodeID> m_position;
+        std::vector<NodeID> m_tree_begin;
+        std::vector<NodeID> m_tree_end;
+        std::vector<EdgeID> m_cycle_start;
+        std::vector<NodeID> m_cycle_bounds;
+        std::vector<size_t> m_cycle_cut_prefix;
+    };
+}
@@ -23,12 +23,14 @@
 #include <utility>
 #include <vector>
 
+#include "algorithms/flow/flow_statistics.h"
 #include "algorithms/global_mincut/cactus/most_balanced_minimum_cut.h"
 #include "algorithms/global_mincut/cactus/recursive_cactus.h"
 #include "algorithms/global_mincut/minimum_cut.h"
 #include "algorithms/global_mincut/noi_minimum_cut.h"
 #include "algorithms/global_mincut/viecut.h"
 #include "common/definitions.h"
+#include "data_structure/compact_cactus.h"
 #include "data_structure/graph_access.h"
 #include "data_structure/mutable_graph.h"
 #include "data_structure/priority_queues/maxNodeHeap.h"
@@ -170,6 +172,7 @@ namespace VieCut {
 
             rc.setMincut(mincut);
             auto out_graph = rc.flowMincut(graphs);  // This is the cactus graph!
+            flow_stats.add(rc.getFlowStatistics());
 
             minimum_cut_helpers<GraphPtr>::setVertexLocations(
                 out_graph, graphs, ge_ids, guaranteed_edges, mincut);
@@ -186,8 +189,23 @@ namespace VieCut {
     	    _write_cactus_graphml_file(out_graph, configuration::getConfig()->cactus_filename);
     	}
 
+            if (configuration::getConfig()->cactus_binary_filename != "") {
+                auto C = compact_cactus::fromMutableGraph(out_graph, mincut);
+                C->setGraph(graphs[0]);
+                C->writeBinary(
+                    configuration::getConfig()->cactus_binary_filename);
+            }
+
             return std::make_tuple(mincut, out_graph, mb_edges);
         }
+
+        // flow statistics of all cactus computations of this object
+        const flow_statistics& getFlowStatistics() const {
+            return flow_stats;
+        }
+
+     private:
+        flow_statistics flow_stats;
     };
 
 
@@ -12,12 +12,11 @@
 #pragma once
 
 #include <memory>
-#include <queue>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
-#include "algorithms/global_mincut/cactus/balanced_cut_dfs.h"
+#include "algorithms/global_mincut/cactus/parallel_balanced_cut.h"
 #include "common/configuration.h"
 #include "data_structure/mutable_graph.h"
 #include "io/graph_io.h"
@@ -45,47 +44,21 @@ namespace VieCut {
                 return originalBestcutEdges;
             }
 
-            balanced_cut_dfs dfs(original_graph, G, mincut);
-            auto [n1, e1, n2, e2, bestcutInCycle] = dfs.runDFS();
+            parallel_balanced_cut<GraphPtr> pbc(original_graph, G, mincut);
+            auto bestcut = pbc.findBalancedCut();
 
             if (!configuration::getConfig()->set_node_in_cut) {
                 return std::vector<std::pair<NodeID, EdgeID> > { };
             }
 
-            NodeID rev_n1 = G->getEdgeTarget(n1, e1);
-            NodeID rev_n2 = G->getEdgeTarget(n2, e2);
-
+            // we set the side of the most balanced cut that does not contain
+            // the cactus root to inCut, it is a range of the enumerator order
             for (NodeID n : original_graph->nodes()) {
                 original_graph->setNodeInCut(n, false);
             }
 
-            std::queue<NodeID> q;
-            std::vector<bool> checked(G->n(), false);
-            q.push(n1);
-            checked[n1] = true;
-            if (n1 != n2) {
-                q.push(n2);
-                checked[n2] = true;
-            }
-            // we want to set one side of most balanced cut to inCut
-            // setting the targets of the edges to true makes sure the bfs doesn't
-            // go into other side of most balanced cut
-            checked[rev_n1] = true;
-            checked[rev_n2] = true;
-
-            while (!q.empty()) {
-                NodeID top = q.front();
-                q.pop();
-                for (NodeID v : G->containedVertices(top)) {
-                    original_graph->setNodeInCut(v, true);
-                }
-                for (EdgeID e : G->edges_of(top)) {
-                    NodeID t = G->getEdgeTarget(top, e);
-                    if (!checked[t]) {
-                        q.push(t);
-                        checked[t] = true;
-                    }
-                }
+            for (NodeID v : pbc.getEnumerator().vertices(bestcut)) {
+                original_graph->setNodeInCut(v, true);
             }
 
             for (NodeID on : original_graph->nodes()) {
@@ -98,9 +71,6 @@ namespace VieCut {
                 }
             }
 
-            if (bestcutInCycle)
-                LOG0 << "bestcut is in cycle";
-
             if (configuration::getConfig()->output_path != "") {
                 LOG1 << "Printing output to file "
                      << configuration::getConfig()->output_path;
@@ -0,0 +1,192 @@
+/******************************************************************************
+ * parallel_balanced_cut.h
+ *
+ * Source of VieCut
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "algorithms/global_mincut/cactus/cactus_cut_enumerator.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+
+namespace VieCut {
+    // Finds the most balanced (or lowest conductance) minimum cut in a cactus.
+    //
+    // In the vertex order of cactus_cut_enumerator, one side of every minimum
+    // cut is a contiguous range, so a parallel prefix sum over the vertex
+    // weights gives the weight of every side in O(1). The best tree edge is
+    // found by a parallel reduction, for every cycle the best pair of edges is
+    // found with two pointers in O(cycle length), cycles are processed in
+    // parallel.
+    template <class GraphPtr>
+    class parallel_balanced_cut {
+     public:
+        static constexpr bool debug = false;
+        typedef cactus_cut_enumerator::cut cut;
+
+        parallel_balanced_cut(GraphPtr original_graph,
+                              mutableGraphPtr G, EdgeWeight mincut)
+            : original_graph(original_graph),
+              enumerator(G, mincut),
+              optimize_conductance(
+                  configuration::getConfig()->find_lowest_conductance) { }
+
+        cut findBalancedCut() {
+            computePrefixSums();
+            best = candidate { 0, cut { 0, 0 } };
+
+    #pragma omp parallel
+            {
+                candidate local { 0, cut { 0, 0 } };
+    #pragma omp for schedule(static) nowait
+                for (size_t e = 0; e < enumerator.numTreeEdges(); ++e) {
+                    consider(&local, enumerator.cutAt(e, 0, 0));
+                }
+
+    #pragma omp for schedule(dynamic, 16)
+                for (size_t c = 0; c < enumerator.numCycles(); ++c) {
+                    bestInCycle(&local, c);
+                }
+
+    #pragma omp critical
+                {
+                    if (isBetter(local, best)) {
+                        best = local;
+                    }
+                }
+            }
+
+            LOG1 << "Most balanced cut has weight "
+                 << best.weight << " on the lighter side and "
+                 << totalWeight() - best.weight << " on the heavier side";
+            return best.c;
+        }
+
+        EdgeWeight totalWeight() const {
+            return prefix.back();
+        }
+
+        EdgeWeight sideWeight(const cut& c) const {
+            return prefix[c.end] - prefix[c.begin];
+        }
+
+        EdgeWeight lighterBlock(const cut& c) const {
+            EdgeWeight w = sideWeight(c);
+            return std::min(w, totalWeight() - w);
+        }
+
+        const cactus_cut_enumerator& getEnumerator() const {
+            return enumerator;
+        }
+
+     private:
+        struct candidate {
+            EdgeWeight weight;
+            cut c;
+        };
+
+        static bool isBetter(const candidate& a, const candidate& b) {
+            // break ties deterministically, so result is independent of
+            // number of threads
+            return std::make_tuple(a.weight, b.c.begin, b.c.end)
+                   > std::make_tuple(b.weight, a.c.begin, a.c.end);
+        }
+
+        void consider(candidate* local, const cut& c) {
+            if (!enumerator.isProperCut(c))
+                return;
+            candidate cand { lighterBlock(c), c };
+            if (isBetter(cand, *local)) {
+                *local = cand;
+            }
+        }
+
+        // for fixed i the side weight of [b_i, b_j) grows with j, so the best
+        // j is around the point where it crosses half of the total weight.
+        // this point only moves forward with increasing i.
+        void bestInCycle(candidate* local, size_t c) {
+            NodeID k = enumerator.cycleBoundaries(c);
+            NodeID j = 1;
+            for (NodeID i = 0; i + 1 < k; ++i) {
+                j = std::max(j, i + 1);
+                while (j + 1 < k && 2 * sideWeight(cycleCut(c, i, j))
+                       < totalWeight()) {
+                    ++j;
+                }
+                consider(local, cycleCut(c, i, j));
+                if (j > i + 1) {
+                    consider(local, cycleCut(c, i, j - 1));
+                }
+            }
+        }
+
+        cut cycleCut(size_t c, NodeID i, NodeID j) const {
+            return enumerator.cutAt(enumerator.numTreeEdges() + c, i, j);
+        }
+
+        EdgeWeight vertexWeight(NodeID v) const {
+            if (optimize_conductance) {
+                return original_graph->getWeightedNodeDegree(v);
+            } else {
+                return 1;
+            }
+        }
+
+        void computePrefixSums() {
+            const std::vector<NodeID>& order = enumerator.getOrder();
+            size_t n = order.size();
+            prefix.resize(n + 1);
+            prefix[0] = 0;
+            std::vector<EdgeWeight> block_sum;
+
+    #pragma omp parallel
+            {
+                size_t num_threads = omp_get_num_threads();
+                size_t id = omp_get_thread_num();
+    #pragma omp single
+                block_sum.resize(num_threads + 1, 0);
+
+                size_t chunk = (n + num_threads - 1) / num_threads;
+                size_t begin = std::min(n, id * chunk);
+                size_t end = std::min(n, begin + chunk);
+                EdgeWeight sum = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    sum += vertexWeight(order[i]);
+                    prefix[i + 1] = sum;
+                }
+                block_sum[id + 1] = sum;
+    #pragma omp barrier
+    #pragma omp single
+                {
+                    for (size_t t = 0; t < num_threads; ++t) {
+                        block_sum[t + 1] += block_sum[t];
+                    }
+                }
+
+                for (size_t i = begin; i < end; ++i) {
+                    prefix[i + 1] += block_sum[id];
+                }
+            }
+        }
+
+        GraphPtr original_graph;
+        cactus_cut_enumerator enumerator;
+        bool optimize_conductance;
+        std::vector<EdgeWeight> prefix;
+        candidate best;
+    };
+}
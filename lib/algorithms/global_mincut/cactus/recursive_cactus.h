@@ -22,6 +22,7 @@
 #include <utility>
 #include <vector>
 
+#include "algorithms/flow/flow_statistics.h"
 #include "algorithms/flow/push_relabel.h"
 #include "algorithms/global_mincut/cactus/all_cut_local_red.h"
 #include "algorithms/global_mincut/cactus/graph_modification.h"
@@ -96,6 +97,11 @@ namespace VieCut {
             return STCactus;
         }
 
+        // statistics of all flows computed by this object
+        const flow_statistics& getFlowStatistics() const {
+            return flow_stats;
+        }
+
      private:
         mutableGraphPtr recursiveCactus(
             mutableGraphPtr G, size_t depth) {
@@ -157,6 +163,7 @@ namespace VieCut {
                 problem_id++;
                 max_flow = pr.solve_max_flow_min_cut(
                     G, vtcs, 0, false, false, problem_id).first;
+                flow_stats.add(pr.getStatistics());
             }
 
             if (max_flow > (FlowType)mincut) {
@@ -615,5 +622,6 @@ namespace VieCut {
         timer t;
         EdgeWeight mincut;
         size_t problem_id;
+        flow_statistics flow_stats;
     };
 }
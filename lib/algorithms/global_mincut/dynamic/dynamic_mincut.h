@@ -21,8 +21,11 @@
 #include "algorithms/global_mincut/cactus/cactus_mincut.h"
 #endif
 
+#include "algorithms/flow/bounded_flow.h"
+#include "algorithms/flow/flow_statistics.h"
 #include "algorithms/global_mincut/dynamic/cactus_path.h"
 #include "common/definitions.h"
+#include "data_structure/compact_cactus.h"
 #include "data_structure/mutable_graph.h"
 #include "tlx/logger.hpp"
 #include "tools/timer.h"
@@ -44,7 +47,8 @@ namespace VieCut {
         std::vector<std::vector<std::tuple<NodeID, NodeID, EdgeWeight> > >
         cachedInserts;
         std::vector<bool> currentlyCaching;
-        push_relabel<true, false> pr;
+        bounded_flow bf;
+        flow_statistics flow_stats;
 
     #ifdef PARALLEL
         parallel_cactus<mutableGraphPtr> cactus;
@@ -74,6 +78,28 @@ namespace VieCut {
             return cut;
         }
 
+        // initialize from a previously computed cactus (e.g. loaded from disk
+        // with compact_cactus::readBinary) without calling the static algorithm
+        EdgeWeight initialize(mutableGraphPtr graph, compactCactusPtr cached) {
+            if (!cached || !cached->matchesGraph(graph)) {
+                LOG1 << "Warning: cached cactus does not match graph, "
+                     << "computing cactus from scratch";
+                return initialize(graph);
+            }
+            timer t;
+            numCachedMincuts = 0;
+            callsOfStaticAlgorithm = 0;
+            lowestCachedMincut = UNDEFINED_EDGE;
+            original_graph = graph;
+            out_cactus = cached->toMutableGraph();
+            current_cut = cached->getMincut();
+            flow_problem_id = random_functions::next();
+            LOGC(verbose) << "initialize from cache t " << t.elapsed()
+                          << " cut " << current_cut
+                          << " cactus_vtcs " << out_cactus->n();
+            return current_cut;
+        }
+
         void checkCacheAndRecompute() {
             EdgeWeight mincut = UNDEFINED_NODE;
             if (lowestCachedMincut != UNDEFINED_EDGE) {
@@ -283,17 +309,20 @@ namespace VieCut {
                 putIntoCache(out_cactus, current_cut);
                 size_t fpid = flow_problem_id++;
                 recursive_cactus<mutableGraphPtr> rc;
-                size_t flow = pr.solve_max_flow_min_cut(
-                    original_graph, { s, t }, 0, false, current_cut, fpid).first;
+                size_t flow = bf.flowUpTo(
+                    original_graph, s, { t }, current_cut, fpid);
+                flow_stats.add(bf.getStatistics());
 
                 auto new_g = rc.decrementalRebuild(original_graph, s, flow, fpid);
                 current_cut = flow;
                 out_cactus = new_g;
             } else {
                 size_t fp = flow_problem_id++;
-                auto [flow, sourceset] = pr.solve_max_flow_min_cut(
-                    original_graph, { s, t }, 0, false,
-                    current_cut, fp);
+                // only need to know whether the connectivity of s and t
+                // is still at least the minimum cut
+                FlowType flow = bf.flowUpTo(
+                    original_graph, s, { t }, current_cut, fp);
+                flow_stats.add(bf.getStatistics());
                 if (static_cast<EdgeWeight>(flow) < current_cut) {
                     putIntoCache(out_cactus, current_cut);
                     recursive_cactus<mutableGraphPtr> rc;
@@ -322,6 +351,12 @@ namespace VieCut {
             return out_cactus;
         }
 
+        compactCactusPtr getCompactCactus() {
+            auto C = compact_cactus::fromMutableGraph(out_cactus, current_cut);
+            C->setGraph(original_graph);
+            return C;
+        }
+
         size_t getCallsOfStaticAlgorithm() {
             return callsOfStaticAlgorithm;
         }
@@ -330,6 +365,14 @@ namespace VieCut {
             return current_cut;
         }
 
+        // statistics of all flows, i.e. the connectivity queries on edge
+        // deletions and the flows of all (re-)computations of the cactus
+        flow_statistics getFlowStatistics() const {
+            flow_statistics stats = flow_stats;
+            stats.add(cactus.getFlowStatistics());
+            return stats;
+        }
+
         void putIntoCache(mutableGraphPtr cactusToCache, EdgeWeight cactusCut) {
             numCachedMincuts++;
             if (cactusCut < lowestCachedMincut) {
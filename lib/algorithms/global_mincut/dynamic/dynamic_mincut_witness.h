@@ -0,0 +1,286 @@
+/******************************************************************************
+ * dynamic_mincut_witness.h
+ *
+ * Source of VieCut
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#ifdef PARALLEL
+#include "parallel/algorithm/parallel_cactus.h"
+#else
+#include "algorithms/global_mincut/cactus/cactus_mincut.h"
+#endif
+
+#include "algorithms/flow/bounded_flow.h"
+#include "algorithms/global_mincut/noi_minimum_cut.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+
+namespace VieCut {
+    // Lightweight variant of dynamic_mincut that only maintains the minimum
+    // cut value and a single witness cut instead of the cactus of all
+    // minimum cuts. The cactus is only built when requested.
+    //
+    // As edge insertions never decrease the minimum cut, the last verified
+    // minimum cut value is a lower bound, and the witness is an upper bound.
+    // Inserting an edge that does not cross the witness therefore does not
+    // change the minimum cut and is handled in O(1). If it crosses the
+    // witness, the witness is marked as outdated and only revalidated when
+    // the cut is queried, with a few flows bounded by the witness weight
+    // and the static algorithm only if they do not find a minimum cut.
+    // Edge deletions are revalidated immediately with a flow bounded by
+    // the current minimum cut value.
+    //
+    // Requires configuration::getConfig()->save_cut to be set.
+    class dynamic_mincut_witness {
+     public:
+        // bounded flows to find a minimum cut before the static algorithm
+        // is run on an outdated witness
+        static constexpr size_t max_witness_flows = 8;
+
+        dynamic_mincut_witness() : verbose(configuration::getConfig()->verbose),
+                                   current_cut(0),
+                                   witness_weight(0),
+                                   witness_outdated(false),
+                                   callsOfStaticAlgorithm(0),
+                                   flow_problem_id(0) { }
+
+        ~dynamic_mincut_witness() { }
+
+        EdgeWeight initialize(mutableGraphPtr graph) {
+            timer t;
+            original_graph = graph;
+            current_cactus.reset();
+            callsOfStaticAlgorithm = 0;
+            flow_problem_id = random_functions::next();
+            recomputeWitness();
+            LOGC(verbose) << "initialize t " << t.elapsed()
+                          << " cut " << current_cut;
+            return current_cut;
+        }
+
+        // insert edge (s, t) with weight w. Does not revalidate the minimum
+        // cut, call getCurrentCut() for the current value
+        void addEdge(NodeID s, NodeID t, EdgeWeight w) {
+            original_graph->new_edge_order(s, t, w);
+            current_cactus.reset();
+            if (witness[s] != witness[t]) {
+                witness_weight += w;
+                witness_outdated = (witness_weight != current_cut);
+            }
+        }
+
+        EdgeWeight removeEdge(NodeID s, NodeID t) {
+            EdgeID eToT = UNDEFINED_EDGE;
+            for (EdgeID e : original_graph->edges_of(s)) {
+                if (original_graph->getEdgeTarget(s, e) == t) {
+                    eToT = e;
+                    break;
+                }
+            }
+
+            if (eToT == UNDEFINED_EDGE) {
+                LOG1 << "Warning: Deleting edge between " << s << " and " << t
+                     << " that does not exist! Doing nothing";
+                return getCurrentCut();
+            }
+
+            // deletions are handled on a valid witness
+            revalidate();
+            EdgeWeight wgt = original_graph->getEdgeWeight(s, eToT);
+            original_graph->deleteEdge(s, eToT);
+            current_cactus.reset();
+
+            if (witness[s] != witness[t]) {
+                // minimum cut decreases by at most wgt, so the witness
+                // stays a minimum cut
+                witness_weight -= wgt;
+                current_cut = witness_weight;
+                LOGC(verbose) << "deleted edge crosses witness, cut "
+                              << current_cut;
+                return current_cut;
+            }
+
+            if (wgt == 0 || current_cut == 0) {
+                return current_cut;
+            }
+
+            // the only cuts that got lighter separate s and t
+            auto [flow, sourceset] = bf.solve_max_flow_min_cut(
+                original_graph, { s, t }, 0, true,
+                current_cut, flow_problem_id++);
+
+            if (static_cast<EdgeWeight>(flow) < current_cut) {
+                std::fill(witness.begin(), witness.end(), false);
+                for (NodeID v : sourceset) {
+                    witness[v] = true;
+                }
+                current_cut = flow;
+                witness_weight = flow;
+                LOGC(verbose) << "minimum cut changed to " << flow;
+            }
+            return current_cut;
+        }
+
+        EdgeWeight getCurrentCut() {
+            revalidate();
+            return current_cut;
+        }
+
+        // one side of a minimum cut, witness[v] is true iff v is on that side
+        const std::vector<bool>& getWitness() {
+            revalidate();
+            return witness;
+        }
+
+        // cactus of all minimum cuts, only computed on demand
+        mutableGraphPtr getCurrentCactus() {
+            revalidate();
+            if (!current_cactus) {
+                auto [cut, outgraph, balanced] =
+                    cactus.findAllMincuts(original_graph, current_cut);
+                callsOfStaticAlgorithm++;
+                current_cactus = outgraph;
+            }
+            return current_cactus;
+        }
+
+        mutableGraphPtr getOriginalGraph() {
+            return original_graph;
+        }
+
+        size_t getCallsOfStaticAlgorithm() {
+            return callsOfStaticAlgorithm;
+        }
+
+     private:
+        void revalidate() {
+            if (!witness_outdated)
+                return;
+
+            // current_cut is a lower bound, as there were only insertions
+            // since the last time it was computed. Thus, if there is a vertex
+            // with that degree, it is a minimum cut
+            for (NodeID n : original_graph->nodes()) {
+                if (original_graph->getWeightedNodeDegree(n) == current_cut) {
+                    setTrivialWitness(n);
+                    return;
+                }
+            }
+
+            if (boundedWitness())
+                return;
+
+            // last resort, no bounded flow found a cut of the lower bound
+            recomputeWitness();
+        }
+
+        // flows from the vertex of smallest degree to the vertices that are
+        // last in a BFS from it, bounded by the witness weight. Far vertices
+        // are separated from s by many cuts, the other side of the witness
+        // is not used as the inserted edges that crossed it often tie it
+        // to s. A lighter cut replaces the witness, and if its weight is
+        // the lower bound current_cut, it is a minimum cut. Returns whether
+        // such a minimum cut was found
+        bool boundedWitness() {
+            NodeID s = 0;
+            for (NodeID n : original_graph->nodes()) {
+                if (original_graph->getWeightedNodeDegree(n)
+                    < original_graph->getWeightedNodeDegree(s)) {
+                    s = n;
+                }
+            }
+
+            std::vector<bool> visited(original_graph->n(), false);
+            std::vector<NodeID> bfs_order = { s };
+            visited[s] = true;
+            for (size_t i = 0; i < bfs_order.size(); ++i) {
+                NodeID v = bfs_order[i];
+                for (EdgeID e : original_graph->edges_of(v)) {
+                    NodeID tgt = original_graph->getEdgeTarget(v, e);
+                    if (!visited[tgt]) {
+                        visited[tgt] = true;
+                        bfs_order.emplace_back(tgt);
+                    }
+                }
+            }
+
+            size_t num_flows = std::min(max_witness_flows,
+                                        bfs_order.size() - 1);
+            for (size_t i = 0; i < num_flows; ++i) {
+                NodeID t = bfs_order[bfs_order.size() - 1 - i];
+                auto [flow, sourceset] = bf.solve_max_flow_min_cut(
+                    original_graph, { s, t }, 0, true,
+                    witness_weight, flow_problem_id++);
+
+                if (static_cast<EdgeWeight>(flow) < witness_weight) {
+                    std::fill(witness.begin(), witness.end(), false);
+                    for (NodeID v : sourceset) {
+                        witness[v] = true;
+                    }
+                    witness_weight = flow;
+                }
+
+                if (witness_weight == current_cut) {
+                    witness_outdated = false;
+                    LOGC(verbose) << "bounded flow witness after " << i + 1
+                                  << " flows, cut " << current_cut;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void setTrivialWitness(NodeID n) {
+            std::fill(witness.begin(), witness.end(), false);
+            witness[n] = true;
+            witness_weight = current_cut;
+            witness_outdated = false;
+            LOGC(verbose) << "trivial witness " << n << " cut " << current_cut;
+        }
+
+        void recomputeWitness() {
+            noi_minimum_cut<mutableGraphPtr> noi;
+            current_cut = noi.perform_minimum_cut(original_graph);
+            callsOfStaticAlgorithm++;
+            witness.resize(original_graph->n());
+            for (NodeID n : original_graph->nodes()) {
+                witness[n] = original_graph->getNodeInCut(n);
+            }
+            witness_weight = current_cut;
+            witness_outdated = false;
+            LOGC(verbose) << "recomputed witness, cut " << current_cut;
+        }
+
+        bool verbose;
+        mutableGraphPtr original_graph;
+        mutableGraphPtr current_cactus;
+        EdgeWeight current_cut;
+        EdgeWeight witness_weight;
+        bool witness_outdated;
+        std::vector<bool> witness;
+        size_t callsOfStaticAlgorithm;
+        size_t flow_problem_id;
+        bounded_flow bf;
+
+    #ifdef PARALLEL
+        parallel_cactus<mutableGraphPtr> cactus;
+    #else
+        cactus_mincut<mutableGraphPtr> cactus;
+    #endif
+    };
+}
@@ -40,6 +40,7 @@
 #include "coarsening/contraction_tests.h"
 #include "coarsening/label_propagation.h"
 #endif
+#include "coarsening/expander_decomposition.h"
 
 namespace VieCut {
     template <class GraphPtr>
@@ -76,6 +77,9 @@ namespace VieCut {
                 G = graphs.back();
                 label_propagation<GraphPtr> lp;
                 std::vector<NodeID> cluster_mapping = lp.propagate_labels(G);
+                if (configuration::getConfig()->expander_coarsening) {
+                    expanderCoarsening(G, &cluster_mapping);
+                }
                 auto [mapping, reverse_mapping] =
                     minimum_cut_helpers<GraphPtr>::remap_cluster(
                         G, cluster_mapping);
@@ -119,5 +123,29 @@ namespace VieCut {
 
             return cut;
         }
+
+     private:
+        // replaces the label propagation clustering by an expander
+        // decomposition if label propagation did not shrink the graph much
+        // and the decomposition has fewer clusters
+        void expanderCoarsening(GraphPtr G,
+                                std::vector<NodeID>* cluster_mapping) {
+            typedef expander_decomposition<GraphPtr> decomposition;
+            NodeID lp_clusters = decomposition::countClusters(*cluster_mapping);
+            double threshold = configuration::getConfig()->expander_threshold;
+            if (lp_clusters <= threshold * G->number_of_nodes())
+                return;
+
+            timer t;
+            decomposition ed;
+            std::vector<NodeID> clusters = ed.decompose(G);
+            NodeID ed_clusters = decomposition::countClusters(clusters);
+            LOGC(timing) << "Expander decomposition: " << ed_clusters
+                         << " clusters (LP: " << lp_clusters << ") in "
+                         << t.elapsed();
+            if (ed_clusters < lp_clusters) {
+                *cluster_mapping = clusters;
+            }
+        }
     };
 }
\ No newline at end of file
@@ -26,13 +26,24 @@
 namespace VieCut {
     class find_articulation_points {
      public:
-        explicit find_articulation_points(mutableGraphPtr G)
-            : G(G),
-              visited(G->n(), false),
-              discovered(G->n(), UNDEFINED_NODE),
-              parent(G->n(), UNDEFINED_NODE),
-              lowest(G->n(), UNDEFINED_NODE),
-              step(0) { }
+        find_articulation_points() : step(0) { }
+
+        explicit find_articulation_points(mutableGraphPtr G) : step(0) {
+            reset(G);
+        }
+
+        // prepares the search on G. the buffers of previous searches are
+        // reused, so a single object can be used for many graphs
+        void reset(mutableGraphPtr G) {
+            this->G = G;
+            visited.assign(G->n(), false);
+            discovered.assign(G->n(), UNDEFINED_NODE);
+            parent.assign(G->n(), UNDEFINED_NODE);
+            lowest.assign(G->n(), UNDEFINED_NODE);
+            contracted.assign(G->n(), false);
+            articulation_points.clear();
+            step = 0;
+        }
 
         bool findAllArticulationPoints() {
             for (NodeID vtx : G->nodes()) {
@@ -78,10 +89,10 @@ namespace VieCut {
                     return_uf = true;
                     bool invert_side = (sum == terminals.size()) ? true : false;
 
-                    std::vector<bool> contracted(G->n(), false);
+                    resetContracted();
 
                     std::queue<NodeID> q;
-                    contracted[n] = true;
+                    setContracted(n);
                     for (EdgeID e : G->edges_of(n)) {
                         NodeID t = G->getEdgeTarget(n, e);
 
@@ -106,7 +117,7 @@ namespace VieCut {
                         }
 
                         if (on_right != invert_side) {
-                            contracted[t] = true;
+                            setContracted(t);
                             q.push(t);
                             uf.Union(n, t);
                         }
@@ -119,7 +130,7 @@ namespace VieCut {
                             NodeID tgt = G->getEdgeTarget(v, a);
                             if (!contracted[tgt]) {
                                 uf.Union(v, tgt);
-                                contracted[tgt] = true;
+                                setContracted(tgt);
                                 q.push(tgt);
                             }
                         }
@@ -215,11 +226,26 @@ namespace VieCut {
             // different contraction mechanism
         }
 
+        // contracted is set for the vertices in contracted_vertices only
+        void setContracted(NodeID v) {
+            contracted[v] = true;
+            contracted_vertices.emplace_back(v);
+        }
+
+        void resetContracted() {
+            for (NodeID v : contracted_vertices) {
+                contracted[v] = false;
+            }
+            contracted_vertices.clear();
+        }
+
         mutableGraphPtr G;
         std::vector<bool> visited;
         std::vector<NodeID> discovered;
         std::vector<NodeID> parent;
         std::vector<NodeID> lowest;
+        std::vector<bool> contracted;
+        std::vector<NodeID> contracted_vertices;
 
         std::stack<NodeID> stack;
         std::vector<NodeID> articulation_points;
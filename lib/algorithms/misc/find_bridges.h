@@ -24,13 +24,24 @@
 namespace VieCut {
     class find_bridges {
      public:
-        explicit find_bridges(mutableGraphPtr G)
-            : G(G),
-              visited(G->n(), false),
-              discovered(G->n(), UNDEFINED_NODE),
-              parent(G->n(), UNDEFINED_NODE),
-              lowest(G->n(), UNDEFINED_NODE),
-              step(0) { }
+        find_bridges() : step(0) { }
+
+        explicit find_bridges(mutableGraphPtr G) : step(0) {
+            reset(G);
+        }
+
+        // prepares the search on G. the buffers of previous searches are
+        // reused, so a single object can be used for many graphs
+        void reset(mutableGraphPtr G) {
+            this->G = G;
+            visited.assign(G->n(), false);
+            discovered.assign(G->n(), UNDEFINED_NODE);
+            parent.assign(G->n(), UNDEFINED_NODE);
+            lowest.assign(G->n(), UNDEFINED_NODE);
+            contracted.assign(G->n(), false);
+            bridges.clear();
+            step = 0;
+        }
 
         bool findAllBridges() {
             for (NodeID vtx : G->nodes()) {
@@ -77,11 +88,11 @@ namespace VieCut {
                         ctr_n = G->getEdgeTarget(n, e);
                         ctr_e = G->getReverseEdge(n, e);
                     }
-                    std::vector<bool> contracted(G->n(), false);
+                    resetContracted();
                     NodeID t = G->getEdgeTarget(ctr_n, ctr_e);
                     uf.Union(ctr_n, t);
-                    contracted[ctr_n] = true;
-                    contracted[t] = true;
+                    setContracted(ctr_n);
+                    setContracted(t);
                     std::queue<NodeID> q;
                     q.push(t);
 
@@ -92,7 +103,7 @@ namespace VieCut {
                             NodeID tgt = G->getEdgeTarget(v, a);
                             if (!contracted[tgt]) {
                                 uf.Union(v, tgt);
-                                contracted[tgt] = true;
+                                setContracted(tgt);
                             }
                         }
                     }
@@ -182,11 +193,26 @@ namespace VieCut {
             }
         }
 
+        // contracted is set for the vertices in contracted_vertices only
+        void setContracted(NodeID v) {
+            contracted[v] = true;
+            contracted_vertices.emplace_back(v);
+        }
+
+        void resetContracted() {
+            for (NodeID v : contracted_vertices) {
+                contracted[v] = false;
+            }
+            contracted_vertices.clear();
+        }
+
         mutableGraphPtr G;
         std::vector<bool> visited;
         std::vector<NodeID> discovered;
         std::vector<NodeID> parent;
         std::vector<NodeID> lowest;
+        std::vector<bool> contracted;
+        std::vector<NodeID> contracted_vertices;
 
         std::stack<NodeID> stack;
         std::vector<std::pair<NodeID, EdgeID> > bridges;
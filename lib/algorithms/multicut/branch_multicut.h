@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdio>
 #include <iterator>
@@ -39,6 +40,7 @@
 #include "algorithms/multicut/measurements.h"
 #include "algorithms/multicut/mpi_communication.h"
 #include "algorithms/multicut/multicut_problem.h"
+#include "algorithms/multicut/problem_checkpoint.h"
 #include "algorithms/multicut/problem_management.h"
 #include "coarsening/contract_graph.h"
 #include "common/configuration.h"
@@ -51,10 +53,6 @@
 #include "algorithms/multicut/ilp_model.h"
 #endif
 
-#ifdef USE_TCMALLOC
-#include "gperftools/malloc_extension.h"
-#endif
-
 namespace VieCut {
     class branch_multicut {
      public:
@@ -67,7 +65,8 @@ namespace VieCut {
 
         branch_multicut(const mutable_graph& original_graph,
                         std::vector<NodeID> original_terminals,
-                        std::vector<bool> fixed_vertex)
+                        std::vector<bool> fixed_vertex,
+                        size_t component = 0)
             : original_graph(original_graph),
               original_terminals(original_terminals),
               fixed_vertex(fixed_vertex),
@@ -83,12 +82,16 @@ namespace VieCut {
               last_sent_flow(UNDEFINED_FLOW),
               log_timer(0),
               finished(false),
-              mpic() {
+              mpic(),
+              component(component),
+              checkpoint(!configuration::getConfig()->checkpoint_file.empty()),
+              checkpoint_stop(false) {
             MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
             MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
             mpi_num_done = 0;
             mpi_done.resize(mpi_size, 0);
             sent_done = false;
+            mpic.retainSentProblems(checkpointing());
         }
 
         ~branch_multicut() { }
@@ -97,11 +100,16 @@ namespace VieCut {
             problemPointer problem) {
             std::vector<NodeID> sol;
             size_t numTerminals = problem->terminals.size();
-            if (mpi_rank == 0) {
-                mf.maximumIsolatingFlow(problem, 0, /* parallel */ true);
+            bool resumed = configuration::getConfig()->resume
+                           && resumeFromCheckpoint(&sol);
+            if (mpi_rank == 0 && !resumed) {
+                mf.maximumIsolatingFlow(problem, /* parallel */ true);
                 sol = msm.getSolution(problem);
                 pm.addProblem(problem, 0, false);
                 pm.updateBound(problem->upper_bound);
+                // set before the workers start, as they take any solution as
+                // the best one as long as there is none
+                updateBestSolution(&sol, numTerminals);
             }
 
             std::vector<std::thread> threads;
@@ -117,8 +125,10 @@ namespace VieCut {
                 }
             }
 
-            if (mpi_rank == 0) {
-                updateBestSolution(&sol, numTerminals);
+            std::thread checkpoint_thread;
+            if (checkpointing()) {
+                checkpoint_thread = std::thread(
+                    &branch_multicut::checkpointPeriodically, this);
             }
 
             for (auto& t : threads) {
@@ -126,6 +136,28 @@ namespace VieCut {
                 t.join();
             }
 
+            if (checkpointing()) {
+                {
+                    std::lock_guard<std::mutex> lock(checkpoint_mutex);
+                    checkpoint_stop = true;
+                }
+                checkpoint_cv.notify_all();
+                checkpoint_thread.join();
+                // the search was stopped early and kept its open problems
+                if (finished) {
+                    writeCheckpoint();
+                }
+            }
+
+            mpic.waitForSends();
+            if (configuration::getConfig()->verbose) {
+                pm.printSchedulerStatistics();
+                if (mpi_size > 1) {
+                    LOG1 << "RESULT-MPI rank=" << mpi_rank << " "
+                         << mpic.getTransferStatistics().toString();
+                }
+            }
+
             MPI_Request all_done;
             MPI_Ibarrier(MPI_COMM_WORLD, &all_done);
 
@@ -183,6 +215,20 @@ namespace VieCut {
             return std::make_pair(best_solution, total_weight);
         }
 
+        // statistics of all flows of this process, i.e. in kernelization,
+        // in bound computation and in the initial isolating flows
+        flow_statistics getFlowStatistics() {
+            flow_statistics stats = mf.getFlowStatistics();
+            stats.add(kc.getFlowStatistics());
+            stats.add(pm.getFlowStatistics());
+            return stats;
+        }
+
+        // number of problems that were spilled to disk by this process
+        size_t spilledProblems() {
+            return pm.numSpilledProblems();
+        }
+
      private:
         void pollWork(size_t thread_id) {
             bool im_idle = false;
@@ -191,6 +237,7 @@ namespace VieCut {
                     last_sent_flow = pm.bestCut();
                     mpic.broadcastImprovedSolution(last_sent_flow);
                 }
+                checkpoint.enter();
                 pm.prepareQueue(thread_id);
                 if (!pm.queueEmpty(thread_id) || pm.haveASendProblem()) {
                     if (thread_id == 0) {
@@ -204,6 +251,7 @@ namespace VieCut {
 
                     auto problem = pm.pullProblem(thread_id, sending.has_value());
                     if (!problem.has_value()) {
+                        checkpoint.leave();
                         continue;
                     }
 
@@ -213,7 +261,9 @@ namespace VieCut {
                     } else {
                         solveProblem(problem.value(), thread_id);
                     }
+                    checkpoint.leave();
                 } else {
+                    checkpoint.leave();
                     if (!im_idle) {
                         pm.incrementIdleThreads();
                         im_idle = true;
@@ -230,8 +280,10 @@ namespace VieCut {
                                     MPI_Isend(&done, 1, MPI_INT, mpi_size - 1,
                                               4000, MPI_COMM_WORLD, &rq);
                                 }
+                                checkpoint.enter();
                                 auto p = mpic.recvProblem(std::get<int>(src));
                                 pm.addProblem(p, thread_id, true);
+                                checkpoint.leave();
                             } else {
                                 if (std::get<bool>(src)) {
                                     pm.setFinish();
@@ -293,26 +345,147 @@ namespace VieCut {
             }
         }
 
-        bool outOfMemory() {
-    #ifdef USE_TCMALLOC
-            uint64_t heapsize = 0;
-            MallocExtension::instance()->GetNumericProperty(
-                "generic.heap_size", &heapsize);
+        bool checkpointing() {
+            return !configuration::getConfig()->checkpoint_file.empty();
+        }
 
-            uint64_t max_size = 32UL * 1024UL * 1024UL * 1024UL;
-            if (heapsize > max_size) {
-                LOG1 << "Memoryout!";
-                finished = true;
-                return true;
+        // problems that were not solved as the search stopped early. they
+        // are written to the final checkpoint
+        void keepForCheckpoint(problemPointer problem) {
+            if (!checkpointing())
+                return;
+            std::lock_guard<std::mutex> lock(checkpoint_mutex);
+            unsolved_problems.emplace_back(problem);
+        }
+
+        void checkpointPeriodically() {
+            auto interval = std::chrono::duration<double>(
+                configuration::getConfig()->checkpoint_interval);
+            std::unique_lock<std::mutex> lock(checkpoint_mutex);
+            auto stop = [this] { return checkpoint_stop; };
+            while (!checkpoint_cv.wait_for(lock, interval, stop)) {
+                lock.unlock();
+                writeCheckpoint();
+                lock.lock();
             }
-    #endif
-            return false;
+        }
+
+        // the workers are only paused while the problems are encoded, the
+        // file is written while they continue
+        void writeCheckpoint() {
+            timer t;
+            problem_checkpoint::checkpoint_data data;
+            data.num_nodes = original_graph.n();
+            data.num_terminals = original_terminals.size();
+
+            checkpoint.pause();
+            std::vector<problemPointer> open = pm.queuedProblems();
+            {
+                std::lock_guard<std::mutex> lock(checkpoint_mutex);
+                open.insert(open.end(), unsolved_problems.begin(),
+                            unsolved_problems.end());
+            }
+            for (problemPointer p : open) {
+                data.problems.emplace_back(
+                    mpi_communication::encodeProblem(p));
+            }
+            for (auto& spilled : pm.encodedProblems()) {
+                data.problems.emplace_back(std::move(spilled));
+            }
+            for (auto& sent : mpic.sentProblemsForCheckpoint()) {
+                data.problems.emplace_back(std::move(sent));
+            }
+            if (pm.isBestSolutionInitialized()) {
+                data.solution = pm.getBestSolution();
+            }
+            checkpoint.resume();
+            double pause_time = t.elapsed();
+
+            if (!data.solution.empty()) {
+                data.upper_bound = msm.flowValue(false, data.solution);
+            }
+            std::string file = problem_checkpoint::fileName(
+                configuration::getConfig()->checkpoint_file,
+                component, mpi_rank);
+            if (!problem_checkpoint::write(file, data)) {
+                LOG1 << "ERROR: could not write checkpoint " << file;
+                return;
+            }
+            LOG1 << "Rank " << mpi_rank << " wrote checkpoint " << file
+                 << " with " << data.problems.size() << " problems"
+                 << " (paused " << pause_time << "s, total "
+                 << t.elapsed() << "s)";
+        }
+
+        // reads the checkpoints of all processes of the previous run. every
+        // process takes every mpi_size-th problem, so the search continues
+        // with any number of processes and threads. the best solution is
+        // written to sol. returns false if there is no checkpoint
+        bool resumeFromCheckpoint(std::vector<NodeID>* sol) {
+            const std::string& path =
+                configuration::getConfig()->checkpoint_file;
+            FlowType best = UNDEFINED_FLOW;
+            std::vector<problemPointer> resumed;
+            size_t num_problems = 0;
+            int r = 0;
+            problem_checkpoint::checkpoint_data data;
+            for ( ; problem_checkpoint::read(
+                      problem_checkpoint::fileName(path, component, r), &data);
+                  ++r) {
+                if (data.num_nodes != original_graph.n()
+                    || data.num_terminals != original_terminals.size()) {
+                    LOG1 << "ERROR: checkpoint " << path << " is not from"
+                         << " this graph and terminals";
+                    exit(1);
+                }
+
+                if (data.upper_bound < best
+                    && data.solution.size() == original_graph.n()) {
+                    best = data.upper_bound;
+                    *sol = data.solution;
+                }
+
+                for (const auto& encoded : data.problems) {
+                    if (num_problems++ % mpi_size
+                        != static_cast<size_t>(mpi_rank))
+                        continue;
+                    auto p = mpi_communication::decodeProblem(encoded);
+                    if (p == nullptr) {
+                        LOG1 << "ERROR: checkpoint " << path
+                             << " contains malformed problem";
+                        exit(1);
+                    }
+                    resumed.emplace_back(p);
+                }
+            }
+
+            if (sol->empty()) {
+                LOG1 << "No checkpoint with solution found at " << path
+                     << ", starting from scratch";
+                return false;
+            }
+
+            // set before the workers start, as they take any solution as the
+            // best one as long as there is none
+            updateBestSolution(sol, original_terminals.size());
+            size_t kept = 0;
+            for (auto p : resumed) {
+                if (pm.checkProblem(p)) {
+                    pm.addProblem(p, kept++ % num_threads, false);
+                }
+            }
+            LOG1 << "Rank " << mpi_rank << " resumed " << kept << " of "
+                 << num_problems << " problems from " << r
+                 << " checkpoints with cut " << pm.bestCut();
+            return true;
         }
 
         void solveProblem(problemPointer problem,
                           size_t thread_id) {
-            if (finished)
+            if (finished) {
+                keepForCheckpoint(problem);
                 return;
+            }
 
             auto c = configuration::getConfig();
             if (problem == NULL) {
@@ -324,12 +497,15 @@ namespace VieCut {
                 return;
             }
 
-            if (outOfMemory())
+            if (problem->isLazy()) {
+                pm.processBranch(problem, thread_id);
                 return;
+            }
 
             if (total_time.elapsed() > configuration::getConfig()->timeoutSeconds) {
                 LOG1 << "Timeout!";
                 finished = true;
+                keepForCheckpoint(problem);
                 return;
             }
 
@@ -355,13 +531,11 @@ namespace VieCut {
                 for (size_t i = 0; i < problem->graph->getOriginalNodes(); ++i) {
                     map->emplace_back(problem->graph->getCurrentPosition(i));
                 }
-                problem->mappings.emplace_back(map);
+                problem->addMapping(map, c->maxMappingDepth);
                 problem->graph = problem->graph->simplify();
             }
             graph_contraction::setTerminals(problem, original_terminals);
-            nonBranchingContraction(problem);
-            if (outOfMemory())
-                return;
+            nonBranchingContraction(problem, thread_id);
 
             if (problem->deleted_weight > static_cast<EdgeWeight>(pm.bestCut())) {
                 return;
@@ -379,9 +553,6 @@ namespace VieCut {
                 exit(1);
             }
 
-            if (outOfMemory())
-                return;
-
             if (branchHere) {
                 branchOnEdge(problem, thread_id);
             } else {
@@ -480,8 +651,7 @@ namespace VieCut {
                         } else {
                             if (contractVertices[cp] != UNDEFINED_NODE) {
                                 problem->removeFinishedPair(
-                                    lightest_oid, contractVertices[cp],
-                                    original_terminals.size());
+                                    lightest_oid, contractVertices[cp]);
                             }
                         }
                     }
@@ -552,18 +722,15 @@ namespace VieCut {
                 return;
             }
 
-            if (outOfMemory())
-                return;
             pm.branch(problem, thread_id, &mpic);
-
-            if (outOfMemory())
-                return;
         }
 
-        void nonBranchingContraction(problemPointer problem) {
+        void nonBranchingContraction(problemPointer problem,
+                                     size_t thread_id) {
             auto pe = kc.kernelization(problem, pm.bestCut(),
                                        pm.numProblems() == 0
-                                       && configuration::getConfig()->threads > 1);
+                                       && configuration::getConfig()->threads > 1,
+                                       thread_id);
             if (pe.has_value()) {
                 problem->priority_edge = *pe;
             }
@@ -642,6 +809,14 @@ namespace VieCut {
         bool sent_done;
         std::mutex mpi_mutex;
 
+        // checkpoints
+        size_t component;
+        problem_checkpoint checkpoint;
+        std::mutex checkpoint_mutex;
+        std::condition_variable checkpoint_cv;
+        bool checkpoint_stop;
+        std::vector<problemPointer> unsolved_problems;
+
         size_t print_index = 0;
     };
 }
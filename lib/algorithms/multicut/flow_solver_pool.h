@@ -0,0 +1,169 @@
+/******************************************************************************
+ * flow_solver_pool.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <sched.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "algorithms/flow/boykov_kolmogorov.h"
+#include "algorithms/flow/flow_statistics.h"
+#include "algorithms/flow/push_relabel.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+
+namespace VieCut {
+    // Persistent threads that compute the independent flows of maximum_flow
+    // in parallel. Every worker owns a solver for each flow algorithm, so
+    // the flow buffers are allocated once per worker and reused for all its
+    // flows. Any thread can submit a batch of flows and waits until all of
+    // them are computed, the flows of all batches share the same workers.
+    class flow_solver_pool {
+     public:
+        struct flow_job {
+            mutableGraphPtr graph;
+            std::vector<NodeID> terminals;
+            NodeID source;
+            // filled by run()
+            std::vector<NodeID> source_set;
+        };
+
+        // pool shared by all threads, with a worker per available core
+        static flow_solver_pool& getPool() {
+            static flow_solver_pool pool(
+                std::max(std::thread::hardware_concurrency(), 1u));
+            return pool;
+        }
+
+        explicit flow_solver_pool(size_t num_workers) : stop(false) {
+            for (size_t i = 0; i < num_workers; ++i) {
+                workers.emplace_back(&flow_solver_pool::work, this);
+            }
+        }
+
+        ~flow_solver_pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            job_cv.notify_all();
+            for (auto& w : workers) {
+                w.join();
+            }
+        }
+
+        flow_solver_pool(const flow_solver_pool&) = delete;
+        flow_solver_pool& operator = (const flow_solver_pool&) = delete;
+
+        size_t size() const {
+            return workers.size();
+        }
+
+        // computes the source sets of all jobs with the given flow algorithm
+        // (see maximum_flow::flowAlgorithm). the flows are already computed
+        // in parallel, so parallel_push_relabel uses the sequential
+        // push_relabel. the statistics of the flows are added to stats
+        void run(std::vector<flow_job>* jobs, const std::string& algorithm,
+                 flow_statistics* stats) {
+            if (jobs->empty())
+                return;
+
+            batch b(jobs);
+            if (algorithm == "boykov_kolmogorov") {
+                b.bk = true;
+            } else if (algorithm != "push_relabel"
+                       && algorithm != "parallel_push_relabel") {
+                LOG1 << "Error: unknown flow algorithm " << algorithm;
+                exit(1);
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            for (size_t i = 0; i < jobs->size(); ++i) {
+                queue.emplace_back(&b, i);
+            }
+            job_cv.notify_all();
+            b.done_cv.wait(lock, [&b] { return b.remaining == 0; });
+            stats->add(b.stats);
+        }
+
+     private:
+        struct batch {
+            explicit batch(std::vector<flow_job>* jobs)
+                : jobs(jobs), remaining(jobs->size()), bk(false) { }
+
+            std::vector<flow_job>* jobs;
+            size_t remaining;
+            // boykov_kolmogorov instead of push_relabel
+            bool bk;
+            flow_statistics stats;
+            std::condition_variable done_cv;
+        };
+
+        void work() {
+            // workers might be started by a thread that is pinned to a
+            // single core, they may run on every core
+            if (!configuration::getConfig()->disable_cpu_affinity) {
+                cpu_set_t all_cores;
+                CPU_ZERO(&all_cores);
+                for (size_t i = 0; i < std::thread::hardware_concurrency();
+                     ++i) {
+                    CPU_SET(i, &all_cores);
+                }
+                sched_setaffinity(0, sizeof(cpu_set_t), &all_cores);
+            }
+
+            push_relabel<false, true> pr;
+            boykov_kolmogorov<false, true> bk;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                job_cv.wait(lock, [this] { return stop || !queue.empty(); });
+                if (queue.empty())
+                    return;
+
+                auto [b, index] = queue.front();
+                queue.pop_front();
+                lock.unlock();
+
+                flow_job& job = (*b->jobs)[index];
+                if (b->bk) {
+                    job.source_set = bk.callable_max_flow(
+                        job.graph, job.terminals, job.source, true);
+                } else {
+                    job.source_set = pr.callable_max_flow(
+                        job.graph, job.terminals, job.source, true);
+                }
+
+                lock.lock();
+                b->stats.add(b->bk ? bk.getStatistics()
+                                   : pr.getStatistics());
+                if (--b->remaining == 0) {
+                    b->done_cv.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::deque<std::pair<batch*, size_t> > queue;
+        std::mutex mutex;
+        std::condition_variable job_cv;
+        bool stop;
+    };
+}
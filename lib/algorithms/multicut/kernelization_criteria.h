@@ -39,77 +39,107 @@ namespace VieCut {
 
         explicit kernelization_criteria(std::vector<NodeID> original_terminals)
             : original_terminals(original_terminals),
-              mf(original_terminals) { }
+              mf(original_terminals),
+              num_threads(configuration::getConfig()->threads),
+              buffers(num_threads) { }
 
         ~kernelization_criteria() { }
 
         // performs kernelization.
         // if we find a bridge that separates terminal set, return it to branch on
+        //
+        // every thread uses its own buffers, which are reused between calls.
+        // if parallel is set, i.e. for the root problem while the other
+        // threads are idle, the vertex scans of the low and high degree
+        // reductions are split between all threads
         std::optional<std::pair<NodeID, EdgeID> > kernelization(
             problemPointer problem,
-            size_t global_upper_bound, bool parallel) {
+            size_t global_upper_bound, bool parallel, size_t thread_id) {
+            kernelization_buffers& buf = buffers[thread_id];
             NodeID num_vtcs = problem->graph->n();
-            std::vector<bool> active_c(problem->graph->getOriginalNodes(), true);
-            std::vector<bool> active_n(problem->graph->getOriginalNodes(), false);
+            buf.active_c.assign(problem->graph->getOriginalNodes(), true);
+            buf.active_n.assign(problem->graph->getOriginalNodes(), false);
+            if (parallel) {
+                useAllCores(true, thread_id);
+            }
             do {
                 num_vtcs = problem->graph->n();
-                auto uf_lowdegree = lowDegreeContraction(problem);
-                contractIfImproved(&uf_lowdegree, problem, "lowdeg", &active_n);
+                auto uf_lowdegree = lowDegreeContraction(problem, &buf,
+                                                         parallel);
+                contractIfImproved(&uf_lowdegree, problem, "lowdeg",
+                                   &buf.active_n);
 
-                union_find uf_high = highDegreeContraction(problem, active_c);
-                contractIfImproved(&uf_high, problem, "high_degree", &active_n);
+                union_find uf_high = highDegreeContraction(problem, &buf,
+                                                           parallel);
+                contractIfImproved(&uf_high, problem, "high_degree",
+                                   &buf.active_n);
 
-                auto uf_tri = triangleDetection(problem, active_c);
-                contractIfImproved(&uf_tri, problem, "triangle", &active_n);
+                auto uf_tri = triangleDetection(problem, &buf);
+                contractIfImproved(&uf_tri, problem, "triangle", &buf.active_n);
 
-                std::vector<EdgeWeight> flow_values;
+                // only the two heaviest terminals are needed
                 EdgeWeight sum = 0;
+                EdgeWeight heaviest = 0;
+                EdgeWeight second = 0;
                 for (size_t i = 0; i < problem->terminals.size(); ++i) {
                     NodeID orig_id = problem->terminals[i].original_id;
                     NodeID term_id = problem->mapped(
                         original_terminals[orig_id]);
                     NodeID pos = problem->graph->getCurrentPosition(term_id);
                     EdgeWeight deg = problem->graph->getWeightedNodeDegree(pos);
-                    flow_values.emplace_back(deg);
                     sum += deg;
+                    if (deg > heaviest) {
+                        second = heaviest;
+                        heaviest = deg;
+                    } else if (deg > second) {
+                        second = deg;
+                    }
                 }
 
-                std::sort(flow_values.begin(), flow_values.end());
-
                 FlowType contr_flow = 0;
 
-                if (flow_values.size() >= 2)
-                    contr_flow = sum - flow_values[flow_values.size() - 1]
-                                 - flow_values[flow_values.size() - 2];
+                if (problem->terminals.size() >= 2)
+                    contr_flow = sum - heaviest - second;
                 noi_minimum_cut<mutableGraphPtr> noi;
                 EdgeWeight noi_limit = global_upper_bound
                                        - problem->deleted_weight
                                        - tlx::div_ceil(contr_flow, 4);
                 auto uf_noi = noi.modified_capforest(problem->graph, noi_limit);
-                contractIfImproved(&uf_noi, problem, "noi", &active_n);
+                contractIfImproved(&uf_noi, problem, "noi", &buf.active_n);
 
-                find_articulation_points find_aps(problem->graph);
-                if (find_aps.findAllArticulationPoints()) {
-                    auto uf = find_aps.terminalsOnBothSides(problem->terminals);
+                buf.find_aps.reset(problem->graph);
+                if (buf.find_aps.findAllArticulationPoints()) {
+                    auto uf = buf.find_aps.terminalsOnBothSides(
+                        problem->terminals);
                     if (uf.has_value()) {
                         contractIfImproved(
-                            &uf.value(), problem, "aps", &active_n);
+                            &uf.value(), problem, "aps", &buf.active_n);
                     }
                 }
 
                 equal_neighborhood en;
-                union_find uf_en = en.findEqualNeighborhoods(problem, active_c);
-                contractIfImproved(&uf_en, problem, "equal_nbrhd", &active_n);
+                union_find uf_en = en.findEqualNeighborhoods(problem,
+                                                             buf.active_c);
+                contractIfImproved(&uf_en, problem, "equal_nbrhd",
+                                   &buf.active_n);
 
-                auto uf_mf = mf.nonTerminalFlow(problem, parallel, active_c);
-                contractIfImproved(&uf_mf, problem, "flow", &active_n);
+                auto uf_mf = mf.nonTerminalFlow(problem, parallel,
+                                                buf.active_c);
+                contractIfImproved(&uf_mf, problem, "flow", &buf.active_n);
 
-                active_n.swap(active_c);
-                std::fill(active_n.begin(), active_n.end(), false);
+                buf.active_n.swap(buf.active_c);
+                std::fill(buf.active_n.begin(), buf.active_n.end(), false);
             } while (problem->graph->n() < num_vtcs);
+            if (parallel) {
+                useAllCores(false, thread_id);
+            }
             return std::nullopt;
         }
 
+        flow_statistics getFlowStatistics() {
+            return mf.getFlowStatistics();
+        }
+
      private:
         void contractIfImproved(union_find* uf,
                                 problemPointer problem,
@@ -171,23 +201,66 @@ namespace VieCut {
             }
         }
 
-        union_find lowDegreeContraction(problemPointer problem) {
-            auto graph = problem->graph;
-            union_find uf(graph->number_of_nodes());
-            graph_contraction::setTerminals(problem, original_terminals);
-            std::vector<bool> terminals(graph->number_of_nodes(), false);
+        struct kernelization_buffers {
+            std::vector<bool> active_c;
+            std::vector<bool> active_n;
+            std::vector<bool> terminals;
+            std::vector<EdgeID> marked;
+            // unions found for every vertex, applied after the scan
+            std::vector<std::pair<NodeID, NodeID> > proposal;
+            find_articulation_points find_aps;
+        };
+
+        // threads started by the calling thread inherit its cpu affinity,
+        // which might be restricted to a single core
+        void useAllCores(bool all, size_t thread_id) {
+            if (configuration::getConfig()->disable_cpu_affinity)
+                return;
+
+            cpu_set_t cores;
+            CPU_ZERO(&cores);
+            if (all) {
+                for (size_t i = 0; i < num_threads; ++i) {
+                    CPU_SET(i, &cores);
+                }
+            } else {
+                CPU_SET(thread_id, &cores);
+            }
+            sched_setaffinity(0, sizeof(cpu_set_t), &cores);
+        }
 
+        void markTerminals(problemPointer problem,
+                           kernelization_buffers* buf) {
+            graph_contraction::setTerminals(problem, original_terminals);
+            buf->terminals.assign(problem->graph->number_of_nodes(), false);
             for (const auto& p : problem->terminals) {
-                terminals[p.position] = true;
+                buf->terminals[p.position] = true;
             }
+        }
 
-            for (NodeID n : graph->nodes()) {
+        union_find lowDegreeContraction(problemPointer problem,
+                                        kernelization_buffers* buf,
+                                        bool parallel) {
+            auto graph = problem->graph;
+            union_find uf(graph->number_of_nodes());
+            markTerminals(problem, buf);
+            const std::vector<bool>& terminals = buf->terminals;
+            auto& proposal = buf->proposal;
+            proposal.assign(graph->number_of_nodes(),
+                            { UNDEFINED_NODE, UNDEFINED_NODE });
+
+            // n is merged with proposal[n].first, which is merged with
+            // proposal[n].second. the decisions do not depend on previous
+            // unions, so the vertices can be scanned in parallel
+    #pragma omp parallel for schedule(dynamic, 1024) \
+            num_threads(num_threads) if (parallel)
+            for (NodeID n = 0; n < graph->number_of_nodes(); ++n) {
                 if (terminals[n])
                     continue;
 
                 if (graph->getUnweightedNodeDegree(n) == 1) {
                     NodeID tgt = graph->getEdgeTarget(n, 0);
-                    uf.Union(n, tgt);
+                    proposal[n].first = tgt;
                     if (graph->getUnweightedNodeDegree(tgt) == 3) {
                         // this will become a degree 2 vertex
                         // so we run the degree 2 contraction
@@ -197,8 +270,7 @@ namespace VieCut {
                         auto [n1, e1] = graph->getEdge(tgt, non_n_1);
                         auto [n2, e2] = graph->getEdge(tgt, non_n_2);
                         // merge with stronger connected neighbour
-                        NodeID larger = e1 >= e2 ? n1 : n2;
-                        uf.Union(tgt, larger);
+                        proposal[n].second = e1 >= e2 ? n1 : n2;
                     }
                     continue;
                 }
@@ -207,32 +279,47 @@ namespace VieCut {
                     auto [n1, e1] = graph->getEdge(n, 0);
                     auto [n2, e2] = graph->getEdge(n, 1);
                     // merge with stronger connected neighbour
-                    NodeID larger = e1 >= e2 ? n1 : n2;
-                    uf.Union(n, larger);
+                    proposal[n].first = e1 >= e2 ? n1 : n2;
+                }
+            }
+
+            for (NodeID n : graph->nodes()) {
+                auto [first, second] = proposal[n];
+                if (first != UNDEFINED_NODE) {
+                    uf.Union(n, first);
+                    if (second != UNDEFINED_NODE) {
+                        uf.Union(first, second);
+                    }
                 }
             }
             return uf;
         }
 
         union_find highDegreeContraction(problemPointer problem,
-                                         const std::vector<bool>& active) {
-            graph_contraction::setTerminals(problem, original_terminals);
+                                         kernelization_buffers* buf,
+                                         bool parallel) {
+            markTerminals(problem, buf);
             union_find uf(problem->graph->number_of_nodes());
-            std::vector<bool> terminals(problem->graph->number_of_nodes(), false);
-
-            for (const auto& p : problem->terminals) {
-                terminals[p.position] = true;
-            }
+            const std::vector<bool>& terminals = buf->terminals;
+            const std::vector<bool>& active = buf->active_c;
+            auto& proposal = buf->proposal;
+            proposal.assign(problem->graph->number_of_nodes(),
+                            { UNDEFINED_NODE, UNDEFINED_NODE });
 
             auto graph = problem->graph;
 
-            for (NodeID n : graph->nodes()) {
+            // the vertex that n should be merged with is computed in
+            // parallel. the unions are applied in vertex order afterwards,
+            // skipping vertices that were merged into another vertex
+    #pragma omp parallel for schedule(dynamic, 1024) \
+            num_threads(num_threads) if (parallel)
+            for (NodeID n = 0; n < graph->number_of_nodes(); ++n) {
                 NodeID in = graph->containedVertices(n)[0];
                 if (!active[in]) {
                     continue;
                 }
 
-                if (terminals[n] || uf.Find(n) != n)
+                if (terminals[n])
                     continue;
 
                 EdgeWeight nonterminal_weight = 0;
@@ -260,7 +347,7 @@ namespace VieCut {
                     }
 
                     if (wgt * 2 >= node_weight) {
-                        uf.Union(n, tgt);
+                        proposal[n].first = tgt;
                         already_contracted = true;
                         break;
                     }
@@ -272,27 +359,31 @@ namespace VieCut {
 
                 if (!already_contracted) {
                     if (maxwgt > nonterminal_weight + secondwgt) {
-                        uf.Union(n, maxterm);
+                        proposal[n].first = maxterm;
                     }
                 }
             }
 
+            for (NodeID n : graph->nodes()) {
+                if (proposal[n].first != UNDEFINED_NODE && uf.Find(n) == n) {
+                    uf.Union(n, proposal[n].first);
+                }
+            }
+
             return uf;
         }
 
         union_find triangleDetection(problemPointer problem,
-                                     const std::vector<bool>& active) {
+                                     kernelization_buffers* buf) {
             auto graph = problem->graph;
 
-            graph_contraction::setTerminals(problem, original_terminals);
+            markTerminals(problem, buf);
             union_find uf(problem->graph->number_of_nodes());
-            std::vector<bool> terminals(problem->graph->number_of_nodes(), false);
-
-            for (const auto& p : problem->terminals) {
-                terminals[p.position] = true;
-            }
+            const std::vector<bool>& terminals = buf->terminals;
+            const std::vector<bool>& active = buf->active_c;
 
-            std::vector<EdgeID> marked(problem->graph->n(), UNDEFINED_EDGE);
+            std::vector<EdgeID>& marked = buf->marked;
+            marked.assign(problem->graph->n(), UNDEFINED_EDGE);
             std::vector<bool> done(problem->graph->n(), false);
 
             for (NodeID v1 : graph->nodes()) {
@@ -384,6 +475,8 @@ namespace VieCut {
 
         std::vector<NodeID> original_terminals;
         maximum_flow mf;
+        size_t num_threads;
+        std::vector<kernelization_buffers> buffers;
         constexpr static bool logs = false;
     };
 }
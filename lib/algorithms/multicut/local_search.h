@@ -11,15 +11,23 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "algorithms/flow/push_relabel.h"
 #include "common/configuration.h"
 #include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "data_structure/priority_queues/node_bucket_pq.h"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
 
 namespace VieCut {
     class local_search {
@@ -31,8 +39,40 @@ namespace VieCut {
         std::unordered_map<NodeID, NodeID> movedToNewBlock;
         std::vector<std::vector<FlowType> > previousConnectivity;
         std::vector<NodeID> noImprovement;
+        NodeID num_blocks;
+
+        // reused between the block pairs of flowLocalSearch
+        std::vector<NodeID> mapping;
+        std::vector<std::vector<NodeID> > block_vertices;
+
+        // vertex-to-block connectivity for the fm local search. the slots
+        // conn[conn_begin[v]] to conn[conn_begin[v] + conn_size[v]] contain
+        // the blocks adjacent to v and the weight of the edges to them. a
+        // vertex is adjacent to at most min(degree, k) blocks. the table is
+        // updated on every move and rebuilt after other local searches
+        std::vector<EdgeID> conn_begin;
+        std::vector<NodeID> conn_size;
+        std::vector<std::pair<NodeID, EdgeWeight> > conn;
+        bool connectivity_valid;
+        EdgeWeight max_weighted_degree;
+        std::unique_ptr<node_bucket_pq> gain_pq;
+        std::vector<bool> locked;
+        std::vector<std::pair<NodeID, NodeID> > moves;
+
+        // for the parallel fm local search, index of a vertex in the region
+        // of its block pair
+        std::vector<NodeID> region_id;
 
      public:
+        // gains are clamped to this span, larger gains share the outermost
+        // buckets of the priority queue
+        static constexpr EdgeWeight MAX_GAIN_SPAN = 1 << 16;
+        // a pass of fm stops after this many moves without improvement
+        static constexpr size_t MAX_UNSUCCESSFUL_MOVES = 100;
+        // the region of a block pair in parallel fm contains the vertices
+        // at distance less than this from the boundary between the blocks
+        static constexpr size_t REGION_DEPTH = 3;
+
         local_search(const mutable_graph& original_graph,
                      const std::vector<NodeID>& original_terminals,
                      const std::vector<bool>& fixed_vertex,
@@ -41,7 +81,10 @@ namespace VieCut {
               original_terminals(original_terminals),
               fixed_vertex(fixed_vertex),
               sol(sol),
-              previousConnectivity(original_terminals.size()) {
+              previousConnectivity(original_terminals.size()),
+              num_blocks(original_terminals.size()),
+              connectivity_valid(false),
+              max_weighted_degree(0) {
             for (auto& pc : previousConnectivity) {
                 pc.resize(original_terminals.size(), 0);
             }
@@ -51,16 +94,16 @@ namespace VieCut {
         std::tuple<EdgeWeight, FlowType> flowBetweenBlocks(NodeID term1,
                                                            NodeID term2) {
             std::vector<NodeID>& solution = *sol;
-            std::vector<NodeID> mapping(original_graph.n(), UNDEFINED_NODE);
             auto G = std::make_shared<mutable_graph>();
             FlowType sol_weight = 0;
             timer t;
 
-            NodeID id = 2;
-            for (NodeID n : original_graph.nodes()) {
-                if (solution[n] != term1 && solution[n] != term2)
-                    continue;
+            std::vector<NodeID> vertices = block_vertices[term1];
+            vertices.insert(vertices.end(), block_vertices[term2].begin(),
+                            block_vertices[term2].end());
 
+            NodeID id = 2;
+            for (NodeID n : vertices) {
                 if (fixed_vertex[n]) {
                     mapping[n] = (solution[n] == term1 ? 0 : 1);
                 } else {
@@ -73,10 +116,7 @@ namespace VieCut {
             std::unordered_map<NodeID, EdgeWeight> edgesToFixed1;
             std::vector<std::pair<NodeID, NodeID> > edgesOnOriginal;
 
-            for (NodeID n : original_graph.nodes()) {
-                if (solution[n] != term1 && solution[n] != term2)
-                    continue;
-
+            for (NodeID n : vertices) {
                 NodeID m_n = mapping[n];
                 for (EdgeID e : original_graph.edges_of(n)) {
                     auto [t, w] = original_graph.getEdge(n, e);
@@ -133,24 +173,25 @@ namespace VieCut {
                 noImprovement.emplace_back(f);
             }
             size_t improvement = (sol_weight - f);
-            std::vector<NodeID> movedVertices;
-            for (NodeID n : original_graph.nodes()) {
-                if (solution[n] == term1 || solution[n] == term2) {
-                    if (fixed_vertex[n]) {
-                        if (zero.count(mapping[n]) != (solution[n] == term1)) {
-                            LOG1 << "DIFFERENT";
-                            exit(1);
-                        }
+            block_vertices[term1].clear();
+            block_vertices[term2].clear();
+            for (NodeID n : vertices) {
+                if (fixed_vertex[n]) {
+                    if (zero.count(mapping[n]) != (solution[n] == term1)) {
+                        LOG1 << "DIFFERENT";
+                        exit(1);
                     }
+                }
 
-                    NodeID map = mapping[n];
+                NodeID map = mapping[n];
+                mapping[n] = UNDEFINED_NODE;
 
-                    if (zero.count(map) > 0) {
-                        solution[n] = term1;
-                    } else {
-                        solution[n] = term2;
-                    }
+                if (zero.count(map) > 0) {
+                    solution[n] = term1;
+                } else {
+                    solution[n] = term2;
                 }
+                block_vertices[solution[n]].emplace_back(n);
             }
 
             LOG0 << "done " << t.elapsed() << " improvement " << improvement
@@ -175,8 +216,15 @@ namespace VieCut {
                 b.resize(original_terminals.size(), 0);
             }
 
+            mapping.resize(original_graph.n(), UNDEFINED_NODE);
+            block_vertices.resize(num_blocks);
+            for (auto& b : block_vertices) {
+                b.clear();
+            }
+
             for (NodeID n : original_graph.nodes()) {
                 NodeID blockn = solution[n];
+                block_vertices[blockn].emplace_back(n);
                 for (EdgeID e : original_graph.edges_of(n)) {
                     auto [t, w] = original_graph.getEdge(n, e);
                     if (solution[t] > blockn) {
@@ -209,6 +257,7 @@ namespace VieCut {
                     break;
                 }
                 auto [impr, connect] = flowBetweenBlocks(a, b);
+                connectivity_valid = false;
                 improvement += impr;
                 sLOG0 << "out" << a << b << c << impr << connect;
                 previousConnectivity[a][b] = connect;
@@ -219,6 +268,7 @@ namespace VieCut {
         }
 
         EdgeWeight gainLocalSearch() {
+            connectivity_valid = false;
             bool inexact = configuration::getConfig()->inexact;
             FlowType improvement = 0;
             std::vector<NodeID>& current_solution = *sol;
@@ -316,22 +366,403 @@ namespace VieCut {
             return improvement;
         }
 
-     public:
-        FlowType improveSolution(const timer& time) {
+        void buildConnectivity() {
+            const std::vector<NodeID>& solution = *sol;
+            NodeID n = original_graph.n();
+            conn_begin.resize(n + 1);
+            conn_size.assign(n, 0);
+            max_weighted_degree = 0;
+            EdgeID slots = 0;
+            for (NodeID v : original_graph.nodes()) {
+                conn_begin[v] = slots;
+                slots += std::min(static_cast<EdgeID>(num_blocks),
+                                  original_graph.get_first_invalid_edge(v));
+                max_weighted_degree = std::max(
+                    max_weighted_degree,
+                    original_graph.getWeightedNodeDegree(v));
+            }
+            conn_begin[n] = slots;
+            conn.resize(slots);
+
+            for (NodeID v : original_graph.nodes()) {
+                for (EdgeID e : original_graph.edges_of(v)) {
+                    auto [t, w] = original_graph.getEdge(v, e);
+                    addConnectivity(v, solution[t], w);
+                }
+            }
+            connectivity_valid = true;
+        }
+
+        EdgeWeight connectivity(NodeID v, NodeID block) const {
+            EdgeID begin = conn_begin[v];
+            for (EdgeID i = begin; i < begin + conn_size[v]; ++i) {
+                if (conn[i].first == block)
+                    return conn[i].second;
+            }
+            return 0;
+        }
+
+        void addConnectivity(NodeID v, NodeID block, EdgeWeight w) {
+            EdgeID begin = conn_begin[v];
+            EdgeID end = begin + conn_size[v];
+            for (EdgeID i = begin; i < end; ++i) {
+                if (conn[i].first == block) {
+                    conn[i].second += w;
+                    return;
+                }
+            }
+            conn[end] = std::make_pair(block, w);
+            conn_size[v]++;
+        }
+
+        void removeConnectivity(NodeID v, NodeID block, EdgeWeight w) {
+            EdgeID begin = conn_begin[v];
+            EdgeID last = begin + conn_size[v] - 1;
+            for (EdgeID i = begin; i <= last; ++i) {
+                if (conn[i].first == block) {
+                    conn[i].second -= w;
+                    if (conn[i].second == 0) {
+                        conn[i] = conn[last];
+                        conn_size[v]--;
+                    }
+                    return;
+                }
+            }
+        }
+
+        // block with the highest connectivity to v other than its own and
+        // the gain of moving v there, UNDEFINED_NODE if v is not boundary
+        std::pair<NodeID, FlowType> bestMove(NodeID v) const {
+            NodeID own = (*sol)[v];
+            NodeID best = UNDEFINED_NODE;
+            EdgeWeight best_wgt = 0;
+            EdgeWeight own_wgt = 0;
+            EdgeID begin = conn_begin[v];
+            for (EdgeID i = begin; i < begin + conn_size[v]; ++i) {
+                auto [block, w] = conn[i];
+                if (block == own) {
+                    own_wgt = w;
+                } else if (best == UNDEFINED_NODE || w > best_wgt) {
+                    best = block;
+                    best_wgt = w;
+                }
+            }
+            return std::make_pair(best, static_cast<FlowType>(best_wgt)
+                                  - static_cast<FlowType>(own_wgt));
+        }
+
+        void moveVertex(NodeID v, NodeID to) {
+            std::vector<NodeID>& solution = *sol;
+            NodeID from = solution[v];
+            for (EdgeID e : original_graph.edges_of(v)) {
+                auto [t, w] = original_graph.getEdge(v, e);
+                removeConnectivity(t, from, w);
+                addConnectivity(t, to, w);
+            }
+            solution[v] = to;
+        }
+
+        // node_bucket_pq stores gains in [-span, span] as unsigned Gain
+        static Gain bucketGain(FlowType gain, EdgeWeight span) {
+            FlowType s = static_cast<FlowType>(span);
+            return static_cast<Gain>(std::clamp(gain, -s, s));
+        }
+
+        // k-way fm: repeatedly moves the unmoved boundary vertex with the
+        // highest gain to its best block, also if the gain is negative, and
+        // afterwards rolls back to the best solution seen during the pass.
+        // fixed vertices are never moved, so no block becomes empty.
+        // returns the decrease of the cut weight
+        FlowType fmLocalSearch() {
+            std::vector<NodeID>& solution = *sol;
+            if (!connectivity_valid) {
+                buildConnectivity();
+            }
+            EdgeWeight span = std::min(max_weighted_degree, MAX_GAIN_SPAN);
+            if (!gain_pq) {
+                gain_pq = std::make_unique<node_bucket_pq>(
+                    original_graph.n(), span);
+                locked.resize(original_graph.n(), false);
+            }
+            node_bucket_pq& pq = *gain_pq;
+
+            // random insertion order to break ties between equal gains
+            std::vector<NodeID> permute(original_graph.n(), 0);
+            random_functions::permutate_vector_good(&permute, true);
+            for (NodeID v : permute) {
+                if (fixed_vertex[v])
+                    continue;
+                auto [block, gain] = bestMove(v);
+                if (block != UNDEFINED_NODE) {
+                    pq.insert(v, bucketGain(gain, span));
+                }
+            }
+
+            moves.clear();
+            FlowType current = 0;
+            FlowType best = 0;
+            size_t best_prefix = 0;
+            while (!pq.empty()
+                   && moves.size() - best_prefix < MAX_UNSUCCESSFUL_MOVES) {
+                NodeID v = pq.deleteMax();
+                auto [block, gain] = bestMove(v);
+                moves.emplace_back(v, solution[v]);
+                locked[v] = true;
+                moveVertex(v, block);
+                current += gain;
+                if (current > best) {
+                    best = current;
+                    best_prefix = moves.size();
+                }
+
+                for (EdgeID e : original_graph.edges_of(v)) {
+                    NodeID t = original_graph.getEdgeTarget(v, e);
+                    if (fixed_vertex[t] || locked[t])
+                        continue;
+                    auto [t_block, t_gain] = bestMove(t);
+                    if (t_block == UNDEFINED_NODE) {
+                        if (pq.contains(t))
+                            pq.deleteNode(t);
+                    } else if (pq.contains(t)) {
+                        pq.changeKey(t, bucketGain(t_gain, span));
+                    } else {
+                        pq.insert(t, bucketGain(t_gain, span));
+                    }
+                }
+            }
+
+            while (!pq.empty()) {
+                pq.deleteMax();
+            }
+
+            for (size_t i = moves.size(); i > best_prefix; --i) {
+                auto [v, from] = moves[i - 1];
+                moveVertex(v, from);
+            }
+            for (auto [v, from] : moves) {
+                locked[v] = false;
+            }
+            LOG0 << "fm moved " << moves.size() << " kept " << best_prefix
+                 << " improvement " << best;
+            return best;
+        }
+
+        // two-way fm between blocks a and b on the region around the
+        // given boundary vertices. only vertices of a and b are read and
+        // the solution is not changed, the vertices that should switch
+        // their block are returned in moved. as blocks outside of a and b
+        // are not affected by these moves, the local searches on disjoint
+        // block pairs are independent
+        FlowType pairLocalSearch(NodeID a, NodeID b,
+                                 const std::vector<NodeID>& seeds,
+                                 std::vector<NodeID>* moved) {
+            const std::vector<NodeID>& solution = *sol;
+            auto inPair = [&solution, a, b](NodeID v) {
+                              return solution[v] == a || solution[v] == b;
+                          };
+
+            std::vector<NodeID> region;
+            for (NodeID v : seeds) {
+                if (inPair(v) && region_id[v] == UNDEFINED_NODE) {
+                    region_id[v] = region.size();
+                    region.emplace_back(v);
+                }
+            }
+            size_t level_begin = 0;
+            for (size_t depth = 1; depth < REGION_DEPTH; ++depth) {
+                size_t level_end = region.size();
+                for (size_t i = level_begin; i < level_end; ++i) {
+                    for (EdgeID e : original_graph.edges_of(region[i])) {
+                        NodeID t = original_graph.getEdgeTarget(region[i], e);
+                        if (inPair(t) && !fixed_vertex[t]
+                            && region_id[t] == UNDEFINED_NODE) {
+                            region_id[t] = region.size();
+                            region.emplace_back(t);
+                        }
+                    }
+                }
+                level_begin = level_end;
+            }
+
+            std::vector<FlowType> gain(region.size(), 0);
+            EdgeWeight span = 0;
+            for (size_t i = 0; i < region.size(); ++i) {
+                NodeID v = region[i];
+                for (EdgeID e : original_graph.edges_of(v)) {
+                    auto [t, w] = original_graph.getEdge(v, e);
+                    if (!inPair(t))
+                        continue;
+                    if (solution[t] == solution[v]) {
+                        gain[i] -= w;
+                    } else {
+                        gain[i] += w;
+                    }
+                }
+                span = std::max(span,
+                                original_graph.getWeightedNodeDegree(v));
+            }
+            span = std::min(span, MAX_GAIN_SPAN);
+
+            node_bucket_pq pq(region.size(), span);
+            for (size_t i = 0; i < region.size(); ++i) {
+                pq.insert(i, bucketGain(gain[i], span));
+            }
+
+            // every region vertex moves at most once, so a vertex is on
+            // its original side iff it is not locked
+            std::vector<bool> region_locked(region.size(), false);
+            std::vector<NodeID> region_moves;
+            FlowType current = 0;
+            FlowType best = 0;
+            size_t best_prefix = 0;
+            while (!pq.empty() && region_moves.size() - best_prefix
+                   < MAX_UNSUCCESSFUL_MOVES) {
+                NodeID i = pq.deleteMax();
+                region_locked[i] = true;
+                region_moves.emplace_back(i);
+                current += gain[i];
+                if (current > best) {
+                    best = current;
+                    best_prefix = region_moves.size();
+                }
+
+                NodeID v = region[i];
+                for (EdgeID e : original_graph.edges_of(v)) {
+                    auto [t, w] = original_graph.getEdge(v, e);
+                    if (!inPair(t))
+                        continue;
+                    NodeID j = region_id[t];
+                    if (j == UNDEFINED_NODE || region_locked[j])
+                        continue;
+                    // edge (v, t) changes from uncut to cut or vice versa
+                    if (solution[t] == solution[v]) {
+                        gain[j] += 2 * w;
+                    } else {
+                        gain[j] -= 2 * w;
+                    }
+                    pq.changeKey(j, bucketGain(gain[j], span));
+                }
+            }
+
+            for (size_t i = 0; i < best_prefix; ++i) {
+                moved->emplace_back(region[region_moves[i]]);
+            }
+            for (NodeID v : region) {
+                region_id[v] = UNDEFINED_NODE;
+            }
+            return best;
+        }
+
+        // parallel fm: the boundary vertices are grouped by the pair of
+        // blocks they lie between. pairs that share no block are
+        // independent and their regions are improved concurrently by
+        // pairLocalSearch, in rounds of such disjoint pairs
+        FlowType parallelFmLocalSearch() {
+            connectivity_valid = false;
+            std::vector<NodeID>& solution = *sol;
+            region_id.resize(original_graph.n(), UNDEFINED_NODE);
+
+            std::unordered_map<uint64_t, std::vector<NodeID> > pair_seeds;
+            std::vector<NodeID> adjacent_blocks;
+            for (NodeID v : original_graph.nodes()) {
+                if (fixed_vertex[v])
+                    continue;
+                adjacent_blocks.clear();
+                for (EdgeID e : original_graph.edges_of(v)) {
+                    NodeID block = solution[original_graph.getEdgeTarget(v, e)];
+                    if (block != solution[v]
+                        && std::find(adjacent_blocks.begin(),
+                                     adjacent_blocks.end(), block)
+                        == adjacent_blocks.end()) {
+                        adjacent_blocks.emplace_back(block);
+                        NodeID lo = std::min(block, solution[v]);
+                        NodeID hi = std::max(block, solution[v]);
+                        pair_seeds[static_cast<uint64_t>(lo) * num_blocks + hi]
+                        .emplace_back(v);
+                    }
+                }
+            }
+
+            // largest boundaries first
+            std::vector<std::pair<uint64_t, std::vector<NodeID> > > pairs(
+                pair_seeds.begin(), pair_seeds.end());
+            std::sort(pairs.begin(), pairs.end(),
+                      [](const auto& p1, const auto& p2) {
+                          return p1.second.size() > p2.second.size();
+                      });
+
+            FlowType improvement = 0;
+            std::vector<bool> done(pairs.size(), false);
+            size_t num_done = 0;
+            while (num_done < pairs.size()) {
+                std::vector<bool> block_used(num_blocks, false);
+                std::vector<size_t> round;
+                for (size_t i = 0; i < pairs.size(); ++i) {
+                    NodeID a = pairs[i].first / num_blocks;
+                    NodeID b = pairs[i].first % num_blocks;
+                    if (!done[i] && !block_used[a] && !block_used[b]) {
+                        block_used[a] = true;
+                        block_used[b] = true;
+                        done[i] = true;
+                        round.emplace_back(i);
+                    }
+                }
+                num_done += round.size();
+
+                std::vector<std::vector<NodeID> > moved(round.size());
+    #pragma omp parallel for schedule(dynamic) reduction(+ : improvement)
+                for (size_t r = 0; r < round.size(); ++r) {
+                    const auto& [key, seeds] = pairs[round[r]];
+                    improvement += pairLocalSearch(key / num_blocks,
+                                                   key % num_blocks,
+                                                   seeds, &moved[r]);
+                }
+
+                for (size_t r = 0; r < round.size(); ++r) {
+                    NodeID a = pairs[round[r]].first / num_blocks;
+                    NodeID b = pairs[round[r]].first % num_blocks;
+                    for (NodeID v : moved[r]) {
+                        solution[v] = (solution[v] == a ? b : a);
+                    }
+                }
+            }
+            LOG0 << "parallel fm on " << pairs.size() << " block pairs"
+                 << " improvement " << improvement;
+            return improvement;
+        }
+
+        // runs the vertex moving local search selected in the configuration
+        // until it does not find an improvement
+        FlowType vertexLocalSearch() {
+            const std::string& algorithm =
+                configuration::getConfig()->local_search_algorithm;
             FlowType total_improvement = 0;
             bool change_found = true;
             while (change_found) {
                 timer t;
-                change_found = false;
-                auto impGain = gainLocalSearch();
-                total_improvement += impGain;
-                LOG0 << "gain " << t.elapsed() << "s impro " << impGain;
-
-                if (impGain > 0)
-                    change_found = true;
+                FlowType improvement;
+                if (algorithm == "fm") {
+                    improvement = fmLocalSearch();
+                } else if (algorithm == "parallel_fm") {
+                    improvement = parallelFmLocalSearch();
+                } else if (algorithm == "gain") {
+                    improvement = gainLocalSearch();
+                } else {
+                    LOG1 << "Error: unknown local search " << algorithm;
+                    exit(1);
+                }
+                total_improvement += improvement;
+                LOG0 << algorithm << " " << t.elapsed() << "s impro "
+                     << improvement;
+                change_found = (improvement > 0);
             }
+            return total_improvement;
+        }
 
-            change_found = true;
+     public:
+        FlowType improveSolution(const timer& time) {
+            FlowType total_improvement = vertexLocalSearch();
+            bool change_found = true;
 
             while (change_found) {
                 timer t;
@@ -345,20 +776,7 @@ namespace VieCut {
                 LOG0 << "flow " << t.elapsed() << "s impro " << impFlow;
             }
 
-            change_found = true;
-
-            while (change_found) {
-                timer t;
-                change_found = false;
-                auto impGain = gainLocalSearch();
-                total_improvement += impGain;
-                LOG0 << "gain " << t.elapsed() << "s impro " << impGain;
-
-                if (impGain > 0)
-                    change_found = true;
-            }
-
-            // fixLargestFlow();
+            total_improvement += vertexLocalSearch();
             return total_improvement;
         }
     };
@@ -10,13 +10,19 @@
  *****************************************************************************/
 #pragma once
 
-#include <future>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "algorithms/flow/boykov_kolmogorov.h"
+#include "algorithms/flow/flow_statistics.h"
+#include "algorithms/flow/parallel_push_relabel.h"
 #include "algorithms/flow/push_relabel.h"
+#include "algorithms/multicut/flow_solver_pool.h"
 #include "algorithms/multicut/graph_contraction.h"
 #include "algorithms/multicut/multicut_problem.h"
 #include "common/configuration.h"
@@ -27,11 +33,66 @@ namespace VieCut {
     class maximum_flow {
      public:
         explicit maximum_flow(std::vector<NodeID> o)
-            : original_terminals(o),
-              num_threads(configuration::getConfig()->threads) { }
+            : original_terminals(o) { }
+
+        // flow algorithm for the flows of a problem. "auto" uses
+        // boykov_kolmogorov if the sum of terminal degrees, which bounds the
+        // number of augmenting paths in all isolating flows, is at most the
+        // number of edges, and push_relabel otherwise
+        static std::string flowAlgorithm(problemPointer problem) {
+            const std::string& algorithm =
+                configuration::getConfig()->flow_algorithm;
+            if (algorithm != "auto") {
+                return algorithm;
+            }
+
+            EdgeWeight terminal_degrees = 0;
+            for (const auto& t : problem->terminals) {
+                terminal_degrees +=
+                    problem->graph->getWeightedNodeDegree(t.position);
+            }
+            if (terminal_degrees <= problem->graph->m()) {
+                return "boykov_kolmogorov";
+            } else {
+                return "push_relabel";
+            }
+        }
+
+        // single flow, computed by the given flow algorithm. if stats is
+        // given, the statistics of the flow are added to it
+        static std::pair<FlowType, std::vector<NodeID> > singleFlow(
+            mutableGraphPtr G, const std::vector<NodeID>& terminals,
+            NodeID source, const std::string& algorithm,
+            flow_statistics* stats = nullptr) {
+            if (algorithm == "push_relabel") {
+                push_relabel pr;
+                auto result = pr.solve_max_flow_min_cut(
+                    G, terminals, source, true);
+                if (stats)
+                    stats->add(pr.getStatistics());
+                return result;
+            }
+            if (algorithm == "parallel_push_relabel") {
+                parallel_push_relabel pr;
+                auto result = pr.solve_max_flow_min_cut(
+                    G, terminals, source, true);
+                if (stats)
+                    stats->add(pr.getStatistics());
+                return result;
+            }
+            if (algorithm == "boykov_kolmogorov") {
+                boykov_kolmogorov bk;
+                auto result = bk.solve_max_flow_min_cut(
+                    G, terminals, source, true);
+                if (stats)
+                    stats->add(bk.getStatistics());
+                return result;
+            }
+            LOG1 << "Error: unknown flow algorithm " << algorithm;
+            exit(1);
+        }
 
         void maximumSTFlow(problemPointer problem) {
-            push_relabel pr;
             auto G = problem->graph;
 
             std::vector<NodeID> current_terminals;
@@ -39,8 +100,10 @@ namespace VieCut {
                 current_terminals.emplace_back(t.position);
             }
 
-            auto [flow, isolating_block] =
-                pr.solve_max_flow_min_cut(G, current_terminals, 0, true);
+            flow_statistics stats;
+            auto [flow, isolating_block] = singleFlow(
+                G, current_terminals, 0, flowAlgorithm(problem), &stats);
+            addStatistics(stats);
 
             NodeID term0 = problem->terminals[0].original_id;
             NodeID term1 = problem->terminals[1].original_id;
@@ -95,21 +158,11 @@ namespace VieCut {
                                    const std::vector<bool>& active) {
             union_find uf(problem->graph->n());
             std::unordered_set<NodeID> previous;
+            std::string algorithm = flowAlgorithm(problem);
+            flow_statistics stats;
 
-            std::vector<std::future<std::vector<NodeID> > > futures;
-            std::vector<push_relabel<false, true> > prs(
-                configuration::getConfig()->random_flows +
-                configuration::getConfig()->high_distance_flows);
-            size_t pr_id = 0;
-
-            if (!configuration::getConfig()->disable_cpu_affinity) {
-                cpu_set_t all_cores;
-                CPU_ZERO(&all_cores);
-                for (size_t i = 0; i < num_threads; ++i) {
-                    CPU_SET(i, &all_cores);
-                }
-                sched_setaffinity(0, sizeof(cpu_set_t), &all_cores);
-            }
+            // if parallel, the flows are computed by the flow solver pool
+            std::vector<flow_solver_pool::flow_job> jobs;
 
             for (const auto& t : problem->terminals) {
                 previous.insert(t.position);
@@ -134,17 +187,14 @@ namespace VieCut {
                     terms.emplace_back(t.position);
                 }
                 terms.emplace_back(r);
-                size_t num_t = terms.size() - 1;
+                NodeID num_t = terms.size() - 1;
 
                 if (parallel) {
-                    futures.emplace_back(
-                        std::async(&push_relabel<false, true>::callable_max_flow,
-                                   &prs[pr_id++],
-                                   problem->graph, terms, num_t, true));
+                    jobs.push_back({ problem->graph, terms, num_t, { } });
                 } else {
-                    push_relabel pr;
-                    auto sourceSet = pr.solve_max_flow_min_cut(
-                        problem->graph, terms, num_t, true).second;
+                    auto sourceSet =
+                        singleFlow(problem->graph, terms, num_t,
+                                   algorithm, &stats).second;
 
                     for (const auto& s : sourceSet) {
                         uf.Union(s, r);
@@ -170,17 +220,14 @@ namespace VieCut {
                 }
                 terms.emplace_back(r);
                 push_relabel pr;
-                size_t num_t = terms.size() - 1;
+                NodeID num_t = terms.size() - 1;
 
                 if (parallel) {
-                    futures.emplace_back(
-                        std::async(&push_relabel<false, true>::callable_max_flow,
-                                   &prs[pr_id++],
-                                   problem->graph, terms, num_t, true));
+                    jobs.push_back({ problem->graph, terms, num_t, { } });
                 } else {
-                    push_relabel pr;
-                    auto sourceSet = pr.solve_max_flow_min_cut(
-                        problem->graph, terms, num_t, true).second;
+                    auto sourceSet =
+                        singleFlow(problem->graph, terms, num_t,
+                                   algorithm, &stats).second;
 
                     for (const auto& s : sourceSet) {
                         uf.Union(s, r);
@@ -188,20 +235,19 @@ namespace VieCut {
                 }
             }
 
-            for (size_t i = 0; i < futures.size(); ++i) {
-                auto& t = futures[i];
-                const auto& vec = t.get();
-                NodeID head = vec[0];
-                for (const auto& n : vec) {
+            flow_solver_pool::getPool().run(&jobs, algorithm, &stats);
+            for (const auto& job : jobs) {
+                NodeID head = job.source_set[0];
+                for (const auto& n : job.source_set) {
                     uf.Union(n, head);
                 }
             }
 
+            addStatistics(stats);
             return uf;
         }
 
-        void maximumIsolatingFlow(problemPointer problem,
-                                  size_t thread_id, bool parallel) {
+        void maximumIsolatingFlow(problemPointer problem, bool parallel) {
             graph_contraction::setTerminals(problem, original_terminals);
             std::vector<std::vector<NodeID> > maxVolIsoBlock;
             std::vector<NodeID> curr_terminals;
@@ -211,42 +257,33 @@ namespace VieCut {
                 orig_index.emplace_back(t.original_id);
             }
 
-            bool parallel_flows = false;
-            std::vector<std::future<std::vector<NodeID> > > futures;
-            // so futures don't lose their object :)
-            std::vector<push_relabel<false, true> > prs(problem->terminals.size());
-            if (parallel) {
-                // in the beginning when we don't have many problems
-                // already (but big graphs), we can start a thread per flow.
-                // later on, we have a problem for each processor to work on,
-                // so we run sequential flows
-                parallel_flows = true;
-            }
+            // all isolating flows are on the same graph, so a single
+            // boykov_kolmogorov object builds the residual graph only once
+            std::string algorithm = flowAlgorithm(problem);
+            boykov_kolmogorov bk;
+            flow_statistics stats;
+
+            // in the beginning when we don't have many problems
+            // already (but big graphs), the flows are computed in parallel
+            // by the flow solver pool. later on, we have a problem for each
+            // processor to work on, so we run sequential flows
+            std::vector<flow_solver_pool::flow_job> jobs;
 
             for (NodeID i = 0; i < problem->terminals.size(); ++i) {
                 if (problem->terminals[i].invalid_flow) {
-                    if (parallel_flows) {
+                    if (parallel) {
                         maxVolIsoBlock.emplace_back();
-                        if (!configuration::getConfig()->disable_cpu_affinity) {
-                            cpu_set_t all_cores;
-                            CPU_ZERO(&all_cores);
-                            for (size_t i = 0; i < num_threads; ++i) {
-                                CPU_SET(i, &all_cores);
-                            }
-                            sched_setaffinity(0, sizeof(cpu_set_t), &all_cores);
-                        }
-                        futures.emplace_back(
-                            std::async(
-                                &push_relabel<false, true>::callable_max_flow,
-                                &prs[i], problem->graph, curr_terminals,
-                                i, true));
+                        jobs.push_back(
+                            { problem->graph, curr_terminals, i, { } });
+                    } else if (algorithm == "boykov_kolmogorov") {
+                        maxVolIsoBlock.emplace_back(
+                            bk.callable_max_flow(problem->graph,
+                                                 curr_terminals, i, true));
+                        stats.add(bk.getStatistics());
                     } else {
-                        push_relabel pr;
                         maxVolIsoBlock.emplace_back(
-                            pr.solve_max_flow_min_cut(problem->graph,
-                                                      curr_terminals,
-                                                      i,
-                                                      true).second);
+                            singleFlow(problem->graph, curr_terminals,
+                                       i, algorithm, &stats).second);
                     }
 
                     problem->terminals[i].invalid_flow = false;
@@ -257,20 +294,12 @@ namespace VieCut {
                 }
             }
 
-            if (parallel_flows) {
-                for (size_t i = 0; i < futures.size(); ++i) {
-                    auto& t = futures[i];
-                    maxVolIsoBlock[i] = t.get();
-                }
-
-                if (!configuration::getConfig()->disable_cpu_affinity) {
-                    cpu_set_t my_id;
-                    CPU_ZERO(&my_id);
-                    CPU_SET(thread_id, &my_id);
-                    sched_setaffinity(0, sizeof(cpu_set_t), &my_id);
-                }
+            flow_solver_pool::getPool().run(&jobs, algorithm, &stats);
+            for (auto& job : jobs) {
+                maxVolIsoBlock[job.source].swap(job.source_set);
             }
 
+            addStatistics(stats);
             graph_contraction::contractIsolatingBlocks(problem, maxVolIsoBlock);
 
             EdgeWeight maximum = 0;
@@ -306,7 +335,21 @@ namespace VieCut {
             graph_contraction::setTerminals(problem, original_terminals);
         }
 
+        // statistics of all flows computed by this object
+        flow_statistics getFlowStatistics() {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            return flow_stats;
+        }
+
+     private:
+        // flows are computed by multiple threads at the same time
+        void addStatistics(const flow_statistics& stats) {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            flow_stats.add(stats);
+        }
+
         std::vector<NodeID> original_terminals;
-        size_t num_threads;
+        flow_statistics flow_stats;
+        std::mutex stats_mutex;
     };
 }
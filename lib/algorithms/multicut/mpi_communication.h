@@ -13,15 +13,56 @@
 #include <mpi.h>
 
 #include <chrono>
+#include <limits>
+#include <list>
 #include <memory>
 #include <optional>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #include "algorithms/multicut/multicut_problem.h"
 #include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+#include "tools/varint.h"
 
 namespace VieCut {
+    // Sizes and timings of the subproblems sent to and received from other
+    // processes. time_send is the time until a non-blocking send finished,
+    // as far as observed by mpi_communication::progressSends.
+    struct transfer_statistics {
+        size_t problems_sent = 0;
+        size_t problems_received = 0;
+        size_t bytes_sent = 0;
+        // size the sent problems had in the previous 64 bit word format
+        size_t legacy_bytes_sent = 0;
+        size_t bytes_received = 0;
+        double time_encode = 0;
+        double time_send = 0;
+        double time_receive = 0;
+        double time_decode = 0;
+
+        std::string toString() const {
+            std::stringstream ss;
+            ss << "problems_sent=" << problems_sent
+               << " problems_received=" << problems_received
+               << " bytes_sent=" << bytes_sent
+               << " legacy_bytes_sent=" << legacy_bytes_sent
+               << " bytes_received=" << bytes_received
+               << " time_encode=" << time_encode
+               << " time_send=" << time_send
+               << " time_receive=" << time_receive
+               << " time_decode=" << time_decode;
+            return ss.str();
+        }
+    };
+
     class mpi_communication {
      public:
         static const bool debug = false;
@@ -34,6 +75,7 @@ namespace VieCut {
         }
 
         FlowType getGlobalBestSolution() {
+            progressSends();
             int result = 1;
             while (result > 0) {
                 MPI_Status status;
@@ -71,77 +113,225 @@ namespace VieCut {
             }
         }
 
+        // encodes the problem and starts a non-blocking send, so the sending
+        // thread continues with its own problems while the data is in
+        // transit. the buffer is freed in progressSends once the send is done
         void sendProblem(problemPointer problem, size_t tgt) {
-            LOG1 << mpi_rank << " sends problem to " << tgt;
-            std::vector<uint64_t> data;
-            data.emplace_back(problem->lower_bound);
-            data.emplace_back(problem->upper_bound);
-            data.emplace_back(problem->deleted_weight);
-            data.emplace_back(problem->terminals.size());
-
-            for (const auto& [t, o, b] : problem->terminals) {
-                (void)b;
-                data.emplace_back(t);
-                data.emplace_back(o);
+            timer t;
+            std::vector<uint8_t> data = encodeProblem(problem);
+            if (data.size() > std::numeric_limits<int>::max()) {
+                LOG1 << "ERROR: problem of " << data.size()
+                     << " bytes is too large to send";
+                exit(1);
             }
+            size_t legacy_bytes = legacySize(problem);
+            stats.time_encode += t.elapsed();
+            stats.problems_sent++;
+            stats.bytes_sent += data.size();
+            stats.legacy_bytes_sent += legacy_bytes;
+            LOG1 << mpi_rank << " sends problem to " << tgt << " ("
+                 << data.size() << " bytes, " << legacy_bytes
+                 << " uncompressed)";
 
-            data.emplace_back(problem->mappings.size());
-            for (size_t i = 0; i < problem->mappings.size(); ++i) {
-                data.emplace_back(problem->mappings[i]->size());
-                data.insert(data.end(), problem->mappings[i]->begin(),
-                            problem->mappings[i]->end());
+            if (retain_sent) {
+                sent_current.emplace_back(data);
             }
 
-            auto serial = problem->graph->serialize();
-            data.emplace_back(serial.size());
-            data.insert(data.end(), serial.begin(), serial.end());
-
-            size_t datasize = data.size();
-            MPI_Send(&datasize, 1, MPI_LONG, tgt, 1010, MPI_COMM_WORLD);
-            MPI_Send(&data.front(), datasize, MPI_LONG, tgt, 1020, MPI_COMM_WORLD);
+            pending_sends.emplace_back();
+            pending_send& ps = pending_sends.back();
+            ps.data = std::move(data);
+            MPI_Isend(ps.data.data(), ps.data.size(), MPI_BYTE, tgt, 1020,
+                      MPI_COMM_WORLD, &ps.request);
+            progressSends();
         }
 
         problemPointer recvProblem(size_t src) {
-            size_t datasize = 0;
-            MPI_Recv(&datasize, 1, MPI_LONG, src, 1010,
-                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            std::vector<uint64_t> data(datasize);
-            MPI_Recv(&data.front(), datasize, MPI_LONG, src, 1020,
+            timer t;
+            MPI_Status status;
+            MPI_Probe(src, 1020, MPI_COMM_WORLD, &status);
+            int datasize = 0;
+            MPI_Get_count(&status, MPI_BYTE, &datasize);
+            std::vector<uint8_t> data(datasize);
+            MPI_Recv(data.data(), datasize, MPI_BYTE, src, 1020,
                      MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            stats.time_receive += t.elapsed();
+
+            t.restart();
+            auto problem = decodeProblem(data);
+            if (problem == nullptr) {
+                LOG1 << "ERROR: " << mpi_rank << " received malformed problem"
+                     << " from " << src;
+                exit(1);
+            }
+            stats.time_decode += t.elapsed();
+            stats.problems_received++;
+            stats.bytes_received += datasize;
+            LOG << mpi_rank << " returns new problem";
+            return problem;
+        }
+
+        // frees the buffers of finished sends. only called by the thread
+        // that sends problems
+        void progressSends() {
+            for (auto it = pending_sends.begin(); it != pending_sends.end(); ) {
+                int done = 0;
+                MPI_Test(&it->request, &done, MPI_STATUS_IGNORE);
+                if (done) {
+                    stats.time_send += it->t.elapsed();
+                    it = pending_sends.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
 
+        // has to be called before MPI_Finalize
+        void waitForSends() {
+            for (auto& ps : pending_sends) {
+                MPI_Wait(&ps.request, MPI_STATUS_IGNORE);
+                stats.time_send += ps.t.elapsed();
+            }
+            pending_sends.clear();
+        }
+
+        const transfer_statistics& getTransferStatistics() const {
+            return stats;
+        }
+
+        // bounds, terminals, the mapping chain composed into a single
+        // mapping, the branch of a lazy problem and the graph in
+        // mutable_graph::serializeCompact format, all as variable length
+        // integers. lazy problems are sent with the graph of their parent,
+        // so the receiver applies the branch and computes the flows
+        static std::vector<uint8_t> encodeProblem(problemPointer problem) {
+            std::vector<uint8_t> data;
+            encodeHeader(problem, &data);
+            problem->graph->serializeCompact(&data);
+            return data;
+        }
+
+        // everything but the graph, which encodeProblem appends to it.
+        // siblings of a lazy problem share their graph, so it can be stored
+        // once for all of them
+        static void encodeHeader(problemPointer problem,
+                                 std::vector<uint8_t>* data) {
+            varint::writeSigned(data, problem->lower_bound);
+            varint::writeSigned(data, problem->upper_bound);
+            varint::write(data, problem->deleted_weight);
+            varint::write(data, problem->terminals.size());
+            for (const auto& t : problem->terminals) {
+                varint::write(data, t.position);
+                varint::write(data, t.original_id);
+            }
+
+            if (problem->mappings.empty()) {
+                varint::write(data, 0);
+            } else {
+                NodeID n = problem->mappings[0]->size();
+                varint::write(data, n);
+                for (NodeID v = 0; v < n; ++v) {
+                    varint::write(data, problem->mapped(v));
+                }
+            }
+
+            if (problem->isLazy()) {
+                uint64_t branch_vertex = problem->branch_vertex;
+                varint::write(data, branch_vertex + 1);
+                // UNDEFINED_NODE if the vertex is in none of the blocks
+                varint::write(data, problem->branch_terminal);
+            } else {
+                varint::write(data, 0);
+            }
+        }
+
+        // returns nullptr if the data is malformed
+        static problemPointer decodeProblem(const std::vector<uint8_t>& data) {
+            size_t pos = 0;
+            auto problem = decodeHeader(data, &pos);
+            if (problem == nullptr)
+                return nullptr;
+            problem->graph = mutable_graph::deserializeCompact(data, &pos);
+            if (problem->graph == nullptr || pos != data.size()
+                || !validBranch(problem))
+                return nullptr;
+            return problem;
+        }
+
+        // reads a header written by encodeHeader starting at *pos and moves
+        // *pos behind it. the graph of the problem is not set. returns
+        // nullptr if the data is malformed
+        static problemPointer decodeHeader(const std::vector<uint8_t>& data,
+                                           size_t* pos_ptr) {
             auto problem = std::make_shared<multicut_problem>();
-            problem->lower_bound = data[0];
-            problem->upper_bound = data[1];
-            problem->deleted_weight = data[2];
-            size_t num_terminals = data[3];
-            size_t next_index = 4;
+            size_t& pos = *pos_ptr;
+            int64_t lower, upper;
+            uint64_t deleted, num_terminals;
+            if (!varint::readSigned(data, &pos, &lower)
+                || !varint::readSigned(data, &pos, &upper)
+                || !varint::read(data, &pos, &deleted)
+                || !varint::read(data, &pos, &num_terminals)
+                || num_terminals > data.size()) {
+                return nullptr;
+            }
+            problem->lower_bound = lower;
+            problem->upper_bound = upper;
+            problem->deleted_weight = deleted;
+
             for (size_t i = 0; i < num_terminals; ++i) {
-                NodeID t = data[next_index++];
-                NodeID o = data[next_index++];
+                uint64_t t, o;
+                if (!varint::read(data, &pos, &t)
+                    || !varint::read(data, &pos, &o))
+                    return nullptr;
                 problem->terminals.emplace_back(t, o, true);
             }
 
-            size_t num_mappings = data[next_index++];
-            for (size_t i = 0; i < num_mappings; ++i) {
-                size_t map_size_i = data[next_index++];
-                problem->mappings.emplace_back(
-                    std::make_shared<std::vector<NodeID> >());
-                problem->mappings[i]->insert(problem->mappings[i]->end(),
-                                             &data[next_index],
-                                             &data[next_index + map_size_i]);
-                next_index += map_size_i;
+            uint64_t map_size;
+            if (!varint::read(data, &pos, &map_size) || map_size > data.size())
+                return nullptr;
+            if (map_size > 0) {
+                auto map = std::make_shared<std::vector<NodeID> >(map_size);
+                for (NodeID v = 0; v < map_size; ++v) {
+                    uint64_t m;
+                    if (!varint::read(data, &pos, &m))
+                        return nullptr;
+                    (*map)[v] = m;
+                }
+                problem->mappings.emplace_back(map);
             }
 
-            size_t serialsize = data[next_index++];
-            std::vector<uint64_t> serial;
-            serial.insert(serial.end(), &data[next_index],
-                          &data[next_index + serialsize]);
-
-            problem->graph = mutable_graph::deserialize(serial);
-            LOG << mpi_rank << " returns new problem";
+            uint64_t branch_vertex, branch_terminal = UNDEFINED_NODE;
+            if (!varint::read(data, &pos, &branch_vertex))
+                return nullptr;
+            if (branch_vertex > 0) {
+                if (!varint::read(data, &pos, &branch_terminal))
+                    return nullptr;
+                problem->branch_vertex = branch_vertex - 1;
+                problem->branch_terminal = branch_terminal;
+            }
             return problem;
         }
 
+        // whether the branch of a lazy problem refers to its graph
+        static bool validBranch(problemPointer problem) {
+            return !problem->isLazy()
+                   || (problem->branch_vertex
+                       < problem->graph->getOriginalNodes()
+                       && (problem->branch_terminal < problem->graph->n()
+                           || problem->branch_terminal == UNDEFINED_NODE));
+        }
+
+        // size in bytes of the previous format, which stored every value
+        // (including each edge twice) as a 64 bit word
+        static size_t legacySize(problemPointer problem) {
+            size_t words = 6 + 2 * problem->terminals.size();
+            for (const auto& map : problem->mappings) {
+                words += 1 + map->size();
+            }
+            mutableGraphPtr G = problem->graph;
+            words += 5 + 2 * G->n() + G->m() + G->getOriginalNodes();
+            return words * sizeof(uint64_t);
+        }
+
         std::optional<int> checkForReceiver() {
             int result;
             LOG0 << mpi_rank << "probing";
@@ -219,11 +409,41 @@ namespace VieCut {
             return bestSolutionLocal;
         }
 
+        // keep the encodings of sent problems for checkpoints. the processes
+        // write their checkpoints at different times, a problem sent after
+        // the checkpoint of the receiver is only in the one of the sender
+        void retainSentProblems(bool retain) {
+            retain_sent = retain;
+        }
+
+        // problems sent since the second to last call, so a problem is in
+        // the checkpoints of two intervals. problems that also are in the
+        // checkpoint of the receiver are solved twice after a resume
+        std::vector<std::vector<uint8_t> > sentProblemsForCheckpoint() {
+            std::vector<std::vector<uint8_t> > sent = sent_previous;
+            sent.insert(sent.end(), sent_current.begin(), sent_current.end());
+            sent_previous = std::move(sent_current);
+            sent_current.clear();
+            return sent;
+        }
+
      private:
+        struct pending_send {
+            // list elements are never moved, so the buffer stays valid
+            std::vector<uint8_t> data;
+            MPI_Request request;
+            timer t;
+        };
+
         int mpi_size;
         int mpi_rank;
         std::vector<MPI_Request> req;
         bool bestSolutionLocal;
         FlowType best_solution;
+        std::list<pending_send> pending_sends;
+        transfer_statistics stats;
+        bool retain_sent = false;
+        std::vector<std::vector<uint8_t> > sent_current;
+        std::vector<std::vector<uint8_t> > sent_previous;
     };
 }
@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "data_structure/mutable_graph.h"
+#include "data_structure/pair_bitset.h"
 #include "io/graph_io.h"
 
 namespace VieCut {
@@ -57,7 +58,7 @@ namespace VieCut {
                                std::numeric_limits<FlowType>::max(),
                                0,
                                { UNDEFINED_NODE, UNDEFINED_EDGE },
-                               std::unordered_set<NodeID>()) { }
+                               pair_bitset()) { }
 
         multicut_problem(mutableGraphPtr G,
                          std::vector<terminal> term,
@@ -67,7 +68,7 @@ namespace VieCut {
                          FlowType upper,
                          EdgeWeight deleted,
                          std::pair<NodeID, EdgeID> prio,
-                         std::unordered_set<NodeID> finished_bp)
+                         pair_bitset finished_bp)
             : graph(G),
               terminals(term),
               mappings(mappings),
@@ -77,6 +78,15 @@ namespace VieCut {
               priority_edge(prio),
               finished_blockpairs(finished_bp) { }
 
+        // problem created by branching that was not processed yet. it shares
+        // the graph of its parent with its siblings and only stores the
+        // branching decision: contract (original) vertex branch_vertex into
+        // the terminal at position branch_terminal after deleting its edges
+        // to all other terminals. see problem_management::applyBranch
+        bool isLazy() const {
+            return branch_vertex != UNDEFINED_NODE;
+        }
+
         NodeID mapped(NodeID n) const {
             NodeID n_coarse = n;
             for (const auto& map : mappings) {
@@ -85,40 +95,56 @@ namespace VieCut {
             return n_coarse;
         }
 
+        // appends the mapping of a new contraction level. if the chain gets
+        // longer than max_depth (0 = unlimited), it is composed into a single
+        // mapping, so mapped() does at most max_depth lookups. problems that
+        // are branched from this one copy the pointers and share the result
+        void addMapping(std::shared_ptr<std::vector<NodeID> > map,
+                        size_t max_depth) {
+            mappings.emplace_back(map);
+            if (max_depth > 0 && mappings.size() > max_depth) {
+                flattenMappings();
+            }
+        }
+
+        // composes all mappings into a single one, O(n * depth) time
+        void flattenMappings() {
+            if (mappings.size() < 2)
+                return;
+            auto flat = std::make_shared<std::vector<NodeID> >(
+                mappings[0]->size());
+            for (NodeID n = 0; n < flat->size(); ++n) {
+                (*flat)[n] = mapped(n);
+            }
+            mappings.clear();
+            mappings.emplace_back(flat);
+        }
+
+        // pairs of original terminals whose blocks can not be adjacent in
+        // the solution of this problem. copying a problem shares the pairs
+        // until they are changed
         void addFinishedPair(NodeID a, NodeID b, NodeID numOriginalTerminals) {
             if (a == b) {
                 LOG1 << "Error. Pair between " << a << " and itself!";
                 exit(1);
             }
-            NodeID min = std::min(a, b);
-            NodeID max = std::max(a, b);
-
-            NodeID combined = min * numOriginalTerminals + max;
-            finished_blockpairs.insert(combined);
+            finished_blockpairs.insert(a, b, numOriginalTerminals);
         }
 
-        void removeFinishedPair(NodeID a, NodeID b, NodeID numOriginalTerminals) {
+        void removeFinishedPair(NodeID a, NodeID b) {
             if (a == b) {
                 LOG1 << "Error. Pair between " << a << " and itself!";
                 exit(1);
             }
-            NodeID min = std::min(a, b);
-            NodeID max = std::max(a, b);
-
-            NodeID combined = min * numOriginalTerminals + max;
-            finished_blockpairs.extract(combined);
+            finished_blockpairs.erase(a, b);
         }
 
-        bool isPairFinished(NodeID a, NodeID b, NodeID numOriginalTerminals) {
+        bool isPairFinished(NodeID a, NodeID b) const {
             if (a == b) {
                 LOG1 << "Error. Searching pair between " << a << " and itself!";
                 exit(1);
             }
-            NodeID min = std::min(a, b);
-            NodeID max = std::max(a, b);
-
-            NodeID combined = min * numOriginalTerminals + max;
-            return (finished_blockpairs.count(combined) > 0);
+            return finished_blockpairs.contains(a, b);
         }
 
         static void writeGraph(problemPointer problem,
@@ -200,6 +226,8 @@ namespace VieCut {
         FlowType                                            upper_bound;
         EdgeWeight                                          deleted_weight;
         std::pair<NodeID, EdgeID>                           priority_edge;
-        std::unordered_set<NodeID>                          finished_blockpairs;
+        pair_bitset                                         finished_blockpairs;
+        NodeID branch_vertex = UNDEFINED_NODE;
+        NodeID branch_terminal = UNDEFINED_NODE;
     };
 }
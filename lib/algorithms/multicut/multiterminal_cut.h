@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "algorithms/misc/strongly_connected_components.h"
+#include "algorithms/flow/flow_statistics.h"
 #include "algorithms/multicut/branch_multicut.h"
 #include "data_structure/graph_access.h"
 #include "data_structure/mutable_graph.h"
@@ -32,7 +33,7 @@ namespace VieCut {
     class multiterminal_cut {
      public:
         static constexpr bool debug = false;
-        multiterminal_cut() { }
+        multiterminal_cut() : spilled_problems(0) { }
 
         std::vector<NodeID> setOriginalTerminals(mutableGraphPtr G) {
             auto config = configuration::getConfig();
@@ -103,6 +104,7 @@ namespace VieCut {
             std::vector<NodeID> globalSolution;
 
             FlowType flow_sum = 0;
+            flow_statistics flow_stats;
             for (size_t p = 0; p < problems.size(); ++p) {
                 auto& problem = problems[p];
                 if (debug) {
@@ -117,10 +119,13 @@ namespace VieCut {
                 configuration::getConfig()->orign = problems[p].graph->n();
                 configuration::getConfig()->origm = problems[p].graph->m();
 
-                branch_multicut bmc(originalGraphs[p], p_terminals, fixedVertex[p]);
+                branch_multicut bmc(originalGraphs[p], p_terminals,
+                                    fixedVertex[p], p);
                 auto p_pointer = std::make_shared<multicut_problem>(problem);
                 auto [sol, flow] = bmc.find_multiterminal_cut(p_pointer);
                 flow_sum += flow;
+                flow_stats.add(bmc.getFlowStatistics());
+                spilled_problems += bmc.spilledProblems();
 
                 if (cfg->write_solution || cfg->inexact) {
                     solutions.emplace_back(sol);
@@ -153,9 +158,16 @@ namespace VieCut {
                 LOG1 << "size: " << blocksize;
             }
 
+            LOGC(cfg->verbose) << "RESULT-FLOWSTATS " << flow_stats.toString();
             return flow_sum;
         }
 
+        // number of problems spilled to disk in all calls of multicut, see
+        // configuration::memory_budget
+        size_t spilledProblems() const {
+            return spilled_problems;
+        }
+
      private:
         static std::vector<NodeID> addSurroundingAreaToTerminals(
             mutableGraphPtr graph,
@@ -413,5 +425,7 @@ namespace VieCut {
 
             return terminalMapping;
         }
+
+        size_t spilled_problems;
     };
 }
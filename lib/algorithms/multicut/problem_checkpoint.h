@@ -0,0 +1,187 @@
+/******************************************************************************
+ * problem_checkpoint.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/definitions.h"
+#include "tlx/logger.hpp"
+#include "tools/varint.h"
+
+namespace VieCut {
+    // Checkpoint of the branch and reduce search of a single process: the
+    // open problems in the format of mpi_communication::encodeProblem and
+    // the best solution known to the process.
+    //
+    // Problems are moved between queues while they are solved and lazy
+    // problems change the graph they share with their siblings, so the
+    // queues are only read while no worker is inside a problem. Workers
+    // enclose their work in enter() and leave(), pause() waits until all of
+    // them left and holds back new ones until resume() is called.
+    class problem_checkpoint {
+     public:
+        struct checkpoint_data {
+            NodeID num_nodes = 0;
+            NodeID num_terminals = 0;
+            // cut value of solution, UNDEFINED_FLOW if there is none
+            FlowType upper_bound = UNDEFINED_FLOW;
+            std::vector<NodeID> solution;
+            std::vector<std::vector<uint8_t> > problems;
+        };
+
+        // enter() and leave() do nothing if the checkpoint is not active
+        explicit problem_checkpoint(bool active)
+            : active(active), busy(0), pausing(false) { }
+
+        void enter() {
+            if (!active)
+                return;
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return !pausing; });
+            ++busy;
+        }
+
+        void leave() {
+            if (!active)
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) {
+                cv.notify_all();
+            }
+        }
+
+        void pause() {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return !pausing; });
+            pausing = true;
+            cv.wait(lock, [this] { return busy == 0; });
+        }
+
+        void resume() {
+            std::lock_guard<std::mutex> lock(mutex);
+            pausing = false;
+            cv.notify_all();
+        }
+
+        // every process of every connected component writes its own file
+        static std::string fileName(const std::string& path,
+                                    size_t component, int rank) {
+            return path + "." + std::to_string(component)
+                   + "." + std::to_string(rank);
+        }
+
+        static std::vector<uint8_t> encode(const checkpoint_data& data) {
+            std::vector<uint8_t> out(MAGIC, MAGIC + sizeof(MAGIC));
+            varint::write(&out, data.num_nodes);
+            varint::write(&out, data.num_terminals);
+            varint::writeSigned(&out, data.upper_bound);
+            varint::write(&out, data.solution.size());
+            for (NodeID block : data.solution) {
+                varint::write(&out, block);
+            }
+            varint::write(&out, data.problems.size());
+            for (const auto& p : data.problems) {
+                varint::write(&out, p.size());
+                out.insert(out.end(), p.begin(), p.end());
+            }
+            return out;
+        }
+
+        // returns false if the data is malformed
+        static bool decode(const std::vector<uint8_t>& in,
+                           checkpoint_data* data) {
+            if (in.size() < sizeof(MAGIC)
+                || !std::equal(MAGIC, MAGIC + sizeof(MAGIC), in.begin()))
+                return false;
+
+            size_t pos = sizeof(MAGIC);
+            uint64_t n, k, sol_size, num_problems;
+            int64_t upper;
+            if (!varint::read(in, &pos, &n)
+                || !varint::read(in, &pos, &k)
+                || !varint::readSigned(in, &pos, &upper)
+                || !varint::read(in, &pos, &sol_size)
+                || sol_size > in.size())
+                return false;
+            data->num_nodes = n;
+            data->num_terminals = k;
+            data->upper_bound = upper;
+
+            data->solution.resize(sol_size);
+            for (size_t i = 0; i < sol_size; ++i) {
+                uint64_t block;
+                if (!varint::read(in, &pos, &block))
+                    return false;
+                data->solution[i] = block;
+            }
+
+            if (!varint::read(in, &pos, &num_problems)
+                || num_problems > in.size())
+                return false;
+            data->problems.resize(num_problems);
+            for (auto& p : data->problems) {
+                uint64_t size;
+                if (!varint::read(in, &pos, &size) || size > in.size() - pos)
+                    return false;
+                p.assign(in.begin() + pos, in.begin() + pos + size);
+                pos += size;
+            }
+            return pos == in.size();
+        }
+
+        // writes to a temporary file first and renames it afterwards, so a
+        // crash while writing never destroys the previous checkpoint
+        static bool write(const std::string& file,
+                          const checkpoint_data& data) {
+            std::string tmp = file + ".tmp";
+            std::vector<uint8_t> out = encode(data);
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            f.write(reinterpret_cast<const char*>(out.data()), out.size());
+            f.close();
+            if (!f) {
+                std::remove(tmp.c_str());
+                return false;
+            }
+            return std::rename(tmp.c_str(), file.c_str()) == 0;
+        }
+
+        // returns false if there is no such file. exits if it is malformed
+        static bool read(const std::string& file, checkpoint_data* data) {
+            std::ifstream f(file, std::ios::binary);
+            if (!f)
+                return false;
+            std::vector<uint8_t> in((std::istreambuf_iterator<char>(f)),
+                                    std::istreambuf_iterator<char>());
+            if (!decode(in, data)) {
+                LOG1 << "ERROR: checkpoint " << file << " is malformed";
+                exit(1);
+            }
+            return true;
+        }
+
+     private:
+        static constexpr uint8_t MAGIC[4] = { 'V', 'C', 'K', '1' };
+
+        bool active;
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t busy;
+        bool pausing;
+    };
+}
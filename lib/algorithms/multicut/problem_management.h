@@ -10,20 +10,29 @@
  *****************************************************************************/
 #pragma once
 
+#include <unistd.h>
+
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <limits>
 #include <memory>
 #include <optional>
+#include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "algorithms/multicut/maximum_flow.h"
 #include "algorithms/multicut/measurements.h"
 #include "algorithms/multicut/multicut_problem.h"
 #include "algorithms/multicut/problem_queues/per_thread_problem_queue.h"
 #include "algorithms/multicut/problem_queues/single_problem_queue.h"
+#include "algorithms/multicut/problem_queues/spilling_problem_queue.h"
+#include "algorithms/multicut/problem_queues/work_stealing_problem_queue.h"
 #include "common/configuration.h"
 #include "data_structure/mutable_graph.h"
+#include "tools/timer.h"
 
 using namespace std::chrono_literals;
 
@@ -40,7 +49,7 @@ namespace VieCut {
         const std::vector<NodeID>& original_terminals;
         const mutable_graph& original_graph;
         const std::vector<bool>& fixed_vertex;
-        per_thread_problem_queue problems;
+        std::unique_ptr<problem_queue> problems;
         maximum_flow mf;
         std::mutex bestsol_mutex;
         size_t num_threads;
@@ -48,6 +57,8 @@ namespace VieCut {
         std::vector<std::condition_variable> q_cv;
         bool is_finished;
         std::atomic<uint> idle_threads;
+        // time each thread spent waiting for a problem
+        std::vector<double> idle_time;
 
         FlowType global_upper_bound;
         std::vector<FlowType> terminalGUB;
@@ -67,14 +78,15 @@ namespace VieCut {
             : original_terminals(original_terminals),
               original_graph(original_graph),
               fixed_vertex(fixed_vertex),
-              problems(configuration::getConfig()->threads,
-                       configuration::getConfig()->queue_type),
+              problems(createQueue(configuration::getConfig()->threads,
+                                   configuration::getConfig()->queue_type)),
               mf(original_terminals),
               num_threads(configuration::getConfig()->threads),
               q_mutex(configuration::getConfig()->threads),
               q_cv(configuration::getConfig()->threads),
               is_finished(false),
               idle_threads(0),
+              idle_time(configuration::getConfig()->threads, 0),
               global_upper_bound(UNDEFINED_FLOW),
               terminalGUB(original_terminals.size() + 1, UNDEFINED_FLOW),
               beforeLSGUB(original_terminals.size() + 1, UNDEFINED_FLOW),
@@ -121,7 +133,7 @@ namespace VieCut {
 
         std::optional<problemPointer> pullProblem(
             size_t thread_id, bool send) {
-            return problems.pullProblem(thread_id, send);
+            return problems->pullProblem(thread_id, send);
         }
 
         void branch(problemPointer problem, size_t thread_id,
@@ -143,66 +155,30 @@ namespace VieCut {
             return ret;
         }
 
+        // creates a child problem for each terminal the branching vertex can
+        // be contracted into. children share the graph of the problem and
+        // are put into the queue without copying it. their branch is applied
+        // when they are pulled from the queue (see processBranch), so only
+        // children that are not pruned before are ever copied. the problem
+        // itself is consumed, as its graph now belongs to the children.
         void multiBranch(problemPointer problem,
                          size_t thread_id, mpi_communication* mpic) {
             auto [vertex, terminal_ids] = findEdgeMultiBranch(problem);
-            std::unordered_set<NodeID> terminals;
-            for (const auto& t : problem->terminals) {
-                terminals.emplace(t.position);
-            }
+            NodeID coarse_vtx = problem->graph->containedVertices(vertex)[0];
 
             for (size_t i = 0; i < terminal_ids.size(); ++i) {
-                NodeID ctr_terminal = terminal_ids[i];
-                problemPointer new_p;
-                if (i < terminal_ids.size() - 1) {
-                    new_p = std::make_shared<multicut_problem>();
-                    new_p->graph = std::make_shared<mutable_graph>(*problem->graph);
-                    new_p->terminals = problem->terminals;
-                    new_p->mappings = problem->mappings;
-                    new_p->priority_edge = { UNDEFINED_NODE, UNDEFINED_EDGE };
-                    new_p->lower_bound = problem->lower_bound;
-                    new_p->upper_bound = problem->upper_bound;
-                    new_p->deleted_weight = problem->deleted_weight;
-                    new_p->finished_blockpairs = problem->finished_blockpairs;
-                } else {
-                    new_p = problem;
-                }
-
-                for (size_t j = 0; j < new_p->terminals.size(); ++j) {
-                    new_p->terminals[j].invalid_flow = true;
-                }
-                NodeID coarse_vtx = new_p->graph->containedVertices(vertex)[0];
-                bool finished = false;
-                // first delete edges to terminals not picked
-                while (!finished) {
-                    finished = true;
-                    vertex = new_p->graph->getCurrentPosition(coarse_vtx);
-                    for (size_t e = 0; e <
-                         new_p->graph->get_first_invalid_edge(vertex); ++e) {
-                        auto [tgt, wgt] = new_p->graph->getEdge(vertex, e);
-                        if (terminals.count(tgt) > 0 && tgt != ctr_terminal) {
-                            new_p->graph->deleteEdge(vertex, e);
-                            new_p->deleted_weight += wgt;
-                            auto p = new_p->graph->getCurrentPosition(coarse_vtx);
-                            if (p != vertex) {
-                                vertex = p;
-                                finished = false;
-                                break;
-                            }
-                            --e;
-                        }
-                    }
-                }
-
-                for (EdgeID e : new_p->graph->edges_of(vertex)) {
-                    NodeID tgt = new_p->graph->getEdgeTarget(vertex, e);
-                    if (tgt == ctr_terminal) {
-                        new_p->graph->contractEdge(vertex, e);
-                        break;
-                    }
-                }
+                problemPointer new_p = std::make_shared<multicut_problem>();
+                new_p->graph = problem->graph;
+                new_p->terminals = problem->terminals;
+                new_p->mappings = problem->mappings;
+                new_p->priority_edge = { UNDEFINED_NODE, UNDEFINED_EDGE };
+                new_p->lower_bound = problem->lower_bound;
+                new_p->upper_bound = problem->upper_bound;
+                new_p->deleted_weight = problem->deleted_weight;
+                new_p->finished_blockpairs = problem->finished_blockpairs;
+                new_p->branch_vertex = coarse_vtx;
+                new_p->branch_terminal = terminal_ids[i];
 
-                graph_contraction::deleteTermEdges(new_p, original_terminals);
                 std::optional<int> sending = std::nullopt;
                 if (i < terminal_ids.size() - 1 && mpi_size > 1 && thread_id == 0) {
                     sending = mpic->checkForReceiver();
@@ -210,9 +186,77 @@ namespace VieCut {
                 if (sending.has_value()) {
                     mpic->sendProblem(new_p, sending.value());
                 } else {
-                    processNewProblem(new_p, thread_id);
+                    size_t thr = problems->addProblem(new_p, thread_id, true);
+                    q_cv[thr].notify_all();
+                }
+            }
+            problem->graph = nullptr;
+        }
+
+        // applies the branch of a lazy problem and computes its flows and
+        // bounds. afterwards it is in the queue again, if it is not pruned
+        void processBranch(problemPointer problem, size_t thread_id) {
+            applyBranch(problem);
+            processNewProblem(problem, thread_id);
+        }
+
+        // applies the branch of a lazy problem to its graph. the graph is
+        // shared with the siblings of the problem and only copied if one of
+        // them still uses it, the last sibling takes the graph over
+        void applyBranch(problemPointer new_p) {
+            if (!new_p->isLazy())
+                return;
+
+            if (new_p->graph.use_count() > 1) {
+                new_p->graph = std::make_shared<mutable_graph>(*new_p->graph);
+            } else {
+                // siblings might have copied the graph on other threads,
+                // the copies have to be done before it is changed here
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+
+            std::unordered_set<NodeID> terminals;
+            for (auto& t : new_p->terminals) {
+                terminals.emplace(t.position);
+                t.invalid_flow = true;
+            }
+
+            NodeID ctr_terminal = new_p->branch_terminal;
+            NodeID coarse_vtx = new_p->branch_vertex;
+            new_p->branch_vertex = UNDEFINED_NODE;
+            new_p->branch_terminal = UNDEFINED_NODE;
+            NodeID vertex = new_p->graph->getCurrentPosition(coarse_vtx);
+            bool finished = false;
+            // first delete edges to terminals not picked
+            while (!finished) {
+                finished = true;
+                vertex = new_p->graph->getCurrentPosition(coarse_vtx);
+                for (size_t e = 0; e <
+                     new_p->graph->get_first_invalid_edge(vertex); ++e) {
+                    auto [tgt, wgt] = new_p->graph->getEdge(vertex, e);
+                    if (terminals.count(tgt) > 0 && tgt != ctr_terminal) {
+                        new_p->graph->deleteEdge(vertex, e);
+                        new_p->deleted_weight += wgt;
+                        auto p = new_p->graph->getCurrentPosition(coarse_vtx);
+                        if (p != vertex) {
+                            vertex = p;
+                            finished = false;
+                            break;
+                        }
+                        --e;
+                    }
+                }
+            }
+
+            for (EdgeID e : new_p->graph->edges_of(vertex)) {
+                NodeID tgt = new_p->graph->getEdgeTarget(vertex, e);
+                if (tgt == ctr_terminal) {
+                    new_p->graph->contractEdge(vertex, e);
+                    break;
                 }
             }
+
+            graph_contraction::deleteTermEdges(new_p, original_terminals);
         }
 
         std::optional<FlowType> processNewProblem(
@@ -232,7 +276,7 @@ namespace VieCut {
                 return std::nullopt;
             }
 
-            mf.maximumIsolatingFlow(new_p, thread_id, problems.size() == 0);
+            mf.maximumIsolatingFlow(new_p, problems->size() == 0);
             graph_contraction::deleteTermEdges(new_p, original_terminals);
             if (new_p->graph->m() == 0) {
                 new_p->upper_bound = new_p->deleted_weight;
@@ -251,7 +295,7 @@ namespace VieCut {
                     runLS = true;
                 }
 
-                size_t thr = problems.addProblem(new_p, thread_id,
+                size_t thr = problems->addProblem(new_p, thread_id,
                                                  runLocalSearch(new_p));
                 q_cv[thr].notify_all();
                 if (runLS) {
@@ -269,15 +313,19 @@ namespace VieCut {
             if (prev_gub > beforeLSGUB[numTerminals])
                 return std::nullopt;
 
+            // bounds are checked again while holding the lock, as another
+            // thread might have found a better solution in the meantime
             if (prev_gub < global_upper_bound) {
-                global_upper_bound = prev_gub;
-                LOG1 << "Improvement after " << t.elapsed()
-                     << " to " << prev_gub << " (beforehand)";
                 bestsol_mutex.lock();
-                for (size_t i = 0; i < current_solution->size(); ++i) {
-                    best_solution[i] = (*current_solution)[i];
+                if (prev_gub < global_upper_bound) {
+                    global_upper_bound = prev_gub;
+                    LOG1 << "Improvement after " << t.elapsed()
+                         << " to " << prev_gub << " (beforehand)";
+                    for (size_t i = 0; i < current_solution->size(); ++i) {
+                        best_solution[i] = (*current_solution)[i];
+                    }
+                    initalizeBestSolution();
                 }
-                initalizeBestSolution();
                 bestsol_mutex.unlock();
             }
             FlowType total_improvement = ls.improveSolution(t);
@@ -288,17 +336,27 @@ namespace VieCut {
                 beforeLSGUB[numTerminals] = prev_gub;
             }
 
+            // the first solution is kept even if it is worse than the bound
+            // received from another process, so that there is a solution to
+            // return. the bound itself is never raised
             if (ls_bound < global_upper_bound || !bestSolutionInitialized) {
-                global_upper_bound = ls_bound;
-                LOG1 << "Improvement after " << t.elapsed() << " to " << ls_bound;
-
                 bestsol_mutex.lock();
-                for (size_t i = 0; i < current_solution->size(); ++i) {
-                    best_solution[i] = (*current_solution)[i];
+                bool improved = (ls_bound < global_upper_bound);
+                if (improved || !bestSolutionInitialized) {
+                    if (improved) {
+                        global_upper_bound = ls_bound;
+                        LOG1 << "Improvement after " << t.elapsed()
+                             << " to " << ls_bound;
+                    }
+                    for (size_t i = 0; i < current_solution->size(); ++i) {
+                        best_solution[i] = (*current_solution)[i];
+                    }
+                    initalizeBestSolution();
                 }
-                initalizeBestSolution();
                 bestsol_mutex.unlock();
-                return ls_bound;
+                if (improved) {
+                    return ls_bound;
+                }
             }
             return std::nullopt;
         }
@@ -354,28 +412,43 @@ namespace VieCut {
         }
 
         bool allEmpty() {
-            return problems.all_empty();
+            return problems->all_empty();
         }
 
         bool queueEmpty(size_t thread_id) {
-            return problems.empty(thread_id);
+            return problems->empty(thread_id);
         }
 
         bool haveASendProblem() {
-            return problems.haveASendProblem();
+            return problems->haveASendProblem();
         }
 
         size_t numProblems() {
-            return problems.size();
+            return problems->size();
+        }
+
+        // only correct while no thread works on the queue
+        std::vector<problemPointer> queuedProblems() {
+            return problems->allProblems();
+        }
+
+        // queued problems that are only stored in encoded form, as they
+        // were spilled to disk
+        std::vector<std::vector<uint8_t> > encodedProblems() {
+            return problems->encodedProblems();
+        }
+
+        size_t numSpilledProblems() {
+            return problems->numEncoded();
         }
 
         void prepareQueue(size_t thread_id) {
-            problems.prepareQueue(thread_id, global_upper_bound);
+            problems->prepareQueue(thread_id, global_upper_bound);
         }
 
         void addProblem(problemPointer p,
                         size_t thread_id, bool preferLocal) {
-            problems.addProblem(p, thread_id, preferLocal);
+            problems->addProblem(p, thread_id, preferLocal);
         }
 
         bool checkProblem(problemPointer problem) {
@@ -395,6 +468,10 @@ namespace VieCut {
             return global_upper_bound;
         }
 
+        flow_statistics getFlowStatistics() {
+            return mf.getFlowStatistics();
+        }
+
         void notifyThread(size_t thread_id) {
             q_cv[thread_id].notify_all();
         }
@@ -414,16 +491,26 @@ namespace VieCut {
         }
 
         bool leaveWaitState(size_t thread_id) {
-            return !queueEmpty(thread_id) || is_finished || (allThreadsIdle());
+            return !queueEmpty(thread_id) || haveASendProblem()
+                   || is_finished || (allThreadsIdle());
         }
 
         void waitForProblem(size_t thread_id) {
+            timer wait_timer;
             std::unique_lock<std::mutex> lck(q_mutex[thread_id]);
             q_cv[thread_id].wait_for(
                 lck, 1000ms,
                 [this, thread_id] {
                     return leaveWaitState(thread_id);
                 });
+            idle_time[thread_id] += wait_timer.elapsed();
+        }
+
+        void printSchedulerStatistics() {
+            for (size_t i = 0; i < num_threads; ++i) {
+                LOG1 << "thread " << i << " idle_time=" << idle_time[i];
+            }
+            problems->printStatistics();
         }
 
         bool allThreadsIdle() {
@@ -445,5 +532,34 @@ namespace VieCut {
         void setFinish() {
             is_finished = true;
         }
+
+     private:
+        // queue_type work_stealing[_<order>] selects the work stealing
+        // queue, any other value is the order of per_thread_problem_queue.
+        // problems beyond memory_budget are spilled to disk
+        static std::unique_ptr<problem_queue> createQueue(
+            size_t threads, const std::string& queue_type) {
+            std::unique_ptr<problem_queue> queue;
+            const std::string ws = "work_stealing";
+            if (queue_type.compare(0, ws.size(), ws) == 0) {
+                std::string order = "bound_sum";
+                if (queue_type.size() > ws.size() + 1) {
+                    order = queue_type.substr(ws.size() + 1);
+                }
+                queue = std::make_unique<work_stealing_problem_queue>(
+                    threads, order);
+            } else {
+                queue = std::make_unique<per_thread_problem_queue>(
+                    threads, queue_type);
+            }
+
+            auto c = configuration::getConfig();
+            size_t budget = c->memory_budget * 1024 * 1024;
+            if (budget == 0) {
+                budget = sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE) / 2;
+            }
+            return std::make_unique<spilling_problem_queue>(
+                std::move(queue), budget, c->scratch_directory);
+        }
     };
 }
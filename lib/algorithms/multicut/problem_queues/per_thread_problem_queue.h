@@ -19,74 +19,37 @@
 #include <optional>
 #include <queue>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "algorithms/multicut/multicut_problem.h"
+#include "algorithms/multicut/problem_queues/problem_queue.h"
 #include "common/configuration.h"
 
 namespace VieCut {
-    class per_thread_problem_queue {
+    class per_thread_problem_queue : public problem_queue {
      public:
         per_thread_problem_queue(size_t threads, std::string pq_type)
             : num_threads(threads),
+              order(problemOrder(pq_type)),
               haveSendProblem(false),
               sendProblemWeight(UNDEFINED_FLOW),
               pop_mutex(threads),
               sizes(threads) {
             for (size_t i = 0; i < num_threads; ++i) {
                 sizes[i].second = false;
-
-                if (pq_type == "small_graph") {
-                    pq.emplace_back(small_graph);
-                    continue;
-                }
-
-                if (pq_type == "bound_sum") {
-                    pq.emplace_back(bound_sum);
-                    continue;
-                }
-
-                if (pq_type == "few_terminals") {
-                    pq.emplace_back(few_terminals);
-                    continue;
-                }
-
-                if (pq_type == "upper_bound") {
-                    pq.emplace_back(upper_bound);
-                    continue;
-                }
-
-                if (pq_type == "lower_bound") {
-                    pq.emplace_back(lower_bound);
-                    continue;
-                }
-
-                if (pq_type == "bigger_distance") {
-                    pq.emplace_back(bigger_distance);
-                    continue;
-                }
-
-                if (pq_type == "lower_distance") {
-                    pq.emplace_back(lower_distance);
-                    continue;
-                }
-
-                if (pq_type == "most_deleted") {
-                    pq.emplace_back(most_deleted);
-                    continue;
-                }
-
-                pq.emplace_back(lower_bound);
+                pq.emplace_back(order);
             }
         }
-        ~per_thread_problem_queue() { }
+        virtual ~per_thread_problem_queue() { }
 
         void prepareQueue(size_t local_id, FlowType global_upper_bound) {
             pop_mutex[local_id].lock();
             while (pq[local_id].size() > 0) {
                 problemPointer current_problem = pq[local_id].top();
                 if (current_problem->lower_bound >= global_upper_bound) {
+                    removed(current_problem);
                     pq[local_id].pop();
                     sizes[local_id].first -= 1;
                     sizes[local_id].second = true;
@@ -131,10 +94,12 @@ namespace VieCut {
                 exit(1);
             }
 
+            removed(currentProblem);
             return currentProblem;
         }
 
         size_t addProblem(problemPointer p, size_t local_id, bool preferLocal) {
+            added(p);
             if (sizes[local_id].second) {
                 sizes[local_id].second = false;
             }
@@ -220,73 +185,96 @@ namespace VieCut {
             return haveSendProblem;
         }
 
-        size_t subqueue_size(size_t i) {
-            return sizes[i].first;
+        std::vector<problemPointer> allProblems() {
+            std::vector<problemPointer> all;
+            for (size_t i = 0; i < num_threads; ++i) {
+                auto copy = pq[i];
+                while (!copy.empty()) {
+                    all.emplace_back(copy.top());
+                    copy.pop();
+                }
+            }
+            if (haveSendProblem) {
+                all.emplace_back(sendProblem);
+            }
+            return all;
         }
 
-     private:
-        constexpr static auto small_graph =
-            [](const problemPointer& p1, const problemPointer& p2) {
-                return p1->graph->n() > p2->graph->n();
-            };
-
-        constexpr static auto bound_sum =
-            [](const problemPointer& p1, const problemPointer& p2) {
-                return (p1->upper_bound + p1->lower_bound)
-                       > (p2->upper_bound + p2->lower_bound);
-            };
-
-        constexpr static auto lower_bound =
-            [](const problemPointer& p1, const problemPointer& p2) {
-                if (p1->lower_bound == p2->lower_bound) {
-                    return p1->upper_bound > p2->upper_bound;
-                } else {
-                    return p1->lower_bound > p2->lower_bound;
-                }
-            };
+        // the worst problems of all threads. lazy problems only free their
+        // graph together with all of their siblings, so the problems that
+        // own their graph are released first
+        std::vector<problemPointer> releaseProblems(size_t, size_t bytes) {
+            for (auto& m : pop_mutex) {
+                m.lock();
+            }
 
-        constexpr static auto few_terminals =
-            [](const problemPointer& p1, const problemPointer& p2) {
-                if (p1->terminals.size() == p2->terminals.size()) {
-                    return lower_bound(p1, p2);
-                } else {
-                    return p1->terminals.size() > p2->terminals.size();
-                }
-            };
+            std::vector<problemPointer> all;
+            for (auto& q : pq) {
+                all.insert(all.end(), q.heap().begin(), q.heap().end());
+            }
+            // worst problem first
+            std::sort(all.begin(), all.end(), order);
+            std::stable_partition(all.begin(), all.end(),
+                                  [](const problemPointer& p) {
+                                      return !p->isLazy();
+                                  });
+
+            std::vector<problemPointer> released;
+            std::unordered_set<multicut_problem*> is_released;
+            size_t freed = 0;
+            for (size_t i = 0; i < all.size() && freed < bytes; ++i) {
+                freed += removed(all[i]);
+                released.emplace_back(all[i]);
+                is_released.insert(all[i].get());
+            }
 
-        constexpr static auto upper_bound =
-            [](const problemPointer& p1, const problemPointer& p2) {
-                if (p1->upper_bound == p2->upper_bound) {
-                    return p1->lower_bound > p2->lower_bound;
-                } else {
-                    return p1->upper_bound > p2->upper_bound;
-                }
-            };
+            for (size_t i = 0; i < num_threads; ++i) {
+                auto& heap = pq[i].heap();
+                size_t before = heap.size();
+                heap.erase(std::remove_if(heap.begin(), heap.end(),
+                                          [&is_released](const auto& p) {
+                                              return is_released.count(
+                                                  p.get()) > 0;
+                                          }),
+                           heap.end());
+                sizes[i].first -= before - heap.size();
+                pq[i].rebuild();
+            }
 
-        constexpr static auto bigger_distance =
-            [](const problemPointer& p1, const problemPointer& p2) {
-                return (p1->upper_bound - p1->lower_bound)
-                       < (p2->upper_bound - p2->lower_bound);
-            };
+            for (auto& m : pop_mutex) {
+                m.unlock();
+            }
+            return released;
+        }
 
-        constexpr static auto lower_distance =
-            [](const problemPointer& p1, const problemPointer& p2) {
-                return (p1->upper_bound - p1->lower_bound)
-                       > (p2->upper_bound - p2->lower_bound);
-            };
+        size_t subqueue_size(size_t i) {
+            return sizes[i].first;
+        }
 
-        constexpr static auto most_deleted =
-            [](const problemPointer& p1, const problemPointer& p2) {
-                return p1->deleted_weight < p2->deleted_weight;
-            };
+     private:
+        // priority queue that gives access to its heap, so that the problems
+        // with the lowest priority can be removed
+        class problem_heap : public std::priority_queue<
+                problemPointer, std::vector<problemPointer>, problem_order> {
+         public:
+            explicit problem_heap(problem_order order)
+                : std::priority_queue<problemPointer,
+                                      std::vector<problemPointer>,
+                                      problem_order>(order) { }
+
+            std::vector<problemPointer>& heap() {
+                return c;
+            }
+
+            void rebuild() {
+                std::make_heap(c.begin(), c.end(), comp);
+            }
+        };
 
         size_t num_threads;
+        problem_order order;
 
-        std::vector<std::priority_queue<problemPointer,
-                                        std::vector<problemPointer>,
-                                        std::function<
-                                            bool(const problemPointer&,
-                                                 const problemPointer&)> > > pq;
+        std::vector<problem_heap> pq;
 
         problemPointer sendProblem;
         bool haveSendProblem;
@@ -0,0 +1,209 @@
+/******************************************************************************
+ * problem_queue.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "algorithms/multicut/multicut_problem.h"
+
+namespace VieCut {
+    // returns true if p1 should be solved after p2
+    typedef std::function<bool(const problemPointer&, const problemPointer&)>
+        problem_order;
+
+    // Queue of open multicut subproblems shared by all threads of a process.
+    // Implemented by per_thread_problem_queue and work_stealing_problem_queue
+    class problem_queue {
+     public:
+        problem_queue() : queued_bytes(0) { }
+        virtual ~problem_queue() { }
+
+        // remove problems that can not improve on global_upper_bound
+        virtual void prepareQueue(size_t local_id,
+                                  FlowType global_upper_bound) = 0;
+        // a problem for thread local_id, or for sending it to another
+        // process if sending is true
+        virtual std::optional<problemPointer> pullProblem(size_t local_id,
+                                                          bool sending) = 0;
+        // returns the id of the thread that should be notified
+        virtual size_t addProblem(problemPointer p,
+                                  size_t local_id, bool preferLocal) = 0;
+        virtual bool empty(size_t i) = 0;
+        virtual bool all_empty() = 0;
+        virtual size_t size() = 0;
+        // whether there is a problem that any thread can take
+        virtual bool haveASendProblem() = 0;
+        // all queued problems that are held in memory. only correct if no
+        // thread accesses the queue at the same time
+        virtual std::vector<problemPointer> allProblems() = 0;
+        // queued problems that are only stored in the format of
+        // mpi_communication::encodeProblem, see spilling_problem_queue
+        virtual std::vector<std::vector<uint8_t> > encodedProblems() {
+            return { };
+        }
+        // number of problems that were ever stored encoded
+        virtual size_t numEncoded() {
+            return 0;
+        }
+        // removes problems of the lowest priority with an estimated memory
+        // of at least bytes, as far as there are enough. called by thread
+        // local_id
+        virtual std::vector<problemPointer> releaseProblems(size_t local_id,
+                                                            size_t bytes) = 0;
+        virtual void printStatistics() { }
+
+        // estimated memory of the queued problems. a graph that is shared by
+        // several lazy problems is counted once
+        virtual size_t bytes() {
+            return queued_bytes;
+        }
+
+        // estimated memory of a problem that does not share its graph. the
+        // graph of a problem does not change while it is queued, so the
+        // estimate is the same when it is added and removed
+        static size_t problemBytes(const problemPointer& p) {
+            size_t bytes = sizeof(multicut_problem)
+                           + p->terminals.size() * sizeof(terminal);
+            if (p->graph != nullptr) {
+                bytes += graphBytes(p->graph);
+            }
+            return bytes;
+        }
+
+        static size_t graphBytes(const mutableGraphPtr& G) {
+            return G->n() * (2 * sizeof(std::vector<NodeID>)
+                             + sizeof(PartitionID) + sizeof(EdgeWeight))
+                   + G->m() * sizeof(RevEdge)
+                   + 2 * G->getOriginalNodes() * sizeof(NodeID);
+        }
+
+        // order given by option queue_type, lower_bound if it is unknown
+        static problem_order problemOrder(const std::string& pq_type) {
+            if (pq_type == "small_graph")
+                return small_graph;
+            if (pq_type == "bound_sum")
+                return bound_sum;
+            if (pq_type == "few_terminals")
+                return few_terminals;
+            if (pq_type == "upper_bound")
+                return upper_bound;
+            if (pq_type == "lower_bound")
+                return lower_bound;
+            if (pq_type == "bigger_distance")
+                return bigger_distance;
+            if (pq_type == "lower_distance")
+                return lower_distance;
+            if (pq_type == "most_deleted")
+                return most_deleted;
+            return lower_bound;
+        }
+
+     protected:
+        // both return the change of bytes(). the graph of lazy problems is
+        // only counted for the first sibling that is added and freed with
+        // the last one that is removed
+        size_t added(const problemPointer& p) {
+            size_t bytes = problemBytes(p);
+            if (p->isLazy() && p->graph != nullptr) {
+                std::lock_guard<std::mutex> lock(shared_mutex);
+                if (shared_graphs[p->graph.get()]++ > 0) {
+                    bytes -= graphBytes(p->graph);
+                }
+            }
+            queued_bytes += bytes;
+            return bytes;
+        }
+
+        size_t removed(const problemPointer& p) {
+            size_t bytes = problemBytes(p);
+            if (p->isLazy() && p->graph != nullptr) {
+                std::lock_guard<std::mutex> lock(shared_mutex);
+                auto it = shared_graphs.find(p->graph.get());
+                if (--it->second > 0) {
+                    bytes -= graphBytes(p->graph);
+                } else {
+                    shared_graphs.erase(it);
+                }
+            }
+            queued_bytes -= bytes;
+            return bytes;
+        }
+
+        std::atomic<size_t> queued_bytes;
+        // number of queued lazy problems that share a graph
+        std::mutex shared_mutex;
+        std::unordered_map<const mutable_graph*, size_t> shared_graphs;
+
+     private:
+        constexpr static auto small_graph =
+            [](const problemPointer& p1, const problemPointer& p2) {
+                return p1->graph->n() > p2->graph->n();
+            };
+
+        constexpr static auto bound_sum =
+            [](const problemPointer& p1, const problemPointer& p2) {
+                return (p1->upper_bound + p1->lower_bound)
+                       > (p2->upper_bound + p2->lower_bound);
+            };
+
+        constexpr static auto lower_bound =
+            [](const problemPointer& p1, const problemPointer& p2) {
+                if (p1->lower_bound == p2->lower_bound) {
+                    return p1->upper_bound > p2->upper_bound;
+                } else {
+                    return p1->lower_bound > p2->lower_bound;
+                }
+            };
+
+        constexpr static auto few_terminals =
+            [](const problemPointer& p1, const problemPointer& p2) {
+                if (p1->terminals.size() == p2->terminals.size()) {
+                    return lower_bound(p1, p2);
+                } else {
+                    return p1->terminals.size() > p2->terminals.size();
+                }
+            };
+
+        constexpr static auto upper_bound =
+            [](const problemPointer& p1, const problemPointer& p2) {
+                if (p1->upper_bound == p2->upper_bound) {
+                    return p1->lower_bound > p2->lower_bound;
+                } else {
+                    return p1->upper_bound > p2->upper_bound;
+                }
+            };
+
+        constexpr static auto bigger_distance =
+            [](const problemPointer& p1, const problemPointer& p2) {
+                return (p1->upper_bound - p1->lower_bound)
+                       < (p2->upper_bound - p2->lower_bound);
+            };
+
+        constexpr static auto lower_distance =
+            [](const problemPointer& p1, const problemPointer& p2) {
+                return (p1->upper_bound - p1->lower_bound)
+                       > (p2->upper_bound - p2->lower_bound);
+            };
+
+        constexpr static auto most_deleted =
+            [](const problemPointer& p1, const problemPointer& p2) {
+                return p1->deleted_weight < p2->deleted_weight;
+            };
+    };
+}
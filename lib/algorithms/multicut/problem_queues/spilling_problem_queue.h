@@ -0,0 +1,409 @@
+/******************************************************************************
+ * spilling_problem_queue.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "algorithms/multicut/mpi_communication.h"
+#include "algorithms/multicut/multicut_problem.h"
+#include "algorithms/multicut/problem_queues/problem_queue.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/varint.h"
+
+namespace VieCut {
+    // Keeps the estimated memory of the problems in a queue below a budget.
+    // When an added problem exceeds the budget, the problems with the lowest
+    // priority are removed from the queue and written to a scratch file
+    // until a quarter of the budget is free again. When a thread finds no
+    // problem in the queue, the spilled problems are read again, the ones
+    // with the lowest lower bound first, until half of the budget is used.
+    // If less than half of the scratch file holds problems that are still
+    // spilled, they are moved to its front and the file is truncated.
+    //
+    // Problems are written in the format of mpi_communication::encodeProblem,
+    // checkpoints take them from the file without decoding them. Lazy
+    // problems that share a graph and are spilled together are written as a
+    // group that stores the graph once, see writeGroup. They share the graph
+    // again when they are reloaded.
+    class spilling_problem_queue : public problem_queue {
+     public:
+        spilling_problem_queue(std::unique_ptr<problem_queue> queue,
+                               size_t budget, std::string directory)
+            : queue(std::move(queue)),
+              budget(budget),
+              directory(directory),
+              fd(-1),
+              file_size(0),
+              spilled_bytes(0),
+              num_spilled(0) { }
+
+        virtual ~spilling_problem_queue() {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        // spilled problems that can not improve on global_upper_bound are
+        // removed without reading them
+        void prepareQueue(size_t local_id, FlowType global_upper_bound) {
+            queue->prepareQueue(local_id, global_upper_bound);
+            if (num_spilled > 0 && spill_mutex.try_lock()) {
+                auto first_pruned = spilled.lower_bound(global_upper_bound);
+                for (auto it = first_pruned; it != spilled.end(); ++it) {
+                    spilled_bytes -= it->second.size;
+                    num_spilled -= it->second.problems;
+                }
+                spilled.erase(first_pruned, spilled.end());
+                compactFile();
+                spill_mutex.unlock();
+            }
+        }
+
+        std::optional<problemPointer> pullProblem(size_t local_id,
+                                                  bool sending) {
+            auto p = queue->pullProblem(local_id, sending);
+            if (!p.has_value() && num_spilled > 0) {
+                reload(local_id);
+                p = queue->pullProblem(local_id, sending);
+            }
+            return p;
+        }
+
+        size_t addProblem(problemPointer p, size_t local_id, bool preferLocal) {
+            size_t notify = queue->addProblem(p, local_id, preferLocal);
+            if (queue->bytes() > budget) {
+                spill(local_id);
+            }
+            return notify;
+        }
+
+        bool empty(size_t i) {
+            return queue->empty(i) && num_spilled == 0;
+        }
+
+        bool all_empty() {
+            return queue->all_empty() && num_spilled == 0;
+        }
+
+        size_t size() {
+            return queue->size() + num_spilled;
+        }
+
+        // spilled problems are read by any thread that asks for one
+        bool haveASendProblem() {
+            return queue->haveASendProblem() || num_spilled > 0;
+        }
+
+        std::vector<problemPointer> allProblems() {
+            return queue->allProblems();
+        }
+
+        // the spilled problems as they are stored in the scratch file. the
+        // problems of a group are each joined with the graph of the group
+        std::vector<std::vector<uint8_t> > encodedProblems() {
+            std::lock_guard<std::mutex> lock(spill_mutex);
+            std::vector<std::vector<uint8_t> > encoded;
+            for (const auto& [lower_bound, location] : spilled) {
+                std::vector<uint8_t> data = readBytes(location);
+                if (location.problems == 1) {
+                    encoded.emplace_back(std::move(data));
+                    continue;
+                }
+                auto headers = splitGroup(data);
+                size_t graph_begin = headers.back().second;
+                for (size_t i = 0; i < location.problems; ++i) {
+                    auto [begin, end] = headers[i];
+                    std::vector<uint8_t> problem(data.begin() + begin,
+                                                 data.begin() + end);
+                    problem.insert(problem.end(), data.begin() + graph_begin,
+                                   data.end());
+                    encoded.emplace_back(std::move(problem));
+                }
+            }
+            return encoded;
+        }
+
+        size_t numEncoded() {
+            return problems_spilled;
+        }
+
+        std::vector<problemPointer> releaseProblems(size_t local_id,
+                                                    size_t bytes) {
+            return queue->releaseProblems(local_id, bytes);
+        }
+
+        size_t bytes() {
+            return queue->bytes();
+        }
+
+        void printStatistics() {
+            queue->printStatistics();
+            LOG1 << "spilled problems=" << problems_spilled
+                 << " bytes=" << bytes_spilled
+                 << " reloaded=" << problems_reloaded;
+        }
+
+     private:
+        // position of a problem or a group of problems in the scratch file
+        struct spill_location {
+            size_t offset;
+            size_t size;
+            size_t problems;
+        };
+
+        void spill(size_t local_id) {
+            // problems are spilled by a single thread at a time, the others
+            // continue as long as it is not done
+            if (!spill_mutex.try_lock())
+                return;
+
+            size_t target = budget - budget / 4;
+            size_t used = queue->bytes();
+            if (used > target) {
+                std::unordered_map<const mutable_graph*,
+                                   std::vector<problemPointer> > siblings;
+                for (auto p : queue->releaseProblems(local_id, used - target)) {
+                    if (p->isLazy()) {
+                        siblings[p->graph.get()].emplace_back(p);
+                    } else {
+                        writeProblem(p);
+                    }
+                }
+                for (const auto& [graph, group] : siblings) {
+                    if (group.size() == 1) {
+                        writeProblem(group[0]);
+                    } else {
+                        writeGroup(group);
+                    }
+                }
+            }
+            spill_mutex.unlock();
+        }
+
+        void reload(size_t local_id) {
+            std::lock_guard<std::mutex> lock(spill_mutex);
+            size_t loaded = 0;
+            while (!spilled.empty()
+                   && (loaded == 0 || queue->bytes() < budget / 2)) {
+                auto it = spilled.begin();
+                for (problemPointer p : readProblems(it->second)) {
+                    queue->addProblem(p, local_id, true);
+                    loaded++;
+                }
+                spilled_bytes -= it->second.size;
+                num_spilled -= it->second.problems;
+                spilled.erase(it);
+            }
+            problems_reloaded += loaded;
+            compactFile();
+        }
+
+        // the file is deleted right after it is created, so it is removed
+        // by the operating system when the process ends
+        void openFile() {
+            std::string path = directory + "/viecut_spill_XXXXXX";
+            fd = mkstemp(path.data());
+            if (fd < 0) {
+                LOG1 << "ERROR: could not create scratch file in "
+                     << directory;
+                exit(1);
+            }
+            unlink(path.c_str());
+        }
+
+        // moves the spilled problems to the front of the file if more than
+        // half of it is taken by problems that were reloaded or pruned.
+        // problems are moved in the order of their offsets, so no problem is
+        // overwritten before it is moved
+        void compactFile() {
+            if (fd < 0 || spilled_bytes * 2 >= file_size)
+                return;
+
+            std::vector<spill_location*> locations;
+            for (auto& [lower_bound, location] : spilled) {
+                locations.emplace_back(&location);
+            }
+            std::sort(locations.begin(), locations.end(),
+                      [](const spill_location* a, const spill_location* b) {
+                          return a->offset < b->offset;
+                      });
+
+            size_t end = 0;
+            for (spill_location* location : locations) {
+                if (location->offset != end) {
+                    writeBytes(readBytes(*location), end);
+                    location->offset = end;
+                }
+                end += location->size;
+            }
+
+            if (ftruncate(fd, end) != 0) {
+                LOG1 << "ERROR: could not truncate scratch file";
+                exit(1);
+            }
+            file_size = end;
+        }
+
+        void writeProblem(problemPointer p) {
+            writeRecord(mpi_communication::encodeProblem(p), p->lower_bound, 1);
+        }
+
+        // lazy problems with the same graph. stored as their number, the
+        // size and the header of each problem (mpi_communication::
+        // encodeHeader) and the graph they share
+        void writeGroup(const std::vector<problemPointer>& group) {
+            std::vector<uint8_t> data;
+            varint::write(&data, group.size());
+            FlowType lower_bound = group[0]->lower_bound;
+            for (const auto& p : group) {
+                std::vector<uint8_t> header;
+                mpi_communication::encodeHeader(p, &header);
+                varint::write(&data, header.size());
+                data.insert(data.end(), header.begin(), header.end());
+                lower_bound = std::min(lower_bound, p->lower_bound);
+            }
+            group[0]->graph->serializeCompact(&data);
+            writeRecord(data, lower_bound, group.size());
+        }
+
+        // a group is pruned and reloaded by the lowest bound of its problems
+        void writeRecord(const std::vector<uint8_t>& data,
+                         FlowType lower_bound, size_t problems) {
+            if (fd < 0) {
+                openFile();
+            }
+            writeBytes(data, file_size);
+            spilled.emplace(lower_bound, spill_location {
+                    file_size, data.size(), problems });
+            file_size += data.size();
+            spilled_bytes += data.size();
+            num_spilled += problems;
+            problems_spilled += problems;
+            bytes_spilled += data.size();
+        }
+
+        void writeBytes(const std::vector<uint8_t>& data, size_t offset) {
+            size_t written = 0;
+            while (written < data.size()) {
+                ssize_t w = pwrite(fd, data.data() + written,
+                                   data.size() - written, offset + written);
+                if (w <= 0) {
+                    LOG1 << "ERROR: could not write to scratch file";
+                    exit(1);
+                }
+                written += w;
+            }
+        }
+
+        std::vector<uint8_t> readBytes(const spill_location& location) {
+            std::vector<uint8_t> data(location.size);
+            size_t read = 0;
+            while (read < data.size()) {
+                ssize_t r = pread(fd, data.data() + read, data.size() - read,
+                                  location.offset + read);
+                if (r <= 0) {
+                    LOG1 << "ERROR: could not read from scratch file";
+                    exit(1);
+                }
+                read += r;
+            }
+            return data;
+        }
+
+        // the problems of a group share a single copy of its graph
+        std::vector<problemPointer> readProblems(
+            const spill_location& location) {
+            std::vector<uint8_t> data = readBytes(location);
+            if (location.problems == 1) {
+                auto p = mpi_communication::decodeProblem(data);
+                if (p == nullptr)
+                    malformed();
+                return { p };
+            }
+
+            auto headers = splitGroup(data);
+            size_t pos = headers.back().second;
+            mutableGraphPtr G = mutable_graph::deserializeCompact(data, &pos);
+            if (G == nullptr || pos != data.size())
+                malformed();
+
+            std::vector<problemPointer> problems;
+            for (auto [begin, end] : headers) {
+                size_t header_pos = begin;
+                auto p = mpi_communication::decodeHeader(data, &header_pos);
+                if (p == nullptr || header_pos != end)
+                    malformed();
+                p->graph = G;
+                if (!mpi_communication::validBranch(p))
+                    malformed();
+                problems.emplace_back(p);
+            }
+            return problems;
+        }
+
+        // begin and end of the headers in a group written by writeGroup
+        std::vector<std::pair<size_t, size_t> > splitGroup(
+            const std::vector<uint8_t>& data) {
+            size_t pos = 0;
+            uint64_t num_problems;
+            if (!varint::read(data, &pos, &num_problems)
+                || num_problems == 0 || num_problems > data.size())
+                malformed();
+            std::vector<std::pair<size_t, size_t> > headers;
+            for (size_t i = 0; i < num_problems; ++i) {
+                uint64_t size;
+                if (!varint::read(data, &pos, &size)
+                    || size > data.size() - pos)
+                    malformed();
+                headers.emplace_back(pos, pos + size);
+                pos += size;
+            }
+            return headers;
+        }
+
+        void malformed() {
+            LOG1 << "ERROR: scratch file contains malformed problem";
+            exit(1);
+        }
+
+        std::unique_ptr<problem_queue> queue;
+        size_t budget;
+        std::string directory;
+
+        std::mutex spill_mutex;
+        int fd;
+        size_t file_size;
+        // size of the problems in the file that are still spilled
+        size_t spilled_bytes;
+        // ordered by lower bound
+        std::multimap<FlowType, spill_location> spilled;
+        std::atomic<size_t> num_spilled;
+
+        size_t problems_spilled = 0;
+        size_t bytes_spilled = 0;
+        size_t problems_reloaded = 0;
+    };
+}
@@ -0,0 +1,313 @@
+/******************************************************************************
+ * work_stealing_problem_queue.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "algorithms/multicut/multicut_problem.h"
+#include "algorithms/multicut/problem_queues/problem_queue.h"
+#include "parallel/data_structure/work_stealing_deque.h"
+#include "tlx/logger.hpp"
+
+namespace VieCut {
+    // Problem queue without locks. Every thread keeps its best few problems
+    // in a small sorted array that only it accesses, ordered by the order
+    // given in queue_type. Problems that do not fit are pushed to the lock
+    // free deque of the thread, from which idle threads steal the oldest
+    // problem of a random victim. Thus, a thread mostly works depth-first
+    // on its own subtree and only touches shared memory if it runs out of
+    // work or produces more than it can store locally.
+    //
+    // Selected with queue_type work_stealing or work_stealing_<order>,
+    // e.g. work_stealing_lower_bound.
+    class work_stealing_problem_queue : public problem_queue {
+     public:
+        // number of problems a thread keeps for itself
+        static constexpr size_t LOCAL_CAPACITY = 4;
+        // maximum number of problems of its deque a thread checks when the
+        // upper bound improved
+        static constexpr size_t SWEEP_LIMIT = 256;
+
+        work_stealing_problem_queue(size_t threads, std::string pq_type)
+            : num_threads(threads),
+              order(problemOrder(pq_type)),
+              thread_data(threads),
+              num_problems(0),
+              num_stealable(0),
+              best_upper_bound(std::numeric_limits<FlowType>::max()) {
+            for (size_t i = 0; i < num_threads; ++i) {
+                thread_data[i].rng.seed(i);
+            }
+        }
+
+        virtual ~work_stealing_problem_queue() {
+            for (auto& td : thread_data) {
+                while (problemPointer* p = td.deque.take()) {
+                    delete p;
+                }
+            }
+        }
+
+        // prunes the problems that thread local_id stores locally. if the
+        // upper bound improved since the last call, the newest problems of
+        // its deque are also checked, older ones are checked when they are
+        // pulled
+        void prepareQueue(size_t local_id, FlowType global_upper_bound) {
+            auto& td = thread_data[local_id];
+            FlowType bound = best_upper_bound;
+            while (global_upper_bound < bound
+                   && !best_upper_bound.compare_exchange_weak(
+                       bound, global_upper_bound)) { }
+            if (global_upper_bound < td.swept_bound) {
+                td.swept_bound = global_upper_bound;
+                sweepDeque(&td, global_upper_bound);
+            }
+
+            auto& local = td.local;
+            size_t before = local.size();
+            local.erase(
+                std::remove_if(local.begin(), local.end(),
+                               [this, global_upper_bound](
+                                   const problemPointer& p) {
+                                   if (p->lower_bound < global_upper_bound)
+                                       return false;
+                                   removed(p);
+                                   return true;
+                               }),
+                local.end());
+            num_problems -= before - local.size();
+        }
+
+        // if sending, the oldest problem of a random thread is preferred, as
+        // it is usually the largest one and thus worth the communication
+        std::optional<problemPointer> pullProblem(size_t local_id,
+                                                  bool sending) {
+            std::optional<problemPointer> p;
+            if (sending) {
+                p = steal(local_id, true);
+                if (!p.has_value()) {
+                    p = takeLocal(local_id);
+                }
+            } else {
+                p = takeLocal(local_id);
+                if (!p.has_value()) {
+                    p = steal(local_id, false);
+                }
+            }
+            return p;
+        }
+
+        // problems are stored locally if preferLocal, the worst problem is
+        // pushed to the deque when the local array is full. in that case a
+        // random thread is returned to be notified, as it can steal now
+        size_t addProblem(problemPointer p, size_t local_id, bool preferLocal) {
+            auto& td = thread_data[local_id];
+            num_problems++;
+            added(p);
+            if (!preferLocal) {
+                pushPublic(&td, p);
+                return td.rng() % num_threads;
+            }
+
+            auto& local = td.local;
+            local.insert(std::upper_bound(local.begin(), local.end(), p, order),
+                         p);
+            size_t notify = local_id;
+            if (local.size() > LOCAL_CAPACITY) {
+                pushPublic(&td, local.front());
+                local.erase(local.begin());
+                notify = td.rng() % num_threads;
+            }
+            td.max_depth = std::max(td.max_depth,
+                                    local.size() + td.deque.size());
+            return notify;
+        }
+
+        bool empty(size_t i) {
+            return thread_data[i].local.empty() && thread_data[i].deque.empty();
+        }
+
+        bool all_empty() {
+            return num_problems == 0;
+        }
+
+        size_t size() {
+            return num_problems;
+        }
+
+        bool haveASendProblem() {
+            return num_stealable > 0;
+        }
+
+        // all problems that are not dominated by the best upper bound
+        // given to prepareQueue
+        std::vector<problemPointer> allProblems() {
+            std::vector<problemPointer> all;
+            FlowType bound = best_upper_bound;
+            for (const auto& td : thread_data) {
+                for (const problemPointer& p : td.local) {
+                    if (p->lower_bound < bound)
+                        all.emplace_back(p);
+                }
+                for (problemPointer* p : td.deque.items()) {
+                    if ((*p)->lower_bound < bound)
+                        all.emplace_back(*p);
+                }
+            }
+            return all;
+        }
+
+        // the newest problems in the deque of thread local_id. they were the
+        // worst local problems of the thread when they were pushed. problems
+        // that are dominated by the upper bound are dropped instead
+        std::vector<problemPointer> releaseProblems(size_t local_id,
+                                                    size_t bytes) {
+            auto& td = thread_data[local_id];
+            FlowType bound = best_upper_bound;
+            std::vector<problemPointer> released;
+            size_t freed = 0;
+            while (freed < bytes) {
+                problemPointer* p = td.deque.take();
+                if (p == nullptr)
+                    break;
+                problemPointer problem = unwrap(p, &freed);
+                if (problem->lower_bound < bound)
+                    released.emplace_back(problem);
+            }
+            return released;
+        }
+
+        void printStatistics() {
+            for (size_t i = 0; i < num_threads; ++i) {
+                const auto& td = thread_data[i];
+                LOG1 << "thread " << i << " local_pops=" << td.local_pops
+                     << " steals=" << td.steals
+                     << " failed_steals=" << td.failed_steals
+                     << " pushed_to_deque=" << td.pushed_public
+                     << " swept=" << td.swept
+                     << " max_depth=" << td.max_depth;
+            }
+        }
+
+     private:
+        // padded to avoid false sharing between threads
+        struct alignas(64) per_thread {
+            // sorted by order, best problem at the back
+            std::vector<problemPointer> local;
+            work_stealing_deque<problemPointer*> deque;
+            std::mt19937 rng;
+            size_t local_pops = 0;
+            size_t steals = 0;
+            size_t failed_steals = 0;
+            size_t pushed_public = 0;
+            size_t max_depth = 0;
+            size_t swept = 0;
+            // upper bound of the last sweep of the deque
+            FlowType swept_bound = std::numeric_limits<FlowType>::max();
+        };
+
+        // takes up to SWEEP_LIMIT of the newest problems from the own deque,
+        // drops the dominated ones and pushes the others back in their order
+        void sweepDeque(per_thread* td, FlowType global_upper_bound) {
+            std::vector<problemPointer*> keep;
+            for (size_t i = 0; i < SWEEP_LIMIT; ++i) {
+                problemPointer* p = td->deque.take();
+                if (p == nullptr)
+                    break;
+                if ((*p)->lower_bound >= global_upper_bound) {
+                    unwrap(p);
+                    td->swept++;
+                } else {
+                    keep.emplace_back(p);
+                }
+            }
+            for (auto it = keep.rbegin(); it != keep.rend(); ++it) {
+                td->deque.push(*it);
+            }
+        }
+
+        void pushPublic(per_thread* td, problemPointer p) {
+            td->deque.push(new problemPointer(p));
+            td->pushed_public++;
+            num_stealable++;
+        }
+
+        // from the local array, or the own deque if it is empty
+        std::optional<problemPointer> takeLocal(size_t local_id) {
+            auto& td = thread_data[local_id];
+            if (!td.local.empty()) {
+                problemPointer p = td.local.back();
+                td.local.pop_back();
+                td.local_pops++;
+                num_problems--;
+                removed(p);
+                return p;
+            }
+
+            problemPointer* p = td.deque.take();
+            if (p != nullptr) {
+                td.local_pops++;
+                return unwrap(p);
+            }
+            return std::nullopt;
+        }
+
+        // tries the deques of all threads once, starting at a random one
+        std::optional<problemPointer> steal(size_t local_id, bool include_own) {
+            auto& td = thread_data[local_id];
+            if (num_stealable == 0)
+                return std::nullopt;
+
+            size_t start = td.rng() % num_threads;
+            for (size_t i = 0; i < num_threads; ++i) {
+                size_t victim = (start + i) % num_threads;
+                if (victim == local_id && !include_own)
+                    continue;
+                problemPointer* p = thread_data[victim].deque.steal();
+                if (p != nullptr) {
+                    td.steals++;
+                    return unwrap(p);
+                }
+            }
+            td.failed_steals++;
+            return std::nullopt;
+        }
+
+        // adds the bytes that are freed by removing the problem to freed
+        problemPointer unwrap(problemPointer* p, size_t* freed = nullptr) {
+            problemPointer problem = *p;
+            delete p;
+            num_stealable--;
+            num_problems--;
+            size_t bytes = removed(problem);
+            if (freed != nullptr) {
+                *freed += bytes;
+            }
+            return problem;
+        }
+
+        size_t num_threads;
+        problem_order order;
+        std::vector<per_thread> thread_data;
+        std::atomic<size_t> num_problems;
+        std::atomic<size_t> num_stealable;
+        // best upper bound given to prepareQueue by any thread
+        std::atomic<FlowType> best_upper_bound;
+    };
+}
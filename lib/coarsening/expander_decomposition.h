@@ -0,0 +1,260 @@
+/******************************************************************************
+ * expander_decomposition.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "algorithms/flow/unit_flow.h"
+#include "common/configuration.h"
+#include "common/definitions.h"
+#include "data_structure/flow_graph.h"
+#include "tlx/logger.hpp"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
+
+namespace VieCut {
+    // Clustering of a graph into well connected clusters with a sparse
+    // boundary, which can be contracted instead of label propagation
+    // clusters. Like label propagation this is a heuristic, contracting a
+    // cluster loses all cuts that split it.
+    //
+    // Clusters are grown as BFS balls from random seeds until the weight of
+    // edges leaving the ball is at most phi times its volume, which happens
+    // after O(log(vol) / phi) layers. Each ball is then trimmed similar to
+    // Saranurak and Wang (SODA 2019): every vertex injects c = 1/(2 phi)
+    // units of flow per unit of boundary edge weight, edges have capacity c
+    // times their weight and vertex v absorbs up to its degree, so at most
+    // half of the volume is injected. The flow is routed inside the ball by
+    // unit_flow with height O(log(vol) / phi). Vertices
+    // that can not get rid of their excess are removed from the cluster
+    // and the flow is repeated on the remaining ball. If this does not
+    // converge after max_trim_rounds rounds, the ball is dissolved. Trimmed
+    // vertices get a second chance to join another ball, afterwards they
+    // stay single vertices.
+    template <class GraphPtr>
+    class expander_decomposition {
+     public:
+        static constexpr bool debug = false;
+        static constexpr size_t max_trim_rounds = 10;
+
+        expander_decomposition()
+            : phi(configuration::getConfig()->expander_phi),
+              num_clusters(0),
+              num_trimmed(0),
+              num_dissolved(0) { }
+
+        explicit expander_decomposition(double phi)
+            : phi(phi),
+              num_clusters(0),
+              num_trimmed(0),
+              num_dissolved(0) { }
+
+        ~expander_decomposition() { }
+
+        // returns the cluster id of every vertex, i.e. a vertex in the
+        // same cluster. vertices that are not in any cluster with other
+        // vertices are their own cluster
+        std::vector<NodeID> decompose(GraphPtr G) {
+            timer t;
+            NodeID n = G->number_of_nodes();
+            m_cluster.assign(n, UNDEFINED_NODE);
+            m_local.assign(n, UNDEFINED_NODE);
+            num_clusters = 0;
+            num_trimmed = 0;
+            num_dissolved = 0;
+
+            std::vector<NodeID> order(n);
+            random_functions::permutate_vector_good(&order, true);
+
+            m_was_trimmed.assign(n, false);
+            m_released.clear();
+
+            for (NodeID s : order) {
+                cluster(G, s);
+            }
+
+            // vertices trimmed from a ball are released once, so they can
+            // join the ball of their actual cluster
+            for (size_t i = 0; i < m_released.size(); ++i) {
+                cluster(G, m_released[i]);
+            }
+
+            LOG1 << "expander decomposition: n=" << n
+                 << " clusters=" << num_clusters
+                 << " trimmed=" << num_trimmed
+                 << " dissolved=" << num_dissolved
+                 << " t=" << t.elapsed();
+            return m_cluster;
+        }
+
+        // number of distinct ids in a clustering
+        static NodeID countClusters(const std::vector<NodeID>& cluster_id) {
+            std::vector<bool> seen(cluster_id.size(), false);
+            NodeID count = 0;
+            for (NodeID c : cluster_id) {
+                if (!seen[c]) {
+                    seen[c] = true;
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        // number of clusters with more than one vertex
+        size_t numClusters() const {
+            return num_clusters;
+        }
+
+        // number of vertices that were trimmed from a cluster
+        size_t numTrimmed() const {
+            return num_trimmed;
+        }
+
+        // number of balls that were dissolved as trimming did not converge
+        size_t numDissolved() const {
+            return num_dissolved;
+        }
+
+     private:
+        void cluster(GraphPtr G, NodeID s) {
+            if (m_cluster[s] != UNDEFINED_NODE)
+                return;
+            std::vector<NodeID> ball = growBall(G, s);
+            if (trim(G, &ball)) {
+                for (NodeID v : ball) {
+                    m_cluster[v] = ball[0];
+                }
+                if (ball.size() > 1) {
+                    num_clusters++;
+                }
+            } else {
+                num_dissolved++;
+                for (NodeID v : ball) {
+                    m_cluster[v] = v;
+                }
+            }
+        }
+
+        // grows a ball from s over vertices that are not clustered yet,
+        // until the boundary weight is at most phi times the volume
+        std::vector<NodeID> growBall(GraphPtr G, NodeID s) {
+            std::vector<NodeID> ball = { s };
+            m_cluster[s] = s;
+            EdgeWeight volume = G->getWeightedNodeDegree(s);
+            EdgeWeight boundary = volume;
+
+            size_t layer_start = 0;
+            while (boundary > phi * volume) {
+                size_t layer_end = ball.size();
+                for (size_t i = layer_start; i < layer_end; ++i) {
+                    NodeID v = ball[i];
+                    for (EdgeID e : G->edges_of(v)) {
+                        NodeID u = G->getEdgeTarget(v, e);
+                        if (m_cluster[u] != UNDEFINED_NODE)
+                            continue;
+                        m_cluster[u] = s;
+                        ball.emplace_back(u);
+                        EdgeWeight inside = 0;
+                        for (EdgeID f : G->edges_of(u)) {
+                            if (m_cluster[G->getEdgeTarget(u, f)] == s) {
+                                inside += G->getEdgeWeight(u, f);
+                            }
+                        }
+                        EdgeWeight deg = G->getWeightedNodeDegree(u);
+                        volume += deg;
+                        boundary = boundary + deg - 2 * inside;
+                    }
+                }
+
+                if (ball.size() == layer_end)
+                    break;
+                layer_start = layer_end;
+            }
+            return ball;
+        }
+
+        // removes vertices that can not route their share of the boundary
+        // from the ball. returns false if this did not converge
+        bool trim(GraphPtr G, std::vector<NodeID>* ball) {
+            FlowType congestion = std::max(1.0, std::floor(0.5 / phi));
+            for (size_t round = 0; round < max_trim_rounds; ++round) {
+                if (ball->size() <= 1)
+                    return true;
+
+                for (size_t i = 0; i < ball->size(); ++i) {
+                    m_local[(*ball)[i]] = i;
+                }
+
+                flow_graph fg;
+                fg.start_construction(ball->size());
+                std::vector<EdgeWeight> source(ball->size(), 0);
+                std::vector<FlowType> sink(ball->size(), 0);
+                EdgeWeight volume = 0;
+                for (size_t i = 0; i < ball->size(); ++i) {
+                    NodeID v = (*ball)[i];
+                    for (EdgeID e : G->edges_of(v)) {
+                        NodeID u = G->getEdgeTarget(v, e);
+                        EdgeWeight wgt = G->getEdgeWeight(v, e);
+                        if (m_local[u] == UNDEFINED_NODE) {
+                            source[i] += congestion * wgt;
+                        } else {
+                            fg.new_edge(i, m_local[u], congestion * wgt);
+                        }
+                    }
+                    sink[i] = G->getWeightedNodeDegree(v);
+                    volume += sink[i];
+                }
+                fg.finish_construction();
+
+                NodeID height = std::ceil(std::log2(volume + 1) / phi);
+                unit_flow uf;
+                uf.init(&fg, source, sink, congestion, height, 2);
+                uf.run();
+
+                std::vector<NodeID> kept;
+                for (size_t i = 0; i < ball->size(); ++i) {
+                    NodeID v = (*ball)[i];
+                    m_local[v] = UNDEFINED_NODE;
+                    if (uf.excess(i) > 0) {
+                        num_trimmed++;
+                        if (m_was_trimmed[v]) {
+                            m_cluster[v] = v;
+                        } else {
+                            m_was_trimmed[v] = true;
+                            m_cluster[v] = UNDEFINED_NODE;
+                            m_released.emplace_back(v);
+                        }
+                    } else {
+                        kept.emplace_back(v);
+                    }
+                }
+
+                bool converged = (kept.size() == ball->size());
+                *ball = kept;
+                if (converged)
+                    return true;
+            }
+            return ball->size() <= 1;
+        }
+
+        double phi;
+        size_t num_clusters;
+        size_t num_trimmed;
+        size_t num_dissolved;
+        std::vector<NodeID> m_cluster;
+        std::vector<NodeID> m_local;
+        std::vector<bool> m_was_trimmed;
+        std::vector<NodeID> m_released;
+    };
+}
@@ -58,11 +58,29 @@ namespace VieCut {
        double removeTerminalsBeforeBranch = 0.1;
        size_t contractionDepthAroundTerminal = 1;
        size_t maximumBranchingFactor = 5;
+       // compose vertex mappings of a subproblem into a single one if it
+       // has more contraction levels, 0 to never compose
+       size_t maxMappingDepth = 4;
        bool multibranch = true;
        bool inexact = false;
        bool runLocalSearch = true;
+       // fm, parallel_fm or gain
+       std::string local_search_algorithm = "fm";
        size_t timeoutSeconds = 600;
+       // checkpoint the open problems every checkpoint_interval seconds
+       // and at timeout to checkpoint_file.<component>.<rank>, continue
+       // from these files if resume is set
+       std::string checkpoint_file = "";
+       double checkpoint_interval = 600;
+       bool resume = false;
+       // memory of the open problems of a process in MB (0 = half of the
+       // main memory), problems beyond it are spilled to scratch_directory
+       size_t memory_budget = 0;
+       std::string scratch_directory = "/tmp";
        double ilpTime = 60.0;
+       // push_relabel, parallel_push_relabel, boykov_kolmogorov or auto
+       // (boykov_kolmogorov for problems with light terminals)
+       std::string flow_algorithm = "push_relabel";
        NodeID orign;
        EdgeID origm;
 
@@ -78,9 +96,16 @@ namespace VieCut {
        bool find_lowest_conductance = false;
        bool blacklist = true;
        bool set_node_in_cut = false;
+       // use expander decomposition with conductance parameter expander_phi
+       // when label propagation leaves more than expander_threshold * n
+       // clusters
+       bool expander_coarsening = false;
+       double expander_phi = 0.1;
+       double expander_threshold = 0.5;
 
        // cactus graph output
        std::string cactus_filename = "";
+       std::string cactus_binary_filename = "";
 
        // dynamic minimum cut
        size_t depthOfPartialRelabeling = 1;
@@ -62,4 +62,6 @@ namespace VieCut {
     typedef std::shared_ptr<mutable_graph> mutableGraphPtr;
     class graph_access;
     typedef std::shared_ptr<graph_access> graphAccessPtr;
+    class compact_cactus;
+    typedef std::shared_ptr<compact_cactus> compactCactusPtr;
 }
@@ -0,0 +1,412 @@
+/******************************************************************************
+ * compact_cactus.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "tlx/logger.hpp"
+
+namespace VieCut {
+    // Read-only representation of a cactus graph of all minimum cuts.
+    //
+    // Instead of a mutable_graph with a std::vector of contained vertices per
+    // cactus node, we store
+    //  - a flat array mapping each vertex of the original graph to its
+    //    cactus node (and its inverse as CSR, which is rebuilt on load),
+    //  - all tree edges (each one is a minimum cut) as two flat arrays,
+    //  - all cycles (each pair of edges in a cycle is a minimum cut) as CSR,
+    //    where every cycle is the sequence of cactus nodes along the cycle.
+    // Cycles of length 2 are equivalent to a tree edge and stored as such.
+    //
+    // The cactus can store a fingerprint of the graph it belongs to (number
+    // of edges, total edge weight and an order independent hash of the
+    // edges), so that a cactus loaded from disk is only used for that graph.
+    class compact_cactus {
+     public:
+        static constexpr bool debug = false;
+        static constexpr uint64_t binary_magic = 0x5355544341434356;  // VCCACTUS
+        static constexpr uint64_t binary_version = 2;
+
+        class vertex_range {
+         public:
+            vertex_range(const NodeID* begin, const NodeID* end)
+                : m_begin(begin), m_end(end) { }
+
+            const NodeID* begin() const { return m_begin; }
+            const NodeID* end() const { return m_end; }
+            size_t size() const { return m_end - m_begin; }
+
+         private:
+            const NodeID* m_begin;
+            const NodeID* m_end;
+        };
+
+        compact_cactus() : m_mincut(0),
+                           m_num_nodes(0),
+                           m_graph_edges(0),
+                           m_graph_weight(0),
+                           m_graph_hash(0) { }
+
+        ~compact_cactus() { }
+
+        static compactCactusPtr fromMutableGraph(mutableGraphPtr cactus,
+                                                 EdgeWeight mincut) {
+            compactCactusPtr C = std::make_shared<compact_cactus>();
+            C->m_mincut = mincut;
+            C->m_num_nodes = cactus->n();
+            C->m_vertex_to_node.resize(cactus->getOriginalNodes());
+            for (NodeID v = 0; v < cactus->getOriginalNodes(); ++v) {
+                C->m_vertex_to_node[v] = cactus->getCurrentPosition(v);
+            }
+            C->buildContainedVertices();
+            C->findTreeEdgesAndCycles(cactus);
+            return C;
+        }
+
+        // stores the fingerprint of the graph whose minimum cuts the cactus
+        // represents
+        template <class GraphPtr>
+        void setGraph(GraphPtr G) {
+            std::tie(m_graph_edges, m_graph_weight, m_graph_hash) =
+                fingerprint(G);
+        }
+
+        // whether G is the graph given in setGraph
+        template <class GraphPtr>
+        bool matchesGraph(GraphPtr G) const {
+            return G->number_of_nodes() == numVertices()
+                   && std::make_tuple(m_graph_edges, m_graph_weight,
+                                      m_graph_hash) == fingerprint(G);
+        }
+
+        mutableGraphPtr toMutableGraph() const {
+            mutableGraphPtr G = std::make_shared<mutable_graph>();
+            G->start_construction(m_num_nodes);
+            for (size_t i = 0; i < m_tree_source.size(); ++i) {
+                G->new_edge_order(m_tree_source[i], m_tree_target[i], m_mincut);
+            }
+
+            for (size_t c = 0; c < numCycles(); ++c) {
+                for (size_t i = m_cycle_start[c]; i < m_cycle_start[c + 1]; ++i) {
+                    NodeID next = (i + 1 == m_cycle_start[c + 1]) ?
+                                  m_cycle_nodes[m_cycle_start[c]] :
+                                  m_cycle_nodes[i + 1];
+                    G->new_edge_order(m_cycle_nodes[i], next, m_mincut / 2);
+                }
+            }
+
+            G->setOriginalNodes(numVertices());
+            for (NodeID n = 0; n < m_num_nodes; ++n) {
+                auto range = containedVertices(n);
+                G->setContainedVertices(
+                    n, std::vector<NodeID>(range.begin(), range.end()));
+            }
+            for (NodeID v = 0; v < numVertices(); ++v) {
+                G->setCurrentPosition(v, m_vertex_to_node[v]);
+            }
+            G->finish_construction();
+            return G;
+        }
+
+        bool writeBinary(const std::string& filename) const {
+            std::ofstream f(filename, std::ios::binary);
+            if (!f) {
+                LOG1 << "Error opening " << filename << " for writing";
+                return false;
+            }
+
+            writeValue(&f, binary_magic);
+            writeValue(&f, binary_version);
+            writeValue(&f, static_cast<uint64_t>(m_mincut));
+            writeValue(&f, static_cast<uint64_t>(m_num_nodes));
+            writeValue(&f, m_graph_edges);
+            writeValue(&f, m_graph_weight);
+            writeValue(&f, m_graph_hash);
+            writeArray(&f, m_vertex_to_node);
+            writeArray(&f, m_tree_source);
+            writeArray(&f, m_tree_target);
+            writeArray(&f, m_cycle_start);
+            writeArray(&f, m_cycle_nodes);
+            return static_cast<bool>(f);
+        }
+
+        static compactCactusPtr readBinary(const std::string& filename) {
+            std::ifstream f(filename, std::ios::binary);
+            if (!f) {
+                LOG1 << "Error opening cactus file " << filename;
+                return nullptr;
+            }
+
+            uint64_t magic = 0, version = 0, mincut = 0, num_nodes = 0;
+            readValue(&f, &magic);
+            readValue(&f, &version);
+            if (magic != binary_magic || version != binary_version) {
+                LOG1 << "Error: " << filename << " is not a VieCut cactus file"
+                     << " of version " << binary_version;
+                return nullptr;
+            }
+
+            compactCactusPtr C = std::make_shared<compact_cactus>();
+            readValue(&f, &mincut);
+            readValue(&f, &num_nodes);
+            C->m_mincut = mincut;
+            C->m_num_nodes = num_nodes;
+            bool success = readValue(&f, &C->m_graph_edges)
+                           && readValue(&f, &C->m_graph_weight)
+                           && readValue(&f, &C->m_graph_hash)
+                           && readArray(&f, &C->m_vertex_to_node)
+                           && readArray(&f, &C->m_tree_source)
+                           && readArray(&f, &C->m_tree_target)
+                           && readArray(&f, &C->m_cycle_start)
+                           && readArray(&f, &C->m_cycle_nodes);
+
+            if (!success || !C->isConsistent()) {
+                LOG1 << "Error: cactus file " << filename << " is corrupted";
+                return nullptr;
+            }
+
+            C->buildContainedVertices();
+            return C;
+        }
+
+        EdgeWeight getMincut() const {
+            return m_mincut;
+        }
+
+        NodeID n() const {
+            return m_num_nodes;
+        }
+
+        NodeID numVertices() const {
+            return m_vertex_to_node.size();
+        }
+
+        size_t numTreeEdges() const {
+            return m_tree_source.size();
+        }
+
+        size_t numCycles() const {
+            return m_cycle_start.size() - 1;
+        }
+
+        std::pair<NodeID, NodeID> getTreeEdge(size_t e) const {
+            return std::make_pair(m_tree_source[e], m_tree_target[e]);
+        }
+
+        vertex_range getCycle(size_t c) const {
+            return vertex_range(m_cycle_nodes.data() + m_cycle_start[c],
+                                m_cycle_nodes.data() + m_cycle_start[c + 1]);
+        }
+
+        NodeID getCurrentPosition(NodeID v) const {
+            return m_vertex_to_node[v];
+        }
+
+        vertex_range containedVertices(NodeID n) const {
+            return vertex_range(m_node_vertices.data() + m_node_start[n],
+                                m_node_vertices.data() + m_node_start[n + 1]);
+        }
+
+        size_t numContainedVertices(NodeID n) const {
+            return m_node_start[n + 1] - m_node_start[n];
+        }
+
+     private:
+        // number of edges, total edge weight and sum of a hash of every
+        // edge, which does not depend on the order of the edges
+        template <class GraphPtr>
+        static std::tuple<uint64_t, uint64_t, uint64_t> fingerprint(
+            GraphPtr G) {
+            uint64_t weight = 0;
+            uint64_t hash = 0;
+            for (NodeID n : G->nodes()) {
+                for (EdgeID e : G->edges_of(n)) {
+                    NodeID t = G->getEdgeTarget(n, e);
+                    EdgeWeight w = G->getEdgeWeight(n, e);
+                    weight += w;
+                    hash += mix(mix(mix(n) ^ t) ^ w);
+                }
+            }
+            return std::make_tuple(G->number_of_edges(), weight, hash);
+        }
+
+        // finalizer of splitmix64
+        static uint64_t mix(uint64_t x) {
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+            return x ^ (x >> 31);
+        }
+
+        void buildContainedVertices() {
+            m_node_start.assign(m_num_nodes + 1, 0);
+            for (NodeID p : m_vertex_to_node) {
+                ++m_node_start[p + 1];
+            }
+            for (NodeID n = 0; n < m_num_nodes; ++n) {
+                m_node_start[n + 1] += m_node_start[n];
+            }
+
+            m_node_vertices.resize(m_vertex_to_node.size());
+            std::vector<NodeID> next(m_node_start.begin(), m_node_start.end() - 1);
+            for (NodeID v = 0; v < m_vertex_to_node.size(); ++v) {
+                m_node_vertices[next[m_vertex_to_node[v]]++] = v;
+            }
+        }
+
+        // iterative dfs on the cactus. as every edge is in at most one cycle,
+        // each back edge closes exactly one cycle, which consists of the back
+        // edge and the path of tree edges between its endpoints.
+        void findTreeEdgesAndCycles(mutableGraphPtr cactus) {
+            std::vector<DFSVertexStatus> status(m_num_nodes, UNDISCOVERED);
+            std::vector<NodeID> parent(m_num_nodes, UNDEFINED_NODE);
+            std::vector<EdgeID> parent_rev(m_num_nodes, UNDEFINED_EDGE);
+            std::vector<EdgeID> next_edge(m_num_nodes, 0);
+            std::vector<bool> parent_edge_in_cycle(m_num_nodes, false);
+            std::vector<NodeID> stack;
+            std::vector<NodeID> cycle;
+            m_cycle_start.clear();
+            m_cycle_start.emplace_back(0);
+
+            for (NodeID root : cactus->nodes()) {
+                if (status[root] != UNDISCOVERED)
+                    continue;
+
+                status[root] = ACTIVE;
+                stack.emplace_back(root);
+                while (!stack.empty()) {
+                    NodeID v = stack.back();
+                    if (next_edge[v] == cactus->get_first_invalid_edge(v)) {
+                        status[v] = FINISHED;
+                        stack.pop_back();
+                        if (parent[v] != UNDEFINED_NODE
+                            && !parent_edge_in_cycle[v]) {
+                            m_tree_source.emplace_back(parent[v]);
+                            m_tree_target.emplace_back(v);
+                        }
+                        continue;
+                    }
+
+                    EdgeID e = next_edge[v]++;
+                    if (e == parent_rev[v])
+                        continue;
+
+                    NodeID t = cactus->getEdgeTarget(v, e);
+                    if (status[t] == UNDISCOVERED) {
+                        status[t] = ACTIVE;
+                        parent[t] = v;
+                        parent_rev[t] = cactus->getReverseEdge(v, e);
+                        stack.emplace_back(t);
+                    } else if (status[t] == ACTIVE) {
+                        // back edge to ancestor t closes a cycle
+                        cycle.clear();
+                        for (NodeID c = v; c != t; c = parent[c]) {
+                            parent_edge_in_cycle[c] = true;
+                            cycle.emplace_back(c);
+                        }
+                        cycle.emplace_back(t);
+
+                        if (cycle.size() == 2) {
+                            m_tree_source.emplace_back(t);
+                            m_tree_target.emplace_back(v);
+                        } else {
+                            m_cycle_nodes.insert(m_cycle_nodes.end(),
+                                                 cycle.rbegin(), cycle.rend());
+                            m_cycle_start.emplace_back(m_cycle_nodes.size());
+                        }
+                    }
+                }
+            }
+            LOG << "compact cactus n " << m_num_nodes
+                << " tree edges " << numTreeEdges()
+                << " cycles " << numCycles();
+        }
+
+        bool isConsistent() const {
+            if (m_tree_source.size() != m_tree_target.size()
+                || m_cycle_start.empty() || m_cycle_start[0] != 0
+                || m_cycle_start.back() != m_cycle_nodes.size())
+                return false;
+
+            for (size_t c = 0; c + 1 < m_cycle_start.size(); ++c) {
+                if (m_cycle_start[c] > m_cycle_start[c + 1])
+                    return false;
+            }
+
+            for (const auto& arr : { &m_vertex_to_node, &m_tree_source,
+                                     &m_tree_target, &m_cycle_nodes }) {
+                for (NodeID n : *arr) {
+                    if (n >= m_num_nodes)
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename T>
+        static void writeValue(std::ofstream* f, const T& value) {
+            f->write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        static void writeArray(std::ofstream* f, const std::vector<T>& vec) {
+            writeValue(f, static_cast<uint64_t>(vec.size()));
+            f->write(reinterpret_cast<const char*>(vec.data()),
+                     vec.size() * sizeof(T));
+        }
+
+        template <typename T>
+        static bool readValue(std::ifstream* f, T* value) {
+            f->read(reinterpret_cast<char*>(value), sizeof(T));
+            return static_cast<bool>(*f);
+        }
+
+        template <typename T>
+        static bool readArray(std::ifstream* f, std::vector<T>* vec) {
+            uint64_t size = 0;
+            if (!readValue(f, &size))
+                return false;
+
+            // don't trust the size blindly, check against remaining file size
+            std::streampos pos = f->tellg();
+            f->seekg(0, std::ios::end);
+            std::streampos end = f->tellg();
+            f->seekg(pos);
+            if (static_cast<uint64_t>(end - pos) < size * sizeof(T))
+                return false;
+
+            vec->resize(size);
+            f->read(reinterpret_cast<char*>(vec->data()), size * sizeof(T));
+            return static_cast<bool>(*f);
+        }
+
+        EdgeWeight m_mincut;
+        NodeID m_num_nodes;
+        uint64_t m_graph_edges;
+        uint64_t m_graph_weight;
+        uint64_t m_graph_hash;
+        std::vector<NodeID> m_vertex_to_node;
+        std::vector<EdgeID> m_node_start;
+        std::vector<NodeID> m_node_vertices;
+        std::vector<NodeID> m_tree_source;
+        std::vector<NodeID> m_tree_target;
+        std::vector<EdgeID> m_cycle_start;
+        std::vector<NodeID> m_cycle_nodes;
+    };
+}
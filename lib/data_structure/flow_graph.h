@@ -14,138 +14,202 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
+#include <tuple>
 #include <vector>
 
 #include "common/definitions.h"
 #include "data_structure/graph_access.h"
+#include "tools/macros_assertions.h"
 
 namespace VieCut {
-    struct rEdge {
-        NodeID   source;
-        NodeID   target;
-        FlowType capacity;
-        FlowType flow;
-        EdgeID   reverse_edge_index;
-
-        rEdge(NodeID source, NodeID target, FlowType capacity,
-              FlowType flow, EdgeID reverse_edge_index) {
-            this->source = source;
-            this->target = target;
-            this->capacity = capacity;
-            this->flow = flow;
-            this->reverse_edge_index = reverse_edge_index;
-        }
-    };
-
-    // this is a adjacency list implementation of the residual graph
+    // this is a compressed sparse row implementation of the residual graph.
     // for each edge we create, we create a rev edge with cap 0
     // zero capacity edges are residual edges
+    //
+    // targets, capacities, flows and reverse edges are stored in separate
+    // arrays, which are indexed by arcs. the arcs of node n are
+    // first_arc(n) to first_invalid_arc(n) - 1, edge e of n is arc
+    // first_arc(n) + e. flow algorithms can iterate over arcs directly,
+    // the accessors with (node, edge) are kept for convenience.
+    //
+    // edges added with new_edge are collected and only inserted in
+    // finish_construction. from_graph_access builds the residual graph
+    // without collecting edges first.
     class flow_graph {
      public:
         flow_graph() {
             m_num_edges = 0;
             m_num_nodes = 0;
+            m_offset.resize(1, 0);
         }
 
         virtual ~flow_graph() { }
 
         void start_construction(NodeID nodes, EdgeID edges = 0) {
-            m_adjacency_lists.resize(nodes);
-            m_capacity.resize(nodes);
             m_num_nodes = nodes;
-            m_num_edges = edges;
+            m_num_edges = 0;
+            m_new_edges.clear();
+            m_new_edges.reserve(edges);
+            build(nodes, [](auto) { });
+        }
+
+        void finish_construction() {
+            build(m_num_nodes, [this](auto add_edge) {
+                      for (const auto& [src, tgt, cap] : m_new_edges) {
+                          add_edge(src, tgt, cap);
+                      }
+                  });
+            m_new_edges.clear();
+            m_new_edges.shrink_to_fit();
         }
 
-        void finish_construction() { }
+        static std::shared_ptr<flow_graph> from_graph_access(
+            graphAccessPtr G) {
+            std::shared_ptr<flow_graph> fg = std::make_shared<flow_graph>();
+            fg->m_num_nodes = G->number_of_nodes();
+            fg->build(G->number_of_nodes(), [&G](auto add_edge) {
+                          for (NodeID n : G->nodes()) {
+                              for (EdgeID e : G->edges_of(n)) {
+                                  add_edge(n, G->getEdgeTarget(e),
+                                           G->getEdgeWeight(e));
+                              }
+                          }
+                      });
+            return fg;
+        }
 
         NodeID number_of_nodes() const { return m_num_nodes; }
-        EdgeID number_of_edges() { return m_num_edges; }
+        EdgeID number_of_edges() const { return m_num_edges; }
 
-        NodeID getEdgeTarget(NodeID source, EdgeID e);
+        NodeID getEdgeTarget(NodeID source, EdgeID e) const;
         FlowType getEdgeCapacity(NodeID source, EdgeID e) const;
 
-        FlowType getEdgeFlow(NodeID source, EdgeID e);
+        FlowType getEdgeFlow(NodeID source, EdgeID e) const;
         void setEdgeFlow(NodeID source, EdgeID e, FlowType flow);
 
-        EdgeID getReverseEdge(NodeID source, EdgeID e);
+        EdgeID getReverseEdge(NodeID source, EdgeID e) const;
 
         void new_edge(NodeID source, NodeID target, FlowType capacity) {
-            m_adjacency_lists[source].push_back(
-                rEdge(source, target, capacity, 0,
-                      m_adjacency_lists[target].size()));
-            // for each edge we add a reverse edge
-            m_adjacency_lists[target].push_back(
-                rEdge(target, source, 0, 0, m_adjacency_lists[source].size() - 1));
-            m_capacity[source] += capacity;
-            m_num_edges += 2;
+            m_new_edges.emplace_back(source, target, capacity);
         }
 
         FlowType getCapacity(NodeID node) const {
-            return m_capacity[node];
+            return m_node_capacity[node];
         }
 
-        EdgeID get_first_edge(NodeID /* node */) { return 0; }
-        EdgeID get_first_invalid_edge(NodeID node) {
-            return m_adjacency_lists[node].size();
+        EdgeID get_first_edge(NodeID /* node */) const { return 0; }
+        EdgeID get_first_invalid_edge(NodeID node) const {
+            return m_offset[node + 1] - m_offset[node];
         }
 
-        auto nodes() {
+        auto nodes() const {
             return iterator<NodeID>(0, number_of_nodes());
         }
 
-        auto edges_of(NodeID n) {
+        auto edges_of(NodeID n) const {
             return iterator<EdgeID>(get_first_edge(n), get_first_invalid_edge(n));
         }
 
+        // arc based access
+
+        EdgeID first_arc(NodeID node) const { return m_offset[node]; }
+        EdgeID first_invalid_arc(NodeID node) const {
+            return m_offset[node + 1];
+        }
+
+        auto arcs_of(NodeID n) const {
+            return iterator<EdgeID>(first_arc(n), first_invalid_arc(n));
+        }
+
+        NodeID arcTarget(EdgeID a) const { return m_target[a]; }
+        FlowType arcCapacity(EdgeID a) const { return m_capacity[a]; }
+        FlowType arcFlow(EdgeID a) const { return m_flow[a]; }
+        void setArcFlow(EdgeID a, FlowType flow) { m_flow[a] = flow; }
+        EdgeID reverseArc(EdgeID a) const { return m_reverse[a]; }
+
+        void resetFlows() {
+            std::fill(m_flow.begin(), m_flow.end(), 0);
+        }
+
      private:
-        std::vector<std::vector<rEdge> > m_adjacency_lists;
+        // calls for_each_edge twice with a function add_edge(src, tgt, cap),
+        // first to count the degrees and then to fill the arrays. the arcs
+        // of a node are in the order in which new_edge would add them.
+        template <class ForEachEdge>
+        void build(NodeID nodes, ForEachEdge for_each_edge) {
+            m_offset.assign(nodes + 1, 0);
+            m_node_capacity.assign(nodes, 0);
+            for_each_edge([this](NodeID src, NodeID tgt, FlowType cap) {
+                              m_offset[src + 1]++;
+                              m_offset[tgt + 1]++;
+                              m_node_capacity[src] += cap;
+                          });
+
+            for (NodeID n = 0; n < nodes; ++n) {
+                m_offset[n + 1] += m_offset[n];
+            }
+
+            m_num_edges = m_offset[nodes];
+            m_target.resize(m_num_edges);
+            m_capacity.resize(m_num_edges);
+            m_flow.assign(m_num_edges, 0);
+            m_reverse.resize(m_num_edges);
+
+            std::vector<EdgeID> pos(m_offset.begin(), m_offset.end() - 1);
+            for_each_edge([this, &pos](NodeID src, NodeID tgt, FlowType cap) {
+                              EdgeID fwd = pos[src]++;
+                              EdgeID bwd = pos[tgt]++;
+                              m_target[fwd] = tgt;
+                              m_capacity[fwd] = cap;
+                              m_reverse[fwd] = bwd;
+                              m_target[bwd] = src;
+                              m_capacity[bwd] = 0;
+                              m_reverse[bwd] = fwd;
+                          });
+        }
+
+        EdgeID arc(NodeID source, EdgeID e) const {
+            VIECUT_ASSERT_LT(source, m_num_nodes);
+            VIECUT_ASSERT_LT(m_offset[source] + e, m_offset[source + 1]);
+            return m_offset[source] + e;
+        }
+
+        std::vector<EdgeID> m_offset;
+        std::vector<NodeID> m_target;
         std::vector<FlowType> m_capacity;
+        std::vector<FlowType> m_flow;
+        std::vector<EdgeID> m_reverse;
+        std::vector<FlowType> m_node_capacity;
+        std::vector<std::tuple<NodeID, NodeID, FlowType> > m_new_edges;
         NodeID m_num_nodes;
-        NodeID m_num_edges;
+        EdgeID m_num_edges;
     };
 
     inline
     FlowType flow_graph::getEdgeCapacity(NodeID source, EdgeID e) const {
-    #ifdef NDEBUG
-        return m_adjacency_lists[source][e].capacity;
-    #else
-        return m_adjacency_lists.at(source).at(e).capacity;
-    #endif
+        return m_capacity[arc(source, e)];
     }
 
     inline
     void flow_graph::setEdgeFlow(NodeID source, EdgeID e, FlowType flow) {
-    #ifdef NDEBUG
-        m_adjacency_lists[source][e].flow = flow;
-    #else
-        m_adjacency_lists.at(source).at(e).flow = flow;
-    #endif
+        m_flow[arc(source, e)] = flow;
     }
 
     inline
-    FlowType flow_graph::getEdgeFlow(NodeID source, EdgeID e) {
-    #ifdef NDEBUG
-        return m_adjacency_lists[source][e].flow;
-    #else
-        return m_adjacency_lists.at(source).at(e).flow;
-    #endif
+    FlowType flow_graph::getEdgeFlow(NodeID source, EdgeID e) const {
+        return m_flow[arc(source, e)];
     }
 
     inline
-    NodeID flow_graph::getEdgeTarget(NodeID source, EdgeID e) {
-    #ifdef NDEBUG
-        return m_adjacency_lists[source][e].target;
-    #else
-        return m_adjacency_lists.at(source).at(e).target;
-    #endif
+    NodeID flow_graph::getEdgeTarget(NodeID source, EdgeID e) const {
+        return m_target[arc(source, e)];
     }
 
     inline
-    EdgeID flow_graph::getReverseEdge(NodeID source, EdgeID e) {
-    #ifdef NDEBUG
-        return m_adjacency_lists[source][e].reverse_edge_index;
-    #else
-        return m_adjacency_lists.at(source).at(e).reverse_edge_index;
-    #endif
+    EdgeID flow_graph::getReverseEdge(NodeID source, EdgeID e) const {
+        EdgeID rev = m_reverse[arc(source, e)];
+        return rev - m_offset[m_target[arc(source, e)]];
     }
 }
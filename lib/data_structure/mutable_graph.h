@@ -24,6 +24,7 @@
 #include "common/definitions.h"
 #include "data_structure/graph_access.h"
 #include "tlx/logger.hpp"
+#include "tools/varint.h"
 
 namespace VieCut {
     struct RevEdge {
@@ -916,6 +917,96 @@ namespace VieCut {
             return serial;
         }
 
+        // appends the graph in the format of serialize() with variable length
+        // integers instead of 64 bit words. each edge is stored once, at its
+        // endpoint with lower id, and targets are stored as differences to
+        // the previous target in sorted order, which usually takes one byte
+        void serializeCompact(std::vector<uint8_t>* out) {
+            varint::write(out, vertices.size());
+            varint::write(out, partition_count);
+            varint::write(out, original_nodes);
+
+            std::vector<std::pair<NodeID, EdgeWeight> > higher;
+            for (NodeID n : nodes()) {
+                higher.clear();
+                for (const auto& e : vertices[n]) {
+                    if (e.target > n) {
+                        higher.emplace_back(e.target, e.weight);
+                    }
+                }
+                std::sort(higher.begin(), higher.end());
+                varint::write(out, higher.size());
+                NodeID previous = n;
+                for (const auto& [t, w] : higher) {
+                    varint::write(out, t - previous);
+                    varint::write(out, w);
+                    previous = t;
+                }
+            }
+
+            for (NodeID n : nodes()) {
+                varint::write(out, partition_index[n]);
+            }
+
+            for (NodeID i = 0; i < original_nodes; ++i) {
+                varint::write(out, current_position[i]);
+            }
+        }
+
+        // reads a graph written by serializeCompact starting at *pos and
+        // moves *pos behind it. returns nullptr if the input is malformed
+        static mutableGraphPtr deserializeCompact(
+            const std::vector<uint8_t>& in, size_t* pos) {
+            uint64_t num_nodes, partitions, num_original;
+            if (!varint::read(in, pos, &num_nodes)
+                || !varint::read(in, pos, &partitions)
+                || !varint::read(in, pos, &num_original)
+                || num_nodes > in.size() || num_original > in.size()) {
+                return nullptr;
+            }
+
+            mutableGraphPtr G = std::make_shared<mutable_graph>();
+            G->start_construction(num_nodes);
+            G->set_partition_count(partitions);
+            G->setOriginalNodes(num_original);
+
+            for (NodeID n = 0; n < num_nodes; ++n) {
+                uint64_t degree;
+                if (!varint::read(in, pos, &degree))
+                    return nullptr;
+                uint64_t target = n;
+                for (uint64_t i = 0; i < degree; ++i) {
+                    uint64_t diff, wgt;
+                    if (!varint::read(in, pos, &diff)
+                        || !varint::read(in, pos, &wgt))
+                        return nullptr;
+                    target += diff;
+                    if (target >= num_nodes)
+                        return nullptr;
+                    G->new_edge(n, target, wgt);
+                }
+            }
+
+            for (NodeID n = 0; n < num_nodes; ++n) {
+                uint64_t partition;
+                if (!varint::read(in, pos, &partition))
+                    return nullptr;
+                G->setPartitionIndex(n, partition);
+                G->setContainedVertices(n, { });
+            }
+
+            for (NodeID i = 0; i < num_original; ++i) {
+                uint64_t position;
+                if (!varint::read(in, pos, &position) || position >= num_nodes)
+                    return nullptr;
+                G->setCurrentPosition(i, position);
+                G->addContainedVertex(position, i);
+            }
+
+            G->finish_construction();
+            return G;
+        }
+
         mutableGraphPtr simplify() {
             mutableGraphPtr G = std::make_shared<mutable_graph>();
             G->start_construction(number_of_nodes());
@@ -0,0 +1,103 @@
+/******************************************************************************
+ * pair_bitset.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/definitions.h"
+
+namespace VieCut {
+    // Set of unordered pairs {a, b} with a != b of elements 0..n-1, stored
+    // as the lower triangle of a n x n bit matrix. Pair {a, b} with a < b has
+    // index b * (b - 1) / 2 + a, computed in 64 bit, so the index does not
+    // overflow for any number of elements.
+    //
+    // Copies share the bits until one of them is changed. Like the graph of
+    // a lazy problem, the bits are only copied if another set still uses
+    // them, so a set that is copied for every child of a branch and only
+    // changed in some of them costs a pointer copy for the others.
+    class pair_bitset {
+     public:
+        pair_bitset() { }
+
+        // n is the number of elements, only used to size the bits when the
+        // first pair is inserted
+        void insert(NodeID a, NodeID b, NodeID n) {
+            size_t i = index(a, b);
+            writableBits(n, i)[i / 64] |= bit(i);
+        }
+
+        void erase(NodeID a, NodeID b) {
+            if (!contains(a, b))
+                return;
+            size_t i = index(a, b);
+            writableBits(0, i)[i / 64] &= ~bit(i);
+        }
+
+        bool contains(NodeID a, NodeID b) const {
+            size_t i = index(a, b);
+            return bits != nullptr && i / 64 < bits->size()
+                   && ((*bits)[i / 64] & bit(i)) != 0;
+        }
+
+        size_t size() const {
+            size_t num = 0;
+            if (bits != nullptr) {
+                for (uint64_t word : *bits) {
+                    num += __builtin_popcountll(word);
+                }
+            }
+            return num;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+     private:
+        static size_t index(NodeID a, NodeID b) {
+            size_t lo = std::min(a, b);
+            size_t hi = std::max(a, b);
+            return hi * (hi - 1) / 2 + lo;
+        }
+
+        static uint64_t bit(size_t i) {
+            return uint64_t { 1 } << (i % 64);
+        }
+
+        // bits that only this set uses, with room for index i
+        std::vector<uint64_t>& writableBits(NodeID n, size_t i) {
+            size_t words = std::max(
+                (static_cast<size_t>(n) * (n - 1) / 2 + 63) / 64, i / 64 + 1);
+            if (bits == nullptr) {
+                bits = std::make_shared<std::vector<uint64_t> >(words, 0);
+            } else if (bits.use_count() > 1) {
+                bits = std::make_shared<std::vector<uint64_t> >(*bits);
+            } else {
+                // use_count is a relaxed load. sets on other threads that
+                // read the bits before they released them must not see
+                // the following writes
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+            if (bits->size() < words) {
+                bits->resize(words, 0);
+            }
+            return *bits;
+        }
+
+        std::shared_ptr<std::vector<uint64_t> > bits;
+    };
+}
@@ -316,17 +316,7 @@ namespace VieCut {
 
         static std::shared_ptr<flow_graph> createFlowGraph(
             graphAccessPtr G) {
-            std::shared_ptr<flow_graph> fg = std::make_shared<flow_graph>();
-            fg->start_construction(G->number_of_nodes());
-
-            for (NodeID n : G->nodes()) {
-                for (EdgeID e : G->edges_of(n)) {
-                    NodeID tgt = G->getEdgeTarget(e);
-                    fg->new_edge(n, tgt, G->getEdgeWeight(e));
-                }
-            }
-
-            fg->finish_construction();
+            std::shared_ptr<flow_graph> fg = flow_graph::from_graph_access(G);
 
             VIECUT_ASSERT_EQ(fg->number_of_nodes(), G->number_of_nodes());
             VIECUT_ASSERT_EQ(fg->number_of_edges(), 2 * G->number_of_edges());
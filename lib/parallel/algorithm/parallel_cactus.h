@@ -22,12 +22,14 @@
 #include <utility>
 #include <vector>
 
+#include "algorithms/flow/flow_statistics.h"
 #include "algorithms/global_mincut/cactus/most_balanced_minimum_cut.h"
 #include "algorithms/global_mincut/cactus/recursive_cactus.h"
 #include "algorithms/global_mincut/minimum_cut_helpers.h"
 #include "algorithms/global_mincut/noi_minimum_cut.h"
 #include "algorithms/global_mincut/viecut.h"
 #include "common/definitions.h"
+#include "data_structure/compact_cactus.h"
 #include "data_structure/graph_access.h"
 #include "data_structure/priority_queues/bucket_pq.h"
 #include "data_structure/priority_queues/fifo_node_bucket_pq.h"
@@ -198,6 +200,7 @@ namespace VieCut {
 
             rc.setMincut(mincut);
             auto out_graph = rc.flowMincut(graphs);
+            flow_stats.add(rc.getFlowStatistics());
 
             minimum_cut_helpers<GraphPtr>::setVertexLocations(
                 out_graph, graphs, ge_ids, guaranteed_edges, mincut);
@@ -210,7 +213,22 @@ namespace VieCut {
                 most_balanced_minimum_cut<GraphPtr> mbmc;
                 mb_edges = mbmc.findCutFromCactus(out_graph, mincut, graphs[0]);
             }
+
+            if (configuration::getConfig()->cactus_binary_filename != "") {
+                auto C = compact_cactus::fromMutableGraph(out_graph, mincut);
+                C->setGraph(graphs[0]);
+                C->writeBinary(
+                    configuration::getConfig()->cactus_binary_filename);
+            }
             return std::make_tuple(mincut, out_graph, mb_edges);
         }
+
+        // flow statistics of all cactus computations of this object
+        const flow_statistics& getFlowStatistics() const {
+            return flow_stats;
+        }
+
+     private:
+        flow_statistics flow_stats;
     };
 }
@@ -0,0 +1,167 @@
+/******************************************************************************
+ * work_stealing_deque.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace VieCut {
+    // Lock-free work stealing deque of Chase and Lev (SPAA 2005) with the
+    // memory orderings of Le et al. (PPoPP 2013). The owner thread pushes
+    // and takes at the bottom, any other thread steals from the top.
+    // T has to be a pointer type, nullptr marks an empty or failed steal.
+    //
+    // The array grows when it is full. Old arrays are kept until the deque
+    // is destroyed, as a concurrent thief might still read from them.
+    template <typename T>
+    class work_stealing_deque {
+     public:
+        explicit work_stealing_deque(size_t initial_capacity = 64)
+            : m_top(0), m_bottom(0) {
+            size_t capacity = 1;
+            while (capacity < initial_capacity) {
+                capacity *= 2;
+            }
+            m_arrays.emplace_back(std::make_unique<circular_array>(capacity));
+            m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+        }
+        ~work_stealing_deque() { }
+
+        work_stealing_deque(const work_stealing_deque&) = delete;
+        work_stealing_deque& operator = (const work_stealing_deque&) = delete;
+
+        // only called by the owner
+        void push(T item) {
+            int64_t b = m_bottom.load(std::memory_order_relaxed);
+            int64_t t = m_top.load(std::memory_order_acquire);
+            circular_array* a = m_array.load(std::memory_order_relaxed);
+            if (b - t > static_cast<int64_t>(a->size()) - 1) {
+                a = grow(a, t, b);
+            }
+            a->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        // only called by the owner, returns the last pushed item or nullptr
+        T take() {
+            int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+            circular_array* a = m_array.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = m_top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            T item = a->get(b);
+            if (t == b) {
+                // last item, race against thieves
+                if (!m_top.compare_exchange_strong(
+                        t, t + 1, std::memory_order_seq_cst,
+                        std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        // called by any thread, returns the oldest item or nullptr if the
+        // deque is empty or another thread was faster
+        T steal() {
+            int64_t t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = m_bottom.load(std::memory_order_acquire);
+            if (t >= b) {
+                return nullptr;
+            }
+
+            circular_array* a = m_array.load(std::memory_order_acquire);
+            T item = a->get(t);
+            if (!m_top.compare_exchange_strong(
+                    t, t + 1, std::memory_order_seq_cst,
+                    std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+
+        // approximate if other threads work on the deque at the same time
+        size_t size() const {
+            int64_t b = m_bottom.load(std::memory_order_relaxed);
+            int64_t t = m_top.load(std::memory_order_relaxed);
+            return b > t ? b - t : 0;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        // items from the oldest to the newest. only correct if no other
+        // thread works on the deque at the same time
+        std::vector<T> items() const {
+            int64_t b = m_bottom.load(std::memory_order_acquire);
+            int64_t t = m_top.load(std::memory_order_acquire);
+            circular_array* a = m_array.load(std::memory_order_acquire);
+            std::vector<T> result;
+            for (int64_t i = t; i < b; ++i) {
+                result.emplace_back(a->get(i));
+            }
+            return result;
+        }
+
+     private:
+        class circular_array {
+         public:
+            explicit circular_array(size_t capacity)
+                : m_mask(capacity - 1), m_items(capacity) { }
+
+            size_t size() const {
+                return m_mask + 1;
+            }
+
+            T get(int64_t i) const {
+                return m_items[i & m_mask].load(std::memory_order_relaxed);
+            }
+
+            void put(int64_t i, T item) {
+                m_items[i & m_mask].store(item, std::memory_order_relaxed);
+            }
+
+         private:
+            size_t m_mask;
+            std::vector<std::atomic<T> > m_items;
+        };
+
+        circular_array* grow(circular_array* a, int64_t t, int64_t b) {
+            m_arrays.emplace_back(std::make_unique<circular_array>(
+                                      2 * a->size()));
+            circular_array* bigger = m_arrays.back().get();
+            for (int64_t i = t; i < b; ++i) {
+                bigger->put(i, a->get(i));
+            }
+            m_array.store(bigger, std::memory_order_release);
+            return bigger;
+        }
+
+        std::atomic<int64_t> m_top;
+        std::atomic<int64_t> m_bottom;
+        std::atomic<circular_array*> m_array;
+        // only accessed by the owner
+        std::vector<std::unique_ptr<circular_array> > m_arrays;
+    };
+}
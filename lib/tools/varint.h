@@ -0,0 +1,65 @@
+/******************************************************************************
+ * varint.h
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace VieCut {
+    // Variable length encoding of integers (LEB128): 7 bits per byte, the
+    // highest bit is set if another byte follows. Small values, e.g.
+    // differences between sorted vertex ids, take a single byte.
+    class varint {
+     public:
+        static void write(std::vector<uint8_t>* out, uint64_t value) {
+            while (value >= 0x80) {
+                out->emplace_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out->emplace_back(static_cast<uint8_t>(value));
+        }
+
+        // zigzag encoding, values with small absolute value are short
+        static void writeSigned(std::vector<uint8_t>* out, int64_t value) {
+            write(out, (static_cast<uint64_t>(value) << 1)
+                  ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        // reads the value starting at *pos and moves *pos behind it.
+        // returns false if the input ends before the value
+        static bool read(const std::vector<uint8_t>& in,
+                         size_t* pos, uint64_t* value) {
+            uint64_t result = 0;
+            for (size_t shift = 0; shift < 64; shift += 7) {
+                if (*pos >= in.size())
+                    return false;
+                uint8_t byte = in[(*pos)++];
+                result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    *value = result;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static bool readSigned(const std::vector<uint8_t>& in,
+                               size_t* pos, int64_t* value) {
+            uint64_t zigzag;
+            if (!read(in, pos, &zigzag))
+                return false;
+            *value = static_cast<int64_t>(zigzag >> 1)
+                     ^ -static_cast<int64_t>(zigzag & 1);
+            return true;
+        }
+    };
+}
@@ -12,7 +12,11 @@
 #include <time.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -29,8 +33,12 @@
 #include "algorithms/global_mincut/stoer_wagner_minimum_cut.h"
 #include "algorithms/global_mincut/viecut.h"
 #endif
+#include "algorithms/global_mincut/cactus/cactus_cut_enumerator.h"
+#include "algorithms/global_mincut/cactus/parallel_balanced_cut.h"
+#include "algorithms/global_mincut/dynamic/dynamic_mincut_witness.h"
 #include "common/configuration.h"
 #include "common/definitions.h"
+#include "data_structure/compact_cactus.h"
 #include "gtest/gtest_pred_impl.h"
 #include "io/graph_io.h"
 #include "tlx/logger.hpp"
@@ -618,3 +626,273 @@ TYPED_TEST(CactusCutTest, TwoDTorus) {
     }
     ASSERT_EQ(sizes, desired_sizes);
 }
+
+// ring of three 4-cliques with a path of length 2 attached to the first clique
+template <typename GraphType>
+std::shared_ptr<GraphType> ringOfCliquesWithPath() {
+    auto G = std::make_shared<GraphType>();
+    NodeID num_cliques = 3;
+    G->start_construction(num_cliques * 4 + 2, num_cliques * 20 + 4);
+    for (NodeID k = 0; k < num_cliques; ++k) {
+        NodeID next = ((k + 1) % num_cliques) * 4;
+        NodeID prev = ((k + num_cliques - 1) % num_cliques) * 4;
+        for (NodeID i = 0; i < 4; ++i) {
+            G->new_node();
+            for (NodeID j = 0; j < 4; ++j) {
+                if (i != j) {
+                    G->new_edge(i + (4 * k), j + (4 * k), 2);
+                }
+            }
+            if (i == 0) {
+                G->new_edge(4 * k, prev);
+                G->new_edge(4 * k, next);
+            }
+            if (k == 0 && i == 1) {
+                G->new_edge(1, num_cliques * 4, 2);
+            }
+        }
+    }
+    G->new_node();
+    G->new_edge(num_cliques * 4, 1, 2);
+    G->new_edge(num_cliques * 4, num_cliques * 4 + 1, 2);
+    G->new_node();
+    G->new_edge(num_cliques * 4 + 1, num_cliques * 4, 2);
+    G->finish_construction();
+    return G;
+}
+
+TYPED_TEST(CactusCutTest, CompactCactusRoundTrip) {
+    configuration::getConfig()->save_cut = true;
+    configuration::getConfig()->find_most_balanced_cut = false;
+    NodeID num_cliques = 3;
+    auto G = ringOfCliquesWithPath<TypeParam>();
+
+#ifdef PARALLEL
+    parallel_cactus<std::shared_ptr<TypeParam> > mc;
+#else
+    cactus_mincut<std::shared_ptr<TypeParam> > mc;
+#endif
+    auto [cut, mg, balanced_edges] = mc.findAllMincuts(G);
+    ASSERT_EQ(cut, 2);
+
+    auto compact = compact_cactus::fromMutableGraph(mg, cut);
+    ASSERT_EQ(compact->n(), mg->n());
+    ASSERT_EQ(compact->numVertices(), G->number_of_nodes());
+    ASSERT_EQ(compact->numTreeEdges(), 2);
+    ASSERT_EQ(compact->numCycles(), 1);
+    ASSERT_EQ(compact->getCycle(0).size(), num_cliques);
+
+    std::string filename = "compact_cactus_test.bin";
+    compact->setGraph(G);
+    ASSERT_TRUE(compact->writeBinary(filename));
+    auto loaded = compact_cactus::readBinary(filename);
+    ASSERT_NE(loaded, nullptr);
+    ASSERT_EQ(loaded->getMincut(), cut);
+    ASSERT_TRUE(loaded->matchesGraph(G));
+
+    // a path with the same number of vertices is a different graph
+    auto path = std::make_shared<TypeParam>();
+    path->start_construction(G->number_of_nodes(),
+                             2 * G->number_of_nodes());
+    for (NodeID v = 0; v < G->number_of_nodes(); ++v) {
+        path->new_node();
+        if (v > 0) {
+            path->new_edge(v, v - 1, 2);
+        }
+        if (v + 1 < G->number_of_nodes()) {
+            path->new_edge(v, v + 1, 2);
+        }
+    }
+    path->finish_construction();
+    ASSERT_EQ(path->number_of_nodes(), G->number_of_nodes());
+    ASSERT_FALSE(loaded->matchesGraph(path));
+    ASSERT_EQ(loaded->n(), compact->n());
+    ASSERT_EQ(loaded->numTreeEdges(), compact->numTreeEdges());
+    ASSERT_EQ(loaded->numCycles(), compact->numCycles());
+
+    auto restored = loaded->toMutableGraph();
+    ASSERT_EQ(restored->n(), mg->n());
+    ASSERT_EQ(restored->m(), mg->m());
+    for (NodeID v : G->nodes()) {
+        NodeID pos = restored->getCurrentPosition(v);
+        ASSERT_EQ(pos, mg->getCurrentPosition(v));
+        ASSERT_EQ(restored->numContainedVertices(pos),
+                  mg->numContainedVertices(pos));
+        ASSERT_EQ(loaded->getCurrentPosition(v), pos);
+    }
+
+    std::ofstream truncate(filename, std::ios::binary | std::ios::trunc);
+    truncate << "not a cactus";
+    truncate.close();
+    ASSERT_EQ(compact_cactus::readBinary(filename), nullptr);
+    std::remove(filename.c_str());
+}
+
+TYPED_TEST(CactusCutTest, EnumerateAllMincuts) {
+    configuration::getConfig()->save_cut = true;
+    configuration::getConfig()->find_most_balanced_cut = false;
+    auto G = ringOfCliquesWithPath<TypeParam>();
+#ifdef PARALLEL
+    parallel_cactus<std::shared_ptr<TypeParam> > mc;
+#else
+    cactus_mincut<std::shared_ptr<TypeParam> > mc;
+#endif
+    auto [cut, mg, balanced_edges] = mc.findAllMincuts(G);
+    ASSERT_EQ(cut, 2);
+
+    cactus_cut_enumerator enumerator(mg, cut);
+    // two tree edges on the path and three pairs of edges on the ring
+    ASSERT_EQ(enumerator.numCutRepresentations(), 5);
+
+    size_t num_cuts = 0;
+    std::set<std::vector<NodeID> > sides;
+    for (auto c : enumerator) {
+        EdgeWeight weight = 0;
+        for (NodeID n : G->nodes()) {
+            for (EdgeID e : G->edges_of(n)) {
+                NodeID t = G->getEdgeTarget(n, e);
+                if (enumerator.contains(c, n) && !enumerator.contains(c, t)) {
+                    weight += G->getEdgeWeight(n, e);
+                }
+            }
+        }
+        ASSERT_EQ(weight, cut);
+        auto range = enumerator.vertices(c);
+        std::vector<NodeID> side(range.begin(), range.end());
+        std::sort(side.begin(), side.end());
+        if (std::find(side.begin(), side.end(), 0) != side.end()) {
+            // normalize to the side not containing vertex 0
+            std::vector<NodeID> other;
+            for (NodeID n : G->nodes()) {
+                if (!std::binary_search(side.begin(), side.end(), n))
+                    other.emplace_back(n);
+            }
+            side = other;
+        }
+        sides.insert(side);
+        ++num_cuts;
+    }
+    ASSERT_EQ(num_cuts, 5);
+    ASSERT_EQ(sides.size(), 5);
+
+    std::atomic<size_t> parallel_cuts = 0;
+    enumerator.parallelForEachCut([&](auto c, size_t) {
+                                      ASSERT_TRUE(enumerator.isProperCut(c));
+                                      ++parallel_cuts;
+                                  });
+    ASSERT_EQ(parallel_cuts, num_cuts);
+}
+
+TYPED_TEST(CactusCutTest, ParallelBalancedCutIsBestCut) {
+    configuration::getConfig()->save_cut = true;
+    configuration::getConfig()->find_most_balanced_cut = false;
+    auto G = ringOfCliquesWithPath<TypeParam>();
+#ifdef PARALLEL
+    parallel_cactus<std::shared_ptr<TypeParam> > mc;
+#else
+    cactus_mincut<std::shared_ptr<TypeParam> > mc;
+#endif
+    auto [cut, mg, balanced_edges] = mc.findAllMincuts(G);
+
+    for (bool conductance : { false, true }) {
+        configuration::getConfig()->find_lowest_conductance = conductance;
+        parallel_balanced_cut<std::shared_ptr<TypeParam> > pbc(G, mg, cut);
+        auto best = pbc.findBalancedCut();
+
+        EdgeWeight total = 0;
+        for (NodeID n : G->nodes()) {
+            total += conductance ? G->getWeightedNodeDegree(n) : 1;
+        }
+        ASSERT_EQ(pbc.totalWeight(), total);
+
+        // compare to brute force over all minimum cuts
+        EdgeWeight best_weight = 0;
+        for (auto c : pbc.getEnumerator()) {
+            EdgeWeight side = 0;
+            for (NodeID v : pbc.getEnumerator().vertices(c)) {
+                side += conductance ? G->getWeightedNodeDegree(v) : 1;
+            }
+            best_weight = std::max(best_weight, std::min(side, total - side));
+        }
+        ASSERT_EQ(pbc.lighterBlock(best), best_weight);
+    }
+    configuration::getConfig()->find_lowest_conductance = false;
+}
+
+TEST(DynamicWitnessTest, WitnessMatchesStaticMincut) {
+    configuration::getConfig()->save_cut = true;
+    auto G = ringOfCliquesWithPath<mutable_graph>();
+    random_functions::setSeed(1);
+    dynamic_mincut_witness dynmc;
+    ASSERT_EQ(dynmc.initialize(G), 2);
+
+    std::vector<std::pair<NodeID, NodeID> > inserted;
+    for (size_t i = 0; i < 40; ++i) {
+        NodeID s = random_functions::nextInt(0, G->n() - 1);
+        NodeID t = random_functions::nextInt(0, G->n() - 1);
+        if (s == t) continue;
+        if (i % 3 == 2 && inserted.size() > 0) {
+            auto [ds, dt] = inserted.back();
+            inserted.pop_back();
+            dynmc.removeEdge(ds, dt);
+        } else {
+            dynmc.addEdge(s, t, 1);
+            inserted.emplace_back(s, t);
+        }
+
+        noi_minimum_cut<mutableGraphPtr> noi;
+        EdgeWeight cut = noi.perform_minimum_cut(G);
+        ASSERT_EQ(dynmc.getCurrentCut(), cut);
+
+        const std::vector<bool>& witness = dynmc.getWitness();
+        EdgeWeight witness_weight = 0;
+        size_t inside = 0;
+        for (NodeID n : G->nodes()) {
+            inside += witness[n];
+            for (EdgeID e : G->edges_of(n)) {
+                NodeID tgt = G->getEdgeTarget(n, e);
+                if (witness[n] && !witness[tgt]) {
+                    witness_weight += G->getEdgeWeight(n, e);
+                }
+            }
+        }
+        ASSERT_GT(inside, 0);
+        ASSERT_LT(inside, G->n());
+        ASSERT_EQ(witness_weight, cut);
+    }
+    ASSERT_EQ(dynmc.getCurrentCactus()->n() > 1, true);
+}
+
+TEST(DynamicWitnessTest, CrossingInsertionKeepsOtherMincut) {
+    // ring of cliques, all minimum cuts cut two ring edges and no vertex
+    // has the degree of the minimum cut
+    configuration::getConfig()->save_cut = true;
+    NodeID num_cliques = 6;
+    auto G = std::make_shared<mutable_graph>();
+    G->start_construction(num_cliques * 4);
+    for (NodeID k = 0; k < num_cliques; ++k) {
+        for (NodeID i = 0; i < 4; ++i) {
+            for (NodeID j = i + 1; j < 4; ++j) {
+                G->new_edge_order(4 * k + i, 4 * k + j, 2);
+            }
+        }
+        G->new_edge_order(4 * k, 4 * ((k + 1) % num_cliques) + 1, 1);
+    }
+    G->finish_construction();
+
+    dynamic_mincut_witness dynmc;
+    ASSERT_EQ(dynmc.initialize(G), 2);
+    ASSERT_EQ(dynmc.getCallsOfStaticAlgorithm(), 1);
+
+    // the inserted edges cross the witness, but other minimum cuts remain
+    for (size_t i = 0; i < 3; ++i) {
+        std::vector<bool> witness = dynmc.getWitness();
+        NodeID in = 0;
+        while (!witness[in]) in++;
+        NodeID out = 0;
+        while (witness[out]) out++;
+        dynmc.addEdge(in, out, 1);
+        ASSERT_EQ(dynmc.getCurrentCut(), 2);
+    }
+    ASSERT_EQ(dynmc.getCallsOfStaticAlgorithm(), 1);
+}
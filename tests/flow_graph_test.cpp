@@ -12,7 +12,14 @@
 #include <stddef.h>
 
 #include <memory>
+#include <random>
+#include <set>
+#include <vector>
 
+#include "algorithms/flow/unit_flow.h"
+#include "algorithms/global_mincut/viecut.h"
+#include "coarsening/expander_decomposition.h"
+#include "common/configuration.h"
 #include "common/definitions.h"
 #include "data_structure/flow_graph.h"
 #include "data_structure/graph_access.h"
@@ -105,3 +112,166 @@ TEST(FlowGraphTest, SparseGraph) {
         }
     }
 }
+
+TEST(FlowGraphTest, ConstructionMatchesGraphAccess) {
+    graphAccessPtr G = std::make_shared<graph_access>();
+    G->start_construction(20, 0);
+    for (size_t i = 0; i < 20; ++i) {
+        G->new_node();
+        G->new_edge(i, (i + 1) % 20, i + 1);
+        G->new_edge(i, (i + 7) % 20, 2);
+    }
+    G->finish_construction();
+
+    std::shared_ptr<flow_graph> fG = graph_io::createFlowGraph(G);
+    flow_graph manual;
+    manual.start_construction(G->number_of_nodes());
+    for (NodeID n : G->nodes()) {
+        for (EdgeID e : G->edges_of(n)) {
+            manual.new_edge(n, G->getEdgeTarget(e), G->getEdgeWeight(e));
+        }
+    }
+    manual.finish_construction();
+
+    ASSERT_EQ(fG->number_of_edges(), manual.number_of_edges());
+    for (NodeID n : fG->nodes()) {
+        ASSERT_EQ(fG->getCapacity(n), manual.getCapacity(n));
+        ASSERT_EQ(fG->get_first_invalid_edge(n),
+                  manual.get_first_invalid_edge(n));
+        for (EdgeID e : fG->edges_of(n)) {
+            NodeID tgt = fG->getEdgeTarget(n, e);
+            EdgeID rev = fG->getReverseEdge(n, e);
+            ASSERT_EQ(tgt, manual.getEdgeTarget(n, e));
+            ASSERT_EQ(fG->getEdgeCapacity(n, e), manual.getEdgeCapacity(n, e));
+            ASSERT_EQ(fG->getEdgeTarget(tgt, rev), n);
+            ASSERT_EQ(fG->getReverseEdge(tgt, rev), e);
+
+            EdgeID a = fG->first_arc(n) + e;
+            ASSERT_EQ(fG->arcTarget(a), tgt);
+            ASSERT_EQ(fG->reverseArc(a), fG->first_arc(tgt) + rev);
+        }
+    }
+
+    EdgeID a = fG->first_arc(3);
+    fG->setArcFlow(a, 1);
+    ASSERT_EQ(fG->getEdgeFlow(3, 0), 1);
+    fG->resetFlows();
+    ASSERT_EQ(fG->getEdgeFlow(3, 0), 0);
+}
+
+static graphAccessPtr twoCliques(NodeID size) {
+    graphAccessPtr G = std::make_shared<graph_access>();
+    G->start_construction(2 * size, 2 * size * (size - 1) + 2);
+    for (NodeID i = 0; i < 2 * size; ++i) {
+        G->new_node();
+        NodeID base = (i < size) ? 0 : size;
+        for (NodeID j = base; j < base + size; ++j) {
+            if (i != j)
+                G->new_edge(i, j);
+        }
+        if (i == size - 1)
+            G->new_edge(i, size);
+        if (i == size)
+            G->new_edge(i, size - 1);
+    }
+    G->finish_construction();
+    return G;
+}
+
+TEST(FlowGraphTest, UnitFlowRoutesExcess) {
+    graphAccessPtr G = twoCliques(10);
+    std::shared_ptr<flow_graph> fG = graph_io::createFlowGraph(G);
+
+    std::vector<EdgeWeight> source(fG->number_of_nodes(), 0);
+    source[0] = 15;
+    unit_flow uf;
+    uf.init(fG.get(), source, 1, 20, 2);
+    uf.run();
+
+    FlowType total = 0;
+    for (NodeID n : fG->nodes()) {
+        ASSERT_EQ(uf.excess(n), 0);
+        total += uf.flow(n);
+    }
+    ASSERT_EQ(total, 15);
+}
+
+TEST(FlowGraphTest, UnitFlowKeepsExcessOverSparseCut) {
+    graphAccessPtr G = twoCliques(10);
+    std::shared_ptr<flow_graph> fG = graph_io::createFlowGraph(G);
+
+    // the first clique can absorb 9 per vertex, only the bridge edge
+    // leads to the second clique
+    std::vector<EdgeWeight> source(fG->number_of_nodes(), 0);
+    std::vector<FlowType> sink(fG->number_of_nodes(), 9);
+    source[0] = 100;
+    unit_flow uf;
+    uf.init(fG.get(), source, sink, 1, 30, 2);
+    uf.run();
+
+    FlowType excess = 0;
+    for (NodeID n : fG->nodes()) {
+        excess += uf.excess(n);
+    }
+    ASSERT_GE(excess, 100 - 10 * 9 - 1);
+    ASSERT_GT(excess, 0);
+}
+
+TEST(FlowGraphTest, ExpanderDecompositionTwoCliques) {
+    for (size_t seed = 0; seed < 10; ++seed) {
+        random_functions::setSeed(seed);
+        graphAccessPtr G = twoCliques(20);
+        expander_decomposition<graphAccessPtr> ed(0.1);
+        std::vector<NodeID> cluster = ed.decompose(G);
+
+        for (NodeID n = 0; n < 20; ++n) {
+            ASSERT_EQ(cluster[n], cluster[0]);
+            ASSERT_EQ(cluster[n + 20], cluster[20]);
+        }
+        ASSERT_NE(cluster[0], cluster[20]);
+        ASSERT_EQ(ed.numClusters(), 2);
+        ASSERT_EQ(expander_decomposition<graphAccessPtr>::countClusters(
+                      cluster), 2);
+    }
+}
+
+TEST(FlowGraphTest, ViecutWithExpanderCoarsening) {
+    // two random graphs with average degree 20 connected by four edges
+    NodeID half = 6000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<NodeID> dist(0, half - 1);
+    std::vector<std::set<NodeID> > adj(2 * half);
+    for (NodeID i = 0; i < 2 * half; ++i) {
+        NodeID base = (i < half) ? 0 : half;
+        while (adj[i].size() < 10) {
+            NodeID j = base + dist(gen);
+            if (i != j) {
+                adj[i].insert(j);
+                adj[j].insert(i);
+            }
+        }
+    }
+    for (NodeID i = 0; i < 4; ++i) {
+        adj[i * 1000].insert(i * 1000 + half);
+        adj[i * 1000 + half].insert(i * 1000);
+    }
+
+    graphAccessPtr G = std::make_shared<graph_access>();
+    G->start_construction(2 * half, 40 * half);
+    for (NodeID i = 0; i < 2 * half; ++i) {
+        G->new_node();
+        for (NodeID j : adj[i]) {
+            G->new_edge(i, j);
+        }
+    }
+    G->finish_construction();
+
+    auto cfg = configuration::getConfig();
+    cfg->expander_coarsening = true;
+    cfg->expander_threshold = 0.0;
+    viecut<graphAccessPtr> vc;
+    EdgeWeight cut = vc.perform_minimum_cut(G);
+    cfg->expander_coarsening = false;
+    cfg->expander_threshold = 0.5;
+    ASSERT_EQ(cut, 4);
+}
@@ -0,0 +1,128 @@
+/******************************************************************************
+ * gomory_hu_test.cpp
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <omp.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "algorithms/flow/gomory_hu_tree.h"
+#include "algorithms/flow/push_relabel.h"
+#include "algorithms/global_mincut/noi_minimum_cut.h"
+#include "common/definitions.h"
+#include "data_structure/mutable_graph.h"
+#include "gtest/gtest.h"
+using namespace VieCut;
+
+static mutableGraphPtr randomGraph(NodeID n, EdgeID m, size_t seed) {
+    std::mt19937 eng(seed);
+    std::uniform_int_distribution<NodeID> vtx(0, n - 1);
+    std::uniform_int_distribution<EdgeWeight> wgt(1, 10);
+
+    mutableGraphPtr G = std::make_shared<mutable_graph>();
+    G->start_construction(n);
+    for (EdgeID i = 0; i < m; ++i) {
+        NodeID s = vtx(eng);
+        NodeID t = vtx(eng);
+        if (s != t) {
+            G->new_edge_order(s, t, wgt(eng));
+        }
+    }
+    G->finish_construction();
+    return G;
+}
+
+TEST(GomoryHuTest, SingleVertex) {
+    mutableGraphPtr G = std::make_shared<mutable_graph>();
+    G->start_construction(1);
+    G->finish_construction();
+
+    gomory_hu_tree gh;
+    gh.build(G);
+    ASSERT_EQ(gh.getFlows(), 0);
+    ASSERT_EQ(gh.connectivity(0, 0), UNDEFINED_FLOW);
+    ASSERT_EQ(gh.getTree()->number_of_edges(), 0);
+}
+
+TEST(GomoryHuTest, PairwiseConnectivityMatchesMaxFlow) {
+    for (size_t seed = 0; seed < 10; ++seed) {
+        mutableGraphPtr G = randomGraph(30, 80, seed);
+        gomory_hu_tree gh;
+        gh.build(G);
+        ASSERT_EQ(gh.getTree()->number_of_edges(), 2 * (G->n() - 1));
+
+        for (NodeID u = 0; u < G->n(); ++u) {
+            for (NodeID v = u + 1; v < G->n(); ++v) {
+                push_relabel pr;
+                std::vector<NodeID> terminals = { u, v };
+                FlowType f = pr.solve_max_flow_min_cut(
+                    G, terminals, 0, false).first;
+                ASSERT_EQ(gh.connectivity(u, v), f);
+                ASSERT_EQ(gh.connectivity(v, u), f);
+            }
+        }
+    }
+}
+
+TEST(GomoryHuTest, MinimumCutMatchesNoi) {
+    for (size_t seed = 0; seed < 20; ++seed) {
+        mutableGraphPtr G = randomGraph(100, 400, seed);
+        gomory_hu_tree gh;
+        gh.build(G);
+
+        noi_minimum_cut<mutableGraphPtr> noi;
+        EdgeWeight cut = noi.perform_minimum_cut(G);
+        ASSERT_EQ(gh.minimumCut(), static_cast<FlowType>(cut));
+    }
+}
+
+TEST(GomoryHuTest, DisconnectedGraph) {
+    // two triangles
+    mutableGraphPtr G = std::make_shared<mutable_graph>();
+    G->start_construction(6);
+    G->new_edge_order(0, 1, 2);
+    G->new_edge_order(1, 2, 2);
+    G->new_edge_order(0, 2, 3);
+    G->new_edge_order(3, 4, 1);
+    G->new_edge_order(4, 5, 1);
+    G->new_edge_order(3, 5, 1);
+    G->finish_construction();
+
+    gomory_hu_tree gh;
+    gh.build(G);
+    ASSERT_EQ(gh.connectivity(0, 1), 4);
+    ASSERT_EQ(gh.connectivity(0, 2), 5);
+    ASSERT_EQ(gh.connectivity(3, 5), 2);
+    ASSERT_EQ(gh.connectivity(1, 4), 0);
+    ASSERT_EQ(gh.minimumCut(), 0);
+}
+
+TEST(GomoryHuTest, ParallelEqualsSequential) {
+    mutableGraphPtr G = randomGraph(300, 1500, 7);
+    int threads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    gomory_hu_tree seq;
+    seq.build(G);
+    ASSERT_EQ(seq.getRecomputed(), 0);
+
+    omp_set_num_threads(std::max(threads, 4));
+    gomory_hu_tree par;
+    par.build(G);
+    omp_set_num_threads(threads);
+
+    for (NodeID v : G->nodes()) {
+        ASSERT_EQ(par.getParent(v), seq.getParent(v));
+        ASSERT_EQ(par.getParentWeight(v), seq.getParentWeight(v));
+    }
+    ASSERT_EQ(par.getFlows(), seq.getFlows() + par.getRecomputed());
+}
@@ -13,16 +13,35 @@
 #include <stddef.h>
 
 #include <algorithm>
+#include <cstdio>
+#include <limits>
 #include <memory>
+#include <numeric>
 #include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#include "algorithms/misc/find_articulation_points.h"
+#include "algorithms/misc/find_bridges.h"
+#include "algorithms/multicut/flow_solver_pool.h"
+#include "algorithms/multicut/kernelization_criteria.h"
+#include "algorithms/multicut/local_search.h"
+#include "algorithms/multicut/mpi_communication.h"
 #include "algorithms/multicut/multiterminal_cut.h"
+#include "algorithms/multicut/problem_checkpoint.h"
+#include "algorithms/multicut/problem_queues/per_thread_problem_queue.h"
+#include "algorithms/multicut/problem_queues/spilling_problem_queue.h"
+#include "algorithms/multicut/problem_queues/work_stealing_problem_queue.h"
 #include "common/configuration.h"
 #include "common/definitions.h"
 #include "data_structure/graph_access.h"
 #include "data_structure/mutable_graph.h"
 #include "gtest/gtest.h"
+#include "tools/random_functions.h"
+#include "tools/timer.h"
 using namespace VieCut;
 
 class MultiterminalCutTest : public ::testing::Test {
@@ -34,6 +53,101 @@ class MultiterminalCutTest : public ::testing::Test {
     static void TearDownTestCase() {
         MPI_Finalize();
     }
+
+ protected:
+    // random connected graph and terminals that are spread evenly over it
+    struct random_instance {
+        // multicut modifies the graph, so every run needs a new one
+        mutableGraphPtr graph() const {
+            auto G = std::make_shared<mutable_graph>();
+            G->start_construction(n);
+            for (auto [u, v, w] : edges) {
+                G->new_edge_order(u, v, w);
+            }
+            G->finish_construction();
+            return G;
+        }
+
+        NodeID n;
+        std::vector<std::tuple<NodeID, NodeID, EdgeWeight> > edges;
+        std::vector<NodeID> terminals;
+    };
+
+    // a random spanning tree and 4n further edges with weights from 1 to
+    // max_weight, with k terminals
+    static random_instance randomInstance(std::mt19937* eng, NodeID n,
+                                          NodeID k, EdgeWeight max_weight) {
+        random_instance instance;
+        instance.n = n;
+        std::uniform_int_distribution<NodeID> vtx(0, n - 1);
+        for (NodeID v = 1; v < n; ++v) {
+            instance.edges.emplace_back(v, vtx(*eng) % v,
+                                        1 + vtx(*eng) % max_weight);
+        }
+        for (size_t e = 0; e < 4 * n; ++e) {
+            instance.edges.emplace_back(vtx(*eng), vtx(*eng),
+                                        1 + vtx(*eng) % max_weight);
+        }
+        instance.terminals.resize(n, UNDEFINED_NODE);
+        for (NodeID i = 0; i < k; ++i) {
+            instance.terminals[i * (n / k)] = i;
+        }
+        return instance;
+    }
+
+    // tests change the configuration, it is restored after every test,
+    // also after a failed one
+    void SetUp() {
+        auto cfg = configuration::getConfig();
+        queue_type = cfg->queue_type;
+        local_search_algorithm = cfg->local_search_algorithm;
+        checkpoint_file = cfg->checkpoint_file;
+        threads = cfg->threads;
+        num_terminals = cfg->num_terminals;
+        timeout = cfg->timeoutSeconds;
+        checkpoint_interval = cfg->checkpoint_interval;
+        resume = cfg->resume;
+        memory_budget = cfg->memory_budget;
+        disable_cpu_affinity = cfg->disable_cpu_affinity;
+        random_flows = cfg->random_flows;
+        high_distance_flows = cfg->high_distance_flows;
+    }
+
+    void TearDown() {
+        auto cfg = configuration::getConfig();
+        if (!cfg->checkpoint_file.empty()) {
+            std::string file = problem_checkpoint::fileName(
+                cfg->checkpoint_file, 0, 0);
+            std::remove(file.c_str());
+            std::remove((file + ".tmp").c_str());
+        }
+        cfg->queue_type = queue_type;
+        cfg->local_search_algorithm = local_search_algorithm;
+        cfg->checkpoint_file = checkpoint_file;
+        cfg->threads = threads;
+        cfg->num_terminals = num_terminals;
+        cfg->timeoutSeconds = timeout;
+        cfg->checkpoint_interval = checkpoint_interval;
+        cfg->resume = resume;
+        cfg->memory_budget = memory_budget;
+        cfg->disable_cpu_affinity = disable_cpu_affinity;
+        cfg->random_flows = random_flows;
+        cfg->high_distance_flows = high_distance_flows;
+    }
+
+ private:
+    std::string queue_type;
+    std::string local_search_algorithm;
+    std::string checkpoint_file;
+    size_t threads;
+    size_t num_terminals;
+    size_t timeout;
+    double checkpoint_interval;
+    bool resume;
+    size_t memory_budget;
+    bool disable_cpu_affinity;
+    size_t random_flows;
+    size_t high_distance_flows;
 };
 
 TEST_F(MultiterminalCutTest, FourClusters) {
@@ -255,3 +369,639 @@ TEST_F(MultiterminalCutTest, PartiallyDisconnected) {
         ASSERT_EQ(f, (FlowType)2);
     }
 }
+
+TEST_F(MultiterminalCutTest, FlattenedMappings) {
+    // solution extraction time with mapping chains of different depth,
+    // each level is a random permutation of the vertices
+    NodeID n = 100000;
+    std::mt19937 eng(1);
+    for (size_t depth : { 1, 4, 16, 32 }) {
+        multicut_problem chain;
+        multicut_problem flat;
+        for (size_t d = 0; d < depth; ++d) {
+            auto map = std::make_shared<std::vector<NodeID> >(n);
+            std::iota(map->begin(), map->end(), 0);
+            std::shuffle(map->begin(), map->end(), eng);
+            chain.addMapping(map, 0);
+            flat.addMapping(map, 4);
+            ASSERT_LE(flat.mappings.size(), 4);
+        }
+        ASSERT_EQ(chain.mappings.size(), depth);
+
+        timer t;
+        NodeID sum_chain = 0;
+        for (NodeID v = 0; v < n; ++v) {
+            sum_chain += chain.mapped(v);
+        }
+        double time_chain = t.elapsedToZero();
+
+        flat.flattenMappings();
+        ASSERT_EQ(flat.mappings.size(), 1);
+        t.restart();
+        NodeID sum_flat = 0;
+        for (NodeID v = 0; v < n; ++v) {
+            sum_flat += flat.mapped(v);
+        }
+        double time_flat = t.elapsed();
+        ASSERT_EQ(sum_chain, sum_flat);
+        for (NodeID v = 0; v < n; ++v) {
+            ASSERT_EQ(flat.mapped(v), chain.mapped(v));
+        }
+        LOG1 << "depth " << depth << ": chain " << time_chain
+             << "s flat " << time_flat << "s";
+    }
+}
+
+TEST_F(MultiterminalCutTest, WorkStealingQueue) {
+    // problems in the deque that are dominated by a better upper bound are
+    // removed by the owner and no longer counted
+    std::mt19937 eng(42);
+    {
+        std::vector<problemPointer> problems;
+        for (size_t i = 0; i < 40; ++i) {
+            auto p = std::make_shared<multicut_problem>();
+            p->lower_bound = i;
+            problems.emplace_back(p);
+        }
+        std::shuffle(problems.begin(), problems.end(), eng);
+        work_stealing_problem_queue queue(1, "lower_bound");
+        for (auto p : problems) {
+            queue.addProblem(p, 0, true);
+        }
+        size_t bytes = problem_queue::problemBytes(problems[0]);
+        ASSERT_EQ(queue.bytes(), 40 * bytes);
+
+        queue.prepareQueue(0, 10);
+        ASSERT_EQ(queue.size(), 10);
+        ASSERT_EQ(queue.bytes(), 10 * bytes);
+        std::vector<FlowType> lower_bounds;
+        for (auto p : queue.allProblems()) {
+            lower_bounds.emplace_back(p->lower_bound);
+        }
+        std::sort(lower_bounds.begin(), lower_bounds.end());
+        std::vector<FlowType> expected(10);
+        std::iota(expected.begin(), expected.end(), 0);
+        ASSERT_EQ(lower_bounds, expected);
+        while (queue.pullProblem(0, false).has_value()) { }
+        ASSERT_TRUE(queue.all_empty());
+        ASSERT_FALSE(queue.haveASendProblem());
+    }
+
+    // work stealing with several threads has to find the same optimum as
+    // the default queue with a single thread
+    auto cfg = configuration::getConfig();
+    cfg->disable_cpu_affinity = true;
+
+    for (size_t run = 0; run < 3; ++run) {
+        auto instance = randomInstance(&eng, 300, 5, 3);
+
+        cfg->queue_type = "bound_sum";
+        cfg->threads = 1;
+        multiterminal_cut mct;
+        FlowType expected = mct.multicut(instance.graph(),
+                                         instance.terminals, 5);
+
+        for (std::string type : { "work_stealing",
+                                  "work_stealing_lower_bound" }) {
+            cfg->queue_type = type;
+            cfg->threads = 4;
+            multiterminal_cut mct_ws;
+            FlowType f = mct_ws.multicut(instance.graph(),
+                                         instance.terminals, 5);
+            ASSERT_EQ(f, expected);
+        }
+    }
+}
+
+TEST_F(MultiterminalCutTest, ParallelKernelization) {
+    // the low and high degree reductions scan the vertices in parallel at
+    // the root, the contraction has to be the same as the sequential one.
+    // the flows of the flow reduction are picked differently in parallel,
+    // so they are disabled
+    auto cfg = configuration::getConfig();
+    cfg->disable_cpu_affinity = true;
+    cfg->threads = 4;
+    cfg->random_flows = 0;
+    cfg->high_distance_flows = 0;
+
+    std::mt19937 eng(23);
+    for (size_t run = 0; run < 3; ++run) {
+        // random spanning tree and n / 2 further edges, so there are many
+        // vertices of low degree
+        NodeID n = 3000;
+        std::uniform_int_distribution<NodeID> vtx(0, n - 1);
+        std::vector<std::tuple<NodeID, NodeID, EdgeWeight> > edges;
+        size_t total_weight = 0;
+        for (NodeID v = 1; v < n; ++v) {
+            edges.emplace_back(v, vtx(eng) % v, 1 + vtx(eng) % 20);
+        }
+        for (NodeID e = 0; e < n / 2; ++e) {
+            edges.emplace_back(vtx(eng), vtx(eng), 1 + vtx(eng) % 20);
+        }
+        for (auto [u, v, w] : edges) {
+            total_weight += w;
+        }
+        std::vector<NodeID> terminals = { 0, 750, 1500, 2250 };
+        std::vector<terminal> problem_terminals;
+        for (NodeID t = 0; t < terminals.size(); ++t) {
+            problem_terminals.emplace_back(terminals[t], t);
+        }
+
+        std::vector<problemPointer> problems;
+        for (bool parallel : { false, true }) {
+            random_functions::setSeed(run);
+            auto G = std::make_shared<mutable_graph>();
+            G->start_construction(n);
+            for (auto [u, v, w] : edges) {
+                G->new_edge_order(u, v, w);
+            }
+            G->finish_construction();
+            auto problem = std::make_shared<multicut_problem>(
+                G, problem_terminals);
+            kernelization_criteria kc(terminals);
+            kc.kernelization(problem, total_weight, parallel, 0);
+            problems.emplace_back(problem);
+        }
+
+        auto seq = problems[0];
+        auto par = problems[1];
+        ASSERT_LT(seq->graph->n(), n / 2);
+        ASSERT_EQ(par->graph->n(), seq->graph->n());
+        ASSERT_EQ(par->graph->m(), seq->graph->m());
+        ASSERT_EQ(par->deleted_weight, seq->deleted_weight);
+        for (NodeID v = 0; v < n; ++v) {
+            ASSERT_EQ(par->graph->getCurrentPosition(par->mapped(v)),
+                      seq->graph->getCurrentPosition(seq->mapped(v)));
+        }
+    }
+}
+
+namespace {
+// chain of dense clusters, consecutive clusters are joined by a single
+// edge, so every joining edge is a bridge and its endpoints are
+// articulation points. every second cluster contains a terminal
+std::pair<mutableGraphPtr, std::vector<terminal> > clusterChain(
+    std::mt19937* eng, NodeID clusters, NodeID size) {
+    auto G = std::make_shared<mutable_graph>();
+    G->start_construction(clusters * size);
+    std::uniform_int_distribution<NodeID> vtx(0, size - 1);
+    std::vector<terminal> terminals;
+    for (NodeID c = 0; c < clusters; ++c) {
+        NodeID first = c * size;
+        for (NodeID v = 1; v < size; ++v) {
+            G->new_edge_order(first + v, first + vtx(*eng) % v, 1);
+        }
+        for (NodeID e = 0; e < 2 * size; ++e) {
+            G->new_edge_order(first + vtx(*eng), first + vtx(*eng), 1);
+        }
+        if (c > 0) {
+            G->new_edge_order(first - 1 - vtx(*eng), first + vtx(*eng), 1);
+        }
+        if (c % 2 == 0) {
+            terminals.emplace_back(first + vtx(*eng), terminals.size());
+        }
+    }
+    G->finish_construction();
+    return std::make_pair(G, terminals);
+}
+}  // namespace
+
+TEST_F(MultiterminalCutTest, ReuseArticulationPoints) {
+    // one object is reset to graphs of different sizes and has to find
+    // the same as a new object for every graph
+    std::mt19937 eng(5);
+    auto large = clusterChain(&eng, 10, 30);
+    auto small = clusterChain(&eng, 4, 15);
+
+    find_articulation_points reused;
+    for (auto [G, terminals] : { large, small, large }) {
+        reused.reset(G);
+        find_articulation_points fresh(G);
+        ASSERT_TRUE(fresh.findAllArticulationPoints());
+        ASSERT_TRUE(reused.findAllArticulationPoints());
+
+        auto uf_fresh = fresh.terminalsOnBothSides(terminals);
+        auto uf_reused = reused.terminalsOnBothSides(terminals);
+        ASSERT_TRUE(uf_fresh.has_value());
+        ASSERT_TRUE(uf_reused.has_value());
+        ASSERT_LT(uf_fresh->n(), G->n());
+        ASSERT_EQ(uf_reused->n(), uf_fresh->n());
+        for (NodeID v : G->nodes()) {
+            ASSERT_EQ(uf_reused->Find(v), uf_fresh->Find(v));
+        }
+    }
+}
+
+TEST_F(MultiterminalCutTest, ReuseBridges) {
+    std::mt19937 eng(6);
+    auto large = clusterChain(&eng, 10, 30);
+    auto small = clusterChain(&eng, 4, 15);
+
+    find_bridges reused;
+    for (auto [G, terminals] : { large, small, large }) {
+        reused.reset(G);
+        find_bridges fresh(G);
+        ASSERT_TRUE(fresh.findAllBridges());
+        ASSERT_TRUE(reused.findAllBridges());
+
+        auto res_fresh = fresh.terminalsOnBothSides(terminals);
+        auto res_reused = reused.terminalsOnBothSides(terminals);
+        ASSERT_EQ(res_reused.index(), res_fresh.index());
+        if (std::holds_alternative<union_find>(res_fresh)) {
+            auto& uf_fresh = std::get<union_find>(res_fresh);
+            auto& uf_reused = std::get<union_find>(res_reused);
+            ASSERT_EQ(uf_reused.n(), uf_fresh.n());
+            for (NodeID v : G->nodes()) {
+                ASSERT_EQ(uf_reused.Find(v), uf_fresh.Find(v));
+            }
+        } else {
+            ASSERT_EQ(std::get<1>(res_reused), std::get<1>(res_fresh));
+        }
+    }
+}
+
+TEST_F(MultiterminalCutTest, ProblemEncoding) {
+    std::mt19937 eng(7);
+    NodeID n = 1000;
+    std::uniform_int_distribution<NodeID> vtx(0, n - 1);
+    auto G = std::make_shared<mutable_graph>();
+    G->start_construction(n);
+    for (size_t i = 0; i < 4 * n; ++i) {
+        G->new_edge_order(vtx(eng), vtx(eng), 1 + vtx(eng) % 10);
+    }
+    G->finish_construction();
+
+    auto problem = std::make_shared<multicut_problem>(G);
+    problem->lower_bound = -1;
+    problem->upper_bound = std::numeric_limits<FlowType>::max();
+    problem->deleted_weight = 1234;
+    for (NodeID t = 0; t < 5; ++t) {
+        problem->terminals.emplace_back(t * 100, t);
+    }
+    for (size_t d = 0; d < 3; ++d) {
+        auto map = std::make_shared<std::vector<NodeID> >(n);
+        std::iota(map->begin(), map->end(), 0);
+        std::shuffle(map->begin(), map->end(), eng);
+        problem->mappings.emplace_back(map);
+    }
+
+    auto data = mpi_communication::encodeProblem(problem);
+    ASSERT_LT(data.size(), mpi_communication::legacySize(problem) / 4);
+    auto decoded = mpi_communication::decodeProblem(data);
+    ASSERT_NE(decoded, nullptr);
+
+    ASSERT_EQ(decoded->lower_bound, problem->lower_bound);
+    ASSERT_EQ(decoded->upper_bound, problem->upper_bound);
+    ASSERT_EQ(decoded->deleted_weight, problem->deleted_weight);
+    ASSERT_EQ(decoded->terminals.size(), problem->terminals.size());
+    for (size_t i = 0; i < problem->terminals.size(); ++i) {
+        ASSERT_EQ(decoded->terminals[i].position,
+                  problem->terminals[i].position);
+        ASSERT_EQ(decoded->terminals[i].original_id,
+                  problem->terminals[i].original_id);
+    }
+    // mapping chain is sent as a single composed mapping
+    ASSERT_EQ(decoded->mappings.size(), 1);
+    for (NodeID v = 0; v < n; ++v) {
+        ASSERT_EQ(decoded->mapped(v), problem->mapped(v));
+    }
+    ASSERT_EQ(decoded->graph->n(), G->n());
+    ASSERT_EQ(decoded->graph->m(), G->m());
+    for (NodeID v : G->nodes()) {
+        ASSERT_EQ(decoded->graph->getWeightedNodeDegree(v),
+                  G->getWeightedNodeDegree(v));
+    }
+
+    data.resize(data.size() / 2);
+    ASSERT_EQ(mpi_communication::decodeProblem(data), nullptr);
+}
+
+TEST_F(MultiterminalCutTest, LocalSearch) {
+    // four dense clusters with a random initial solution. the local
+    // searches have to report the decrease of the cut weight and must not
+    // move the fixed terminals
+    auto cfg = configuration::getConfig();
+    cfg->num_terminals = 4;
+
+    std::mt19937 eng(3);
+    NodeID cluster_size = 200;
+    NodeID n = 4 * cluster_size;
+    std::uniform_int_distribution<NodeID> vtx(0, cluster_size - 1);
+    std::uniform_int_distribution<NodeID> block(0, 3);
+    auto G = std::make_shared<mutable_graph>();
+    G->start_construction(n);
+    for (NodeID c = 0; c < 4; ++c) {
+        for (size_t e = 0; e < 10 * cluster_size; ++e) {
+            G->new_edge_order(c * cluster_size + vtx(eng),
+                              c * cluster_size + vtx(eng), 1 + vtx(eng) % 3);
+        }
+        G->new_edge_order(c * cluster_size + vtx(eng),
+                          ((c + 1) % 4) * cluster_size + vtx(eng), 1);
+    }
+    G->finish_construction();
+
+    std::vector<NodeID> terminals;
+    std::vector<bool> fixed_vertex(n, false);
+    std::vector<NodeID> initial_solution(n);
+    for (NodeID v = 0; v < n; ++v) {
+        initial_solution[v] = block(eng);
+    }
+    for (NodeID c = 0; c < 4; ++c) {
+        terminals.emplace_back(c * cluster_size);
+        fixed_vertex[c * cluster_size] = true;
+        initial_solution[c * cluster_size] = c;
+    }
+
+    auto cutWeight = [&G](const std::vector<NodeID>& solution) {
+                         FlowType cut = 0;
+                         for (NodeID v : G->nodes()) {
+                             for (EdgeID e : G->edges_of(v)) {
+                                 auto [t, w] = G->getEdge(v, e);
+                                 if (v < t && solution[v] != solution[t])
+                                     cut += w;
+                             }
+                         }
+                         return cut;
+                     };
+    FlowType initial_cut = cutWeight(initial_solution);
+
+    for (std::string algorithm : { "fm", "parallel_fm", "gain" }) {
+        cfg->local_search_algorithm = algorithm;
+        std::vector<NodeID> solution = initial_solution;
+        timer t;
+        local_search ls(*G, terminals, fixed_vertex, &solution);
+        FlowType improvement = ls.improveSolution(t);
+        ASSERT_GT(improvement, 0);
+        if (algorithm == "gain") {
+            // the double moves of the gain local search use outdated gains
+            // and may underestimate the improvement
+            ASSERT_LE(cutWeight(solution), initial_cut - improvement);
+        } else {
+            ASSERT_EQ(cutWeight(solution), initial_cut - improvement);
+        }
+        for (NodeID c = 0; c < 4; ++c) {
+            ASSERT_EQ(solution[terminals[c]], c);
+        }
+    }
+}
+
+TEST_F(MultiterminalCutTest, FlowSolverPool) {
+    // isolating cuts computed by the pool are the same as sequential ones,
+    // for every flow algorithm
+    std::mt19937 eng(11);
+    auto G = randomInstance(&eng, 500, 5, 5).graph();
+    std::vector<NodeID> terminals = { 0, 100, 200, 300, 400 };
+
+    flow_solver_pool pool(3);
+    for (size_t round = 0; round < 3; ++round) {
+        std::string algorithm = (round == 1) ? "boykov_kolmogorov"
+                                             : "push_relabel";
+        std::vector<flow_solver_pool::flow_job> jobs;
+        for (NodeID i = 0; i < terminals.size(); ++i) {
+            jobs.push_back({ G, terminals, i, { } });
+        }
+        flow_statistics stats;
+        pool.run(&jobs, algorithm, &stats);
+        ASSERT_EQ(stats.flows, terminals.size());
+        if (algorithm == "boykov_kolmogorov") {
+            ASSERT_GT(stats.augmentations, 0);
+            ASSERT_EQ(stats.pushes, 0);
+        } else {
+            ASSERT_GT(stats.pushes, 0);
+        }
+
+        for (NodeID i = 0; i < terminals.size(); ++i) {
+            push_relabel<false, true> pr;
+            auto expected = pr.callable_max_flow(G, terminals, i, true);
+            auto source_set = jobs[i].source_set;
+            std::sort(expected.begin(), expected.end());
+            std::sort(source_set.begin(), source_set.end());
+            ASSERT_EQ(source_set, expected);
+        }
+    }
+}
+
+TEST_F(MultiterminalCutTest, Checkpoint) {
+    problem_checkpoint::checkpoint_data data;
+    data.num_nodes = 5;
+    data.num_terminals = 2;
+    data.upper_bound = 17;
+    data.solution = { 0, 1, 1, 0, 1 };
+    data.problems = { { 1, 2, 3 }, { }, { 200, 0, 7 } };
+    auto encoded = problem_checkpoint::encode(data);
+    problem_checkpoint::checkpoint_data decoded;
+    ASSERT_TRUE(problem_checkpoint::decode(encoded, &decoded));
+    ASSERT_EQ(decoded.num_nodes, data.num_nodes);
+    ASSERT_EQ(decoded.num_terminals, data.num_terminals);
+    ASSERT_EQ(decoded.upper_bound, data.upper_bound);
+    ASSERT_EQ(decoded.solution, data.solution);
+    ASSERT_EQ(decoded.problems, data.problems);
+    encoded.pop_back();
+    ASSERT_FALSE(problem_checkpoint::decode(encoded, &decoded));
+
+    // a run that is checkpointed periodically and times out writes its open
+    // problems to the checkpoint. resuming from it finds the optimum. with a
+    // timeout of 0 seconds, the run stops after the first problem
+    auto cfg = configuration::getConfig();
+    cfg->disable_cpu_affinity = true;
+
+    std::mt19937 eng(43);
+    auto instance = randomInstance(&eng, 100, 6, 10);
+
+    cfg->threads = 1;
+    multiterminal_cut mct;
+    FlowType expected = mct.multicut(instance.graph(), instance.terminals, 6);
+
+    std::string path = ::testing::TempDir() + "multicut_checkpoint";
+    std::string file = problem_checkpoint::fileName(path, 0, 0);
+    cfg->checkpoint_file = path;
+    cfg->checkpoint_interval = 0.1;
+    cfg->threads = 4;
+    size_t timeout = cfg->timeoutSeconds;
+    cfg->timeoutSeconds = 0;
+    multiterminal_cut mct_timeout;
+    FlowType f_timeout = mct_timeout.multicut(instance.graph(),
+                                              instance.terminals, 6);
+    ASSERT_GE(f_timeout, expected);
+    ASSERT_TRUE(problem_checkpoint::read(file, &decoded));
+    ASSERT_EQ(decoded.num_nodes, instance.n);
+    ASSERT_EQ(decoded.upper_bound, f_timeout);
+    ASSERT_GT(decoded.problems.size(), 0);
+
+    cfg->timeoutSeconds = timeout;
+    cfg->resume = true;
+    multiterminal_cut mct_resume;
+    FlowType f = mct_resume.multicut(instance.graph(), instance.terminals, 6);
+    ASSERT_EQ(f, expected);
+}
+
+TEST_F(MultiterminalCutTest, SpillingQueue) {
+    // the queue has room for about ten problems. all problems that are not
+    // pruned have to come back from the scratch file
+    std::mt19937 eng(11);
+    NodeID n = 200;
+    std::uniform_int_distribution<NodeID> vtx(0, n - 1);
+    size_t num_problems = 100;
+    FlowType upper_bound = 80;
+
+    auto randomGraph = [&]() {
+        auto G = std::make_shared<mutable_graph>();
+        G->start_construction(n);
+        for (size_t e = 0; e < 2 * n; ++e) {
+            G->new_edge_order(vtx(eng), vtx(eng), 1);
+        }
+        G->finish_construction();
+        return G;
+    };
+
+    {
+        // lazy siblings count their graph once and are spilled together
+        // with a single copy of it, which they share again when reloaded
+        auto siblings = [&](mutableGraphPtr G, FlowType lower_bound) {
+            std::vector<problemPointer> group;
+            for (NodeID t = 0; t < 4; ++t) {
+                auto p = std::make_shared<multicut_problem>(G);
+                p->lower_bound = lower_bound;
+                p->upper_bound = lower_bound + 10;
+                for (NodeID i = 0; i < 4; ++i) {
+                    p->terminals.emplace_back(i * 50, i);
+                }
+                p->branch_vertex = 1;
+                p->branch_terminal = t * 50;
+                group.emplace_back(p);
+            }
+            return group;
+        };
+        auto first = siblings(randomGraph(), 1);
+        auto second = siblings(randomGraph(), 3);
+        auto owner = siblings(randomGraph(), 2)[0];
+        owner->branch_vertex = UNDEFINED_NODE;
+
+        size_t graph = problem_queue::graphBytes(first[0]->graph);
+        size_t problem = problem_queue::problemBytes(first[0]) - graph;
+        size_t graphs = graph + problem_queue::graphBytes(second[0]->graph);
+        size_t budget = graphs + 12 * problem;
+        spilling_problem_queue queue(
+            std::make_unique<per_thread_problem_queue>(1, "lower_bound"),
+            budget, ::testing::TempDir());
+        for (auto group : { first, second }) {
+            for (auto p : group) {
+                queue.addProblem(p, 0, true);
+            }
+        }
+        ASSERT_EQ(queue.bytes(), graphs + 8 * problem);
+
+        // the problem that owns its graph is spilled first, although the
+        // siblings of the second graph are worse. they are spilled until
+        // their graph is freed
+        queue.addProblem(owner, 0, true);
+        ASSERT_EQ(queue.bytes(), graph + 4 * problem);
+        ASSERT_EQ(queue.size(), 9);
+        auto encoded = queue.encodedProblems();
+        ASSERT_EQ(encoded.size(), 5);
+        for (const auto& data : encoded) {
+            auto p = mpi_communication::decodeProblem(data);
+            ASSERT_NE(p, nullptr);
+            ASSERT_EQ(p->graph->n(), n);
+            ASSERT_EQ(p->isLazy(), p->lower_bound == 3);
+        }
+        second.clear();
+        owner = nullptr;
+
+        std::vector<problemPointer> reloaded;
+        while (auto p = queue.pullProblem(0, false)) {
+            if (p.value()->lower_bound == 3) {
+                reloaded.emplace_back(p.value());
+            }
+        }
+        ASSERT_EQ(reloaded.size(), 4);
+        for (auto p : reloaded) {
+            ASSERT_EQ(p->graph, reloaded[0]->graph);
+            ASSERT_NE(p->graph, first[0]->graph);
+        }
+        ASSERT_EQ(queue.bytes(), 0);
+        ASSERT_TRUE(queue.all_empty());
+    }
+
+    for (std::string type : { "per_thread", "work_stealing" }) {
+        std::vector<problemPointer> problems;
+        for (size_t i = 0; i < num_problems; ++i) {
+            auto p = std::make_shared<multicut_problem>(randomGraph());
+            p->lower_bound = i;
+            p->upper_bound = i + 10;
+            for (NodeID t = 0; t < 4; ++t) {
+                p->terminals.emplace_back(t * 50, t);
+            }
+            problems.emplace_back(p);
+        }
+        std::shuffle(problems.begin(), problems.end(), eng);
+
+        std::unique_ptr<problem_queue> inner;
+        if (type == "per_thread") {
+            inner = std::make_unique<per_thread_problem_queue>(
+                2, "lower_bound");
+        } else {
+            inner = std::make_unique<work_stealing_problem_queue>(
+                2, "lower_bound");
+        }
+        size_t budget = 10 * problem_queue::problemBytes(problems[0]);
+        spilling_problem_queue queue(std::move(inner), budget,
+                                     ::testing::TempDir());
+
+        for (auto p : problems) {
+            queue.addProblem(p, 0, false);
+            ASSERT_LE(queue.bytes(), budget);
+        }
+        ASSERT_EQ(queue.size(), num_problems);
+        problems.clear();
+
+        // checkpoints take the spilled problems without decoding them
+        auto encoded = queue.encodedProblems();
+        ASSERT_GT(encoded.size(), 0);
+        ASSERT_EQ(encoded.size() + queue.allProblems().size(), num_problems);
+        for (const auto& data : encoded) {
+            auto p = mpi_communication::decodeProblem(data);
+            ASSERT_NE(p, nullptr);
+            ASSERT_EQ(p->graph->n(), n);
+        }
+
+        std::vector<FlowType> lower_bounds;
+        while (!queue.all_empty()) {
+            for (size_t thread = 0; thread < 2; ++thread) {
+                queue.prepareQueue(thread, upper_bound);
+                auto p = queue.pullProblem(thread, false);
+                if (p.has_value()) {
+                    ASSERT_EQ(p.value()->graph->n(), n);
+                    ASSERT_EQ(p.value()->terminals.size(), 4);
+                    lower_bounds.emplace_back(p.value()->lower_bound);
+                }
+            }
+        }
+        ASSERT_EQ(queue.bytes(), 0);
+
+        std::sort(lower_bounds.begin(), lower_bounds.end());
+        lower_bounds.erase(std::remove_if(lower_bounds.begin(),
+                                          lower_bounds.end(),
+                                          [upper_bound](FlowType lb) {
+                                              return lb >= upper_bound;
+                                          }),
+                           lower_bounds.end());
+        ASSERT_EQ(lower_bounds.size(), upper_bound);
+        for (FlowType i = 0; i < upper_bound; ++i) {
+            ASSERT_EQ(lower_bounds[i], i);
+        }
+    }
+
+    // a search that spills most of its problems finds the optimum
+    auto cfg = configuration::getConfig();
+    cfg->disable_cpu_affinity = true;
+    auto instance = randomInstance(&eng, 150, 8, 10);
+
+    multiterminal_cut mct;
+    FlowType expected = mct.multicut(instance.graph(), instance.terminals, 8);
+    cfg->memory_budget = 1;
+    multiterminal_cut mct_spill;
+    FlowType f = mct_spill.multicut(instance.graph(), instance.terminals, 8);
+    ASSERT_GT(mct_spill.spilledProblems(), 0);
+    ASSERT_EQ(f, expected);
+}
@@ -11,11 +11,13 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <initializer_list>
 #include <memory>
 #include <random>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/definitions.h"
@@ -420,3 +422,63 @@ TEST(Mutable_Graph_Test, DeserializedContractedEqual) {
         ASSERT_EQ(G.getCurrentPosition(n), G2->getCurrentPosition(n));
     }
 }
+
+TEST(Mutable_Graph_Test, CompactSerializationEqual) {
+    // random weighted graph with some contracted edges
+    std::mt19937 eng(3);
+    NodeID n = 500;
+    std::uniform_int_distribution<NodeID> vtx(0, n - 1);
+    std::uniform_int_distribution<EdgeWeight> wgt(1, 100000);
+    mutable_graph G;
+    G.start_construction(n);
+    for (size_t i = 0; i < 5 * n; ++i) {
+        G.new_edge_order(vtx(eng), vtx(eng), wgt(eng));
+    }
+    G.finish_construction();
+    for (size_t i = 0; i < 50; ++i) {
+        NodeID v = vtx(eng) % G.n();
+        if (G.get_first_invalid_edge(v) > 0) {
+            G.contractEdge(v, 0);
+        }
+    }
+    for (NodeID v : G.nodes()) {
+        G.setPartitionIndex(v, v % 4);
+    }
+
+    std::vector<uint8_t> compact;
+    G.serializeCompact(&compact);
+    size_t pos = 0;
+    auto G2 = mutable_graph::deserializeCompact(compact, &pos);
+    ASSERT_NE(G2, nullptr);
+    ASSERT_EQ(pos, compact.size());
+    ASSERT_LT(compact.size(), G.serialize().size() * sizeof(uint64_t) / 3);
+
+    ASSERT_EQ(G.getOriginalNodes(), G2->getOriginalNodes());
+    ASSERT_EQ(G.n(), G2->n());
+    ASSERT_EQ(G.m(), G2->m());
+    for (NodeID v : G.nodes()) {
+        ASSERT_EQ(G.getWeightedNodeDegree(v), G2->getWeightedNodeDegree(v));
+        ASSERT_EQ(G.getPartitionIndex(v), G2->getPartitionIndex(v));
+        ASSERT_EQ(G.numContainedVertices(v), G2->numContainedVertices(v));
+        // edges are sorted by target in the compact format
+        std::vector<std::pair<NodeID, EdgeWeight> > e1, e2;
+        for (EdgeID e : G.edges_of(v)) {
+            e1.emplace_back(G.getEdge(v, e));
+        }
+        for (EdgeID e : G2->edges_of(v)) {
+            e2.emplace_back(G2->getEdge(v, e));
+        }
+        std::sort(e1.begin(), e1.end());
+        std::sort(e2.begin(), e2.end());
+        ASSERT_EQ(e1, e2);
+    }
+
+    for (NodeID v = 0; v < G.getOriginalNodes(); ++v) {
+        ASSERT_EQ(G.getCurrentPosition(v), G2->getCurrentPosition(v));
+    }
+
+    // truncated input is rejected
+    compact.pop_back();
+    pos = 0;
+    ASSERT_EQ(mutable_graph::deserializeCompact(compact, &pos), nullptr);
+}
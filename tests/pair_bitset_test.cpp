@@ -0,0 +1,124 @@
+/******************************************************************************
+ * pair_bitset_test.cpp
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+
+#include "data_structure/pair_bitset.h"
+#include "gtest/gtest.h"
+
+using namespace VieCut;
+
+TEST(PairBitsetTest, CreateEmpty) {
+    pair_bitset pairs;
+    ASSERT_TRUE(pairs.empty());
+    ASSERT_EQ(pairs.size(), 0);
+    ASSERT_FALSE(pairs.contains(0, 1));
+    pairs.erase(0, 1);
+    ASSERT_TRUE(pairs.empty());
+}
+
+TEST(PairBitsetTest, Unordered) {
+    pair_bitset pairs;
+    pairs.insert(3, 1, 5);
+    ASSERT_TRUE(pairs.contains(1, 3));
+    ASSERT_TRUE(pairs.contains(3, 1));
+    ASSERT_FALSE(pairs.contains(1, 2));
+    ASSERT_FALSE(pairs.contains(0, 3));
+    pairs.insert(1, 3, 5);
+    ASSERT_EQ(pairs.size(), 1);
+    pairs.erase(1, 3);
+    ASSERT_TRUE(pairs.empty());
+}
+
+TEST(PairBitsetTest, AllPairs) {
+    NodeID n = 100;
+    pair_bitset pairs;
+    for (NodeID a = 0; a < n; ++a) {
+        for (NodeID b = a + 1; b < n; ++b) {
+            if ((a + b) % 3 == 0) {
+                pairs.insert(a, b, n);
+            }
+        }
+    }
+
+    size_t num = 0;
+    for (NodeID a = 0; a < n; ++a) {
+        for (NodeID b = 0; b < n; ++b) {
+            if (a != b) {
+                ASSERT_EQ(pairs.contains(a, b), (a + b) % 3 == 0);
+                num += (a < b && (a + b) % 3 == 0);
+            }
+        }
+    }
+    ASSERT_EQ(pairs.size(), num);
+}
+
+TEST(PairBitsetTest, RandomAgainstSet) {
+    NodeID n = 50;
+    std::mt19937 eng(42);
+    std::uniform_int_distribution<NodeID> elem(0, n - 1);
+    pair_bitset pairs;
+    std::set<std::pair<NodeID, NodeID> > expected;
+    for (size_t i = 0; i < 10000; ++i) {
+        NodeID a = elem(eng);
+        NodeID b = elem(eng);
+        if (a == b)
+            continue;
+        auto pair = std::make_pair(std::min(a, b), std::max(a, b));
+        if (eng() % 2 == 0) {
+            pairs.insert(a, b, n);
+            expected.insert(pair);
+        } else {
+            pairs.erase(a, b);
+            expected.erase(pair);
+        }
+        ASSERT_TRUE(pairs.contains(a, b) == (expected.count(pair) > 0));
+    }
+    ASSERT_EQ(pairs.size(), expected.size());
+}
+
+TEST(PairBitsetTest, CopyOnWrite) {
+    pair_bitset parent;
+    parent.insert(0, 1, 4);
+    pair_bitset child1 = parent;
+    pair_bitset child2 = parent;
+
+    child1.insert(2, 3, 4);
+    child2.erase(0, 1);
+
+    ASSERT_TRUE(parent.contains(0, 1));
+    ASSERT_FALSE(parent.contains(2, 3));
+    ASSERT_TRUE(child1.contains(0, 1));
+    ASSERT_TRUE(child1.contains(2, 3));
+    ASSERT_FALSE(child2.contains(0, 1));
+    ASSERT_TRUE(child2.empty());
+}
+
+TEST(PairBitsetTest, ManyElements) {
+    NodeID big = 5000;
+    pair_bitset pairs;
+    pairs.insert(big - 1, big - 2, big);
+    ASSERT_TRUE(pairs.contains(big - 2, big - 1));
+    ASSERT_FALSE(pairs.contains(big - 3, big - 1));
+    ASSERT_FALSE(pairs.contains(0, 1));
+    ASSERT_EQ(pairs.size(), 1);
+
+    // pairs beyond the size given first are still stored
+    pair_bitset grow;
+    grow.insert(0, 1, 2);
+    grow.insert(7, 9, 2);
+    ASSERT_TRUE(grow.contains(0, 1));
+    ASSERT_TRUE(grow.contains(9, 7));
+    ASSERT_EQ(grow.size(), 2);
+}
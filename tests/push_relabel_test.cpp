@@ -11,18 +11,25 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <memory>
 #include <random>
+#include <set>
 #include <string>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "algorithms/flow/active_vertex_set.h"
+#include "algorithms/flow/boykov_kolmogorov.h"
+#include "algorithms/flow/bounded_flow.h"
+#include "algorithms/flow/parallel_push_relabel.h"
 #include "algorithms/flow/push_relabel.h"
 #include "common/definitions.h"
 #include "data_structure/mutable_graph.h"
 #include "gtest/gtest.h"
 #include "io/graph_io.h"
+#include "tools/timer.h"
 #include "tools/vector.h"
 using namespace VieCut;
 
@@ -419,3 +426,345 @@ TEST(PushRelabelTest, ContractSrcBlock) {
     ASSERT_EQ(f5, static_cast<FlowType>(1));
     ASSERT_EQ(src_block5.size(), 7);
 }
+
+static mutableGraphPtr randomFlowGraph(NodeID n, EdgeID m, size_t seed) {
+    std::mt19937 eng(seed);
+    std::uniform_int_distribution<NodeID> vtx(0, n - 1);
+    std::uniform_int_distribution<EdgeWeight> wgt(1, 10);
+
+    mutableGraphPtr G = std::make_shared<mutable_graph>();
+    G->start_construction(n);
+    for (NodeID i = 0; i + 1 < n; ++i) {
+        G->new_edge(i, i + 1, wgt(eng));
+    }
+    for (EdgeID i = 0; i < m; ++i) {
+        NodeID s = vtx(eng);
+        NodeID t = vtx(eng);
+        if (s != t) {
+            G->new_edge_order(s, t, wgt(eng));
+        }
+    }
+    G->finish_construction();
+    return G;
+}
+
+TEST(PushRelabelTest, ParallelPushRelabelMatchesSequential) {
+    for (size_t seed = 0; seed < 20; ++seed) {
+        mutableGraphPtr G = randomFlowGraph(200, 600, seed);
+        std::vector<NodeID> terminals = { 0, 50, 100, 199 };
+
+        for (size_t src_v = 0; src_v < terminals.size(); ++src_v) {
+            push_relabel pr;
+            parallel_push_relabel ppr;
+            auto [f, src_block] =
+                pr.solve_max_flow_min_cut(G, terminals, src_v, true);
+            auto [pf, psrc_block] =
+                ppr.solve_max_flow_min_cut(G, terminals, src_v, true);
+            ASSERT_EQ(pf, f);
+            ASSERT_EQ(psrc_block.size(), src_block.size());
+            ASSERT_EQ(psrc_block[0], terminals[src_v]);
+        }
+
+        std::vector<NodeID> st = { 0, 199 };
+        push_relabel pr;
+        parallel_push_relabel<true, true> lppr;
+        FlowType f = pr.solve_max_flow_min_cut(G, st, 0, false).first;
+        FlowType limit = 5;
+        ASSERT_EQ(lppr.solve_max_flow_min_cut(G, st, 0, false, limit).first,
+                  std::min(f, limit));
+    }
+}
+
+TEST(PushRelabelTest, BucketsMatchHeap) {
+    for (size_t seed = 0; seed < 20; ++seed) {
+        mutableGraphPtr G = randomFlowGraph(200, 600, seed);
+        std::vector<NodeID> terminals = { 0, 50, 100, 199 };
+
+        for (size_t src_v = 0; src_v < terminals.size(); ++src_v) {
+            push_relabel<false, false, highest_label_buckets> bpr;
+            push_relabel<false, false, heap_active_set> hpr;
+            auto [f, src_block] =
+                bpr.solve_max_flow_min_cut(G, terminals, src_v, true);
+            auto [hf, hsrc_block] =
+                hpr.solve_max_flow_min_cut(G, terminals, src_v, true);
+            ASSERT_EQ(hf, f);
+            std::sort(src_block.begin(), src_block.end());
+            std::sort(hsrc_block.begin(), hsrc_block.end());
+            ASSERT_EQ(hsrc_block, src_block);
+        }
+
+        std::vector<NodeID> st = { 0, 199 };
+        push_relabel<true, false, highest_label_buckets> lbpr;
+        push_relabel<true, false, heap_active_set> lhpr;
+        FlowType limit = 5;
+        ASSERT_EQ(lbpr.solve_max_flow_min_cut(G, st, 0, false, limit).first,
+                  lhpr.solve_max_flow_min_cut(G, st, 0, false, limit).first);
+    }
+}
+
+TEST(PushRelabelTest, HighestLabelBuckets) {
+    highest_label_buckets Q;
+    Q.reset(10, 21);
+    Q.block(0);
+    ASSERT_TRUE(Q.contains(0));
+    ASSERT_TRUE(Q.empty());
+
+    Q.insert(3, 5);
+    Q.insert(4, 20);
+    Q.insert(5, 5);
+    Q.insert(6, 0);
+    ASSERT_EQ(Q.size(), 4);
+    ASSERT_TRUE(Q.contains(5));
+    ASSERT_EQ(Q.deleteMax(), 4);
+    Q.insert(7, 7);
+    ASSERT_EQ(Q.deleteMax(), 7);
+    NodeID first = Q.deleteMax();
+    NodeID second = Q.deleteMax();
+    ASSERT_EQ(std::min(first, second), 3);
+    ASSERT_EQ(std::max(first, second), 5);
+    ASSERT_FALSE(Q.contains(3));
+    ASSERT_EQ(Q.deleteMax(), 6);
+    ASSERT_TRUE(Q.empty());
+
+    Q.setCount(5, 1);
+    ASSERT_TRUE(Q.isGap(5));
+    Q.moveLabel(4, 5);
+    ASSERT_FALSE(Q.isGap(5));
+    ASSERT_EQ(Q.count(4), -1);
+
+    Q.reset(10, 21);
+    ASSERT_FALSE(Q.contains(0));
+    ASSERT_EQ(Q.count(5), 0);
+}
+
+TEST(PushRelabelTest, HighestLabelBucketsRandom) {
+    // keys spread over many words of the non-empty bit vector
+    NodeID n = 10000;
+    size_t num_labels = 2 * n + 1;
+    highest_label_buckets Q;
+    Q.reset(n, num_labels);
+    std::vector<size_t> key(n);
+    std::multiset<size_t> keys;
+    std::mt19937 eng(1);
+    std::uniform_int_distribution<NodeID> vtx(0, n - 1);
+    std::uniform_int_distribution<size_t> lbl(0, num_labels - 1);
+
+    for (size_t i = 0; i < 100000; ++i) {
+        NodeID v = vtx(eng);
+        if (!Q.contains(v)) {
+            key[v] = lbl(eng);
+            Q.insert(v, key[v]);
+            keys.insert(key[v]);
+        } else {
+            NodeID max = Q.deleteMax();
+            ASSERT_EQ(key[max], *keys.rbegin());
+            keys.erase(std::prev(keys.end()));
+        }
+        ASSERT_EQ(Q.size(), keys.size());
+    }
+}
+
+TEST(PushRelabelTest, ParallelPushRelabelBenchmark) {
+    mutableGraphPtr G = randomFlowGraph(50000, 250000, 1);
+    std::vector<NodeID> terminals = { 0, 49999 };
+
+    timer t;
+    push_relabel pr;
+    auto [f, src_block] = pr.solve_max_flow_min_cut(G, terminals, 0, true);
+    double time_seq = t.elapsedToZero();
+
+    parallel_push_relabel ppr;
+    auto [pf, psrc_block] = ppr.solve_max_flow_min_cut(G, terminals, 0, true);
+    double time_par = t.elapsed();
+
+    LOG1 << "push_relabel " << time_seq << "s parallel_push_relabel "
+         << time_par << "s with " << omp_get_max_threads() << " threads";
+    ASSERT_EQ(pf, f);
+    ASSERT_EQ(psrc_block.size(), src_block.size());
+}
+
+TEST(PushRelabelTest, ParallelGlobalRelabeling) {
+    // large enough that push_relabel uses parallel global relabeling, with
+    // parallel_flows it always relabels sequentially
+    mutableGraphPtr G = randomFlowGraph(PARALLEL_RELABEL_NODES + 1000,
+                                        500000, 2);
+    std::vector<NodeID> terminals = { 0, 17, PARALLEL_RELABEL_NODES };
+
+    for (size_t src_v = 0; src_v < terminals.size(); ++src_v) {
+        push_relabel<false, false> pr;
+        push_relabel<false, true> pr_seq;
+        auto [f, src_block] =
+            pr.solve_max_flow_min_cut(G, terminals, src_v, true);
+        auto [f_seq, src_block_seq] =
+            pr_seq.solve_max_flow_min_cut(G, terminals, src_v, true);
+        ASSERT_EQ(f, f_seq);
+        ASSERT_EQ(src_block.size(), src_block_seq.size());
+    }
+}
+
+TEST(PushRelabelTest, BoykovKolmogorovMatchesPushRelabel) {
+    for (size_t seed = 0; seed < 20; ++seed) {
+        mutableGraphPtr G = randomFlowGraph(200, 600, seed);
+        std::vector<NodeID> terminals = { 0, 50, 100, 199 };
+
+        // all isolating flows with the same object, which builds the
+        // residual graph only once
+        boykov_kolmogorov bk;
+        for (size_t src_v = 0; src_v < terminals.size(); ++src_v) {
+            push_relabel pr;
+            auto [f, src_block] =
+                pr.solve_max_flow_min_cut(G, terminals, src_v, true);
+            auto [bf, bsrc_block] =
+                bk.solve_max_flow_min_cut(G, terminals, src_v, true, 0, 1);
+            ASSERT_EQ(bf, f);
+            ASSERT_EQ(bsrc_block.size(), src_block.size());
+            ASSERT_EQ(bsrc_block[0], terminals[src_v]);
+
+            for (NodeID n : G->nodes()) {
+                if (std::find(terminals.begin(), terminals.end(), n)
+                    != terminals.end()) {
+                    continue;
+                }
+                FlowType sum = 0;
+                for (EdgeID e : G->edges_of(n)) {
+                    FlowType flow = G->getEdgeFlow(n, e, 1);
+                    ASSERT_LE(flow, static_cast<FlowType>(
+                                  G->getEdgeWeight(n, e)));
+                    sum += flow;
+                }
+                ASSERT_EQ(sum, 0);
+            }
+        }
+        ASSERT_EQ(bk.getGraphBuilds(), 1);
+
+        std::vector<NodeID> st = { 0, 199 };
+        push_relabel pr;
+        boykov_kolmogorov<true> lbk;
+        FlowType f = pr.solve_max_flow_min_cut(G, st, 0, false).first;
+        FlowType limit = 5;
+        ASSERT_EQ(lbk.solve_max_flow_min_cut(G, st, 0, false, limit).first,
+                  std::min(f, limit));
+    }
+}
+
+TEST(PushRelabelTest, BoykovKolmogorovGraphChanges) {
+    // one object while edges of the graph are replaced by edges of other
+    // weights, so n and m stay the same
+    boykov_kolmogorov bk;
+    mutableGraphPtr G = randomFlowGraph(200, 600, 7);
+    std::vector<NodeID> st = { 0, 199 };
+    std::mt19937 eng(7);
+    for (size_t round = 0; round < 10; ++round) {
+        push_relabel pr;
+        FlowType f = pr.solve_max_flow_min_cut(G, st, 0, false).first;
+        ASSERT_EQ(bk.solve_max_flow_min_cut(G, st, 0, false, 0, round + 1)
+                  .first, f);
+
+        for (size_t i = 0; i < 20; ++i) {
+            NodeID v = eng() % G->n();
+            if (G->get_first_invalid_edge(v) == 0)
+                continue;
+            EdgeID e = eng() % G->get_first_invalid_edge(v);
+            NodeID w = G->getEdgeTarget(v, e);
+            G->deleteEdge(v, e);
+            G->new_edge(std::min(v, w), std::max(v, w), 1 + eng() % 50);
+        }
+    }
+    bk.solve_max_flow_min_cut(G, st, 0, false, 0, 11);
+    ASSERT_GT(bk.getGraphBuilds(), 1);
+
+    // only weights change, the residual graph is not built again
+    size_t builds = bk.getGraphBuilds();
+    for (size_t round = 0; round < 5; ++round) {
+        for (EdgeID e : G->edges_of(0)) {
+            G->setEdgeWeight(0, e, G->getEdgeWeight(0, e) + round + 1);
+        }
+        push_relabel pr;
+        FlowType f = pr.solve_max_flow_min_cut(G, st, 0, false).first;
+        ASSERT_EQ(bk.solve_max_flow_min_cut(G, st, 0, false, 0, round + 12)
+                  .first, f);
+    }
+    ASSERT_EQ(bk.getGraphBuilds(), builds);
+}
+
+TEST(PushRelabelTest, BoundedFlowMatchesPushRelabel) {
+    // one object for all queries, so the workspace is reused
+    bounded_flow bf;
+    for (size_t seed = 0; seed < 20; ++seed) {
+        mutableGraphPtr G = randomFlowGraph(200, 600, seed);
+        std::vector<NodeID> terminals = { 0, 50, 100, 199 };
+
+        for (size_t src_v = 0; src_v < terminals.size(); ++src_v) {
+            push_relabel pr;
+            auto [f, src_block] =
+                pr.solve_max_flow_min_cut(G, terminals, src_v, true);
+            auto [bf_flow, bf_block] =
+                bf.solve_max_flow_min_cut(G, terminals, src_v, true, 0,
+                                          100 * seed + src_v + 1);
+            ASSERT_EQ(bf_flow, f);
+            ASSERT_EQ(bf_block.size(), src_block.size());
+            ASSERT_EQ(bf_block[0], terminals[src_v]);
+        }
+
+        std::vector<NodeID> st = { 0, 199 };
+        push_relabel pr;
+        FlowType f = pr.solve_max_flow_min_cut(G, st, 0, false).first;
+        for (FlowType k : { 1, 5, 20 }) {
+            ASSERT_EQ(bf.flowUpTo(G, 0, { 199 }, k, 100 * seed + 10 + k),
+                      std::min(f, k));
+            ASSERT_EQ(bf.connectivityAtLeast(G, 0, { 199 }, k), f >= k);
+        }
+    }
+}
+
+TEST(PushRelabelTest, BoundedFlowWorkDependsOnLimit) {
+    // 0 and 1 are connected by an edge of weight >= 1, a query for
+    // connectivity 1 only needs to look at that edge
+    mutableGraphPtr G = randomFlowGraph(100000, 500000, 3);
+    bounded_flow bf;
+    ASSERT_TRUE(bf.connectivityAtLeast(G, 0, { 1 }, 1));
+    ASSERT_EQ(bf.getAugmentations(), 1);
+    ASSERT_LT(bf.getWork(), 100);
+}
+
+TEST(PushRelabelTest, FlowStatistics) {
+    mutableGraphPtr G = randomFlowGraph(1000, 5000, 5);
+    std::vector<NodeID> terminals = { 0, 1, 2 };
+    flow_statistics sum;
+    for (NodeID i = 0; i < terminals.size(); ++i) {
+        push_relabel pr;
+        auto [f, S] = pr.solve_max_flow_min_cut(G, terminals, i, true);
+        flow_statistics stats = pr.getStatistics();
+        ASSERT_EQ(stats.flows, 1);
+        ASSERT_GE(stats.pushes, stats.actual_pushes);
+        ASSERT_GT(stats.peak_active, 0);
+        ASSERT_GE(stats.global_updates, 1);
+        ASSERT_GE(stats.time_total, stats.time_init);
+        if (f > 0) {
+            ASSERT_GT(stats.actual_pushes, 0);
+        }
+        sum.add(stats);
+    }
+    ASSERT_EQ(sum.flows, terminals.size());
+
+    for (NodeID i = 0; i < terminals.size(); ++i) {
+        parallel_push_relabel ppr;
+        auto [f, S] = ppr.solve_max_flow_min_cut(G, terminals, i, true);
+        flow_statistics stats = ppr.getStatistics();
+        ASSERT_EQ(stats.flows, 1);
+        ASSERT_GT(stats.relabels, 0);
+        ASSERT_GT(stats.peak_active, 0);
+        ASSERT_GE(stats.global_updates, 1);
+        ASSERT_GE(stats.time_total, stats.time_init);
+        if (f > 0) {
+            ASSERT_GT(stats.pushes, 0);
+        }
+        sum.add(stats);
+    }
+    ASSERT_EQ(sum.flows, 2 * terminals.size());
+
+    bounded_flow bf;
+    bf.flowUpTo(G, 0, { 1, 2 }, 0, 1);
+    ASSERT_EQ(bf.getStatistics().flows, 1);
+    ASSERT_EQ(bf.getStatistics().augmentations, bf.getAugmentations());
+}
@@ -0,0 +1,92 @@
+/******************************************************************************
+ * work_stealing_deque_test.cpp
+ *
+ * Source of VieCut.
+ *
+ ******************************************************************************
+ * Copyright (C) 2021 Alexander Noe <alexander.noe@univie.ac.at>
+ *
+ * Published under the MIT license in the LICENSE file.
+ *****************************************************************************/
+
+#include <stddef.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "parallel/data_structure/work_stealing_deque.h"
+using namespace VieCut;
+
+TEST(WorkStealingDequeTest, Empty) {
+    work_stealing_deque<size_t*> deque;
+    ASSERT_TRUE(deque.empty());
+    ASSERT_EQ(deque.take(), nullptr);
+    ASSERT_EQ(deque.steal(), nullptr);
+    ASSERT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDequeTest, TakeAndStealOrder) {
+    // small initial capacity, so that the deque has to grow
+    work_stealing_deque<size_t*> deque(2);
+    std::vector<size_t> items(100);
+    for (size_t i = 0; i < items.size(); ++i) {
+        items[i] = i;
+        deque.push(&items[i]);
+    }
+    ASSERT_EQ(deque.size(), 100);
+
+    // owner takes the newest items, thieves steal the oldest ones
+    for (size_t i = 0; i < 50; ++i) {
+        ASSERT_EQ(*deque.take(), 99 - i);
+        ASSERT_EQ(*deque.steal(), i);
+    }
+    ASSERT_TRUE(deque.empty());
+    ASSERT_EQ(deque.take(), nullptr);
+}
+
+TEST(WorkStealingDequeTest, ConcurrentSteals) {
+    // owner pushes and takes while other threads steal. every item has
+    // to be returned exactly once
+    size_t num_items = 200000;
+    size_t num_thieves = 3;
+    work_stealing_deque<size_t*> deque(4);
+    std::vector<size_t> items(num_items);
+    std::vector<std::atomic<size_t> > seen(num_items);
+    for (size_t i = 0; i < num_items; ++i) {
+        items[i] = i;
+        seen[i] = 0;
+    }
+
+    std::atomic<bool> done = false;
+    std::vector<std::thread> thieves;
+    for (size_t t = 0; t < num_thieves; ++t) {
+        thieves.emplace_back([&]() {
+                while (!done || !deque.empty()) {
+                    size_t* item = deque.steal();
+                    if (item != nullptr) {
+                        seen[*item]++;
+                    }
+                }
+            });
+    }
+
+    for (size_t i = 0; i < num_items; ++i) {
+        deque.push(&items[i]);
+        if (i % 3 == 0) {
+            size_t* item = deque.take();
+            if (item != nullptr) {
+                seen[*item]++;
+            }
+        }
+    }
+    done = true;
+    for (auto& t : thieves) {
+        t.join();
+    }
+
+    for (size_t i = 0; i < num_items; ++i) {
+        ASSERT_EQ(seen[i], 1);
+    }
+}